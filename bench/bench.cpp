@@ -0,0 +1,515 @@
+// Microbenchmarks for the encoder/decoder hot paths.
+//
+// Every kernel runs single-threaded over payloads from 100 B to 10 MB and
+// reports time per operation, throughput, ns per modem symbol and heap
+// allocations per operation. A human-readable table goes to stderr and a
+// JSON report to stdout (or --json=PATH) for diffing between releases.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "AudioModulator.h"
+#include "Compressor.h"
+#include "Console.h"
+#include "ErrorCorrection.h"
+#include "Fountain.h"
+#include "Interleaver.h"
+#include "WavFile.h"
+
+// ---------------------------------------------------------------------------
+// Allocation counting: every operator new in the process goes through here
+
+static std::atomic<uint64_t> allocCount{0};
+static std::atomic<uint64_t> allocBytes{0};
+
+void* operator new(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct Options {
+    double minTime = 0.25;              // Seconds of measurement per case
+    size_t maxBytes = 10 * 1000 * 1000; // Largest payload
+    size_t maxModemBytes = 10 * 1000;   // Largest FSK payload (1323 samples per byte)
+    size_t maxOfdmBytes = 1000 * 1000;
+    std::string filter;
+    std::string jsonPath;
+};
+
+struct Result {
+    std::string kernel;
+    size_t bytes = 0;
+    uint64_t iterations = 0;
+    double nsPerOp = 0.0;
+    double samples = 0.0;               // Audio samples per operation (0 = not a modem kernel)
+    double symbols = 0.0;               // Modem symbols per operation
+    double allocsPerOp = 0.0;
+    double allocBytesPerOp = 0.0;
+};
+
+Options options;
+std::vector<Result> results;
+volatile uint64_t sink;
+
+const size_t SIZES[] = {100, 1000, 10 * 1000, 100 * 1000, 1000 * 1000, 10 * 1000 * 1000};
+
+bool selected(const std::string& kernel) {
+    return options.filter.empty() || kernel.find(options.filter) != std::string::npos;
+}
+
+std::vector<size_t> sizesUpTo(size_t limit) {
+    std::vector<size_t> sizes;
+    for (size_t size : SIZES) {
+        if (size <= limit && size <= options.maxBytes) {
+            sizes.push_back(size);
+        }
+    }
+    return sizes;
+}
+
+// Deterministic incompressible bytes
+std::vector<uint8_t> randomBytes(size_t length, uint32_t seed) {
+    std::vector<uint8_t> data(length);
+    uint32_t x = seed * 2654435761u + 1;
+    for (size_t i = 0; i < length; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = static_cast<uint8_t>(x >> 24);
+    }
+    return data;
+}
+
+// Deterministic log-like text for the compressor
+std::vector<uint8_t> textBytes(size_t length) {
+    static const char* WORDS[] = {"encoder", "decoder", "symbol", "block", "error", "sync",
+                                  "chirp", "frame", "tone", "sample", "ok", "warning", "=", "\n"};
+    std::vector<uint8_t> data;
+    data.reserve(length + 16);
+    uint32_t x = 12345;
+    while (data.size() < length) {
+        x = x * 1103515245u + 12345u;
+        const char* word = WORDS[(x >> 16) % (sizeof(WORDS) / sizeof(WORDS[0]))];
+        data.insert(data.end(), word, word + std::strlen(word));
+        data.push_back(' ');
+    }
+    data.resize(length);
+    return data;
+}
+
+// Run fn until minTime has passed (at least once after a warm-up call)
+template <typename Fn>
+void measure(const std::string& kernel, size_t bytes, double samples, double symbols, Fn fn) {
+    fn();
+
+    uint64_t iterations = 0;
+    uint64_t allocs0 = allocCount.load();
+    uint64_t allocBytes0 = allocBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        iterations++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < options.minTime);
+
+    Result result;
+    result.kernel = kernel;
+    result.bytes = bytes;
+    result.iterations = iterations;
+    result.nsPerOp = elapsed * 1e9 / iterations;
+    result.samples = samples;
+    result.symbols = symbols;
+    result.allocsPerOp = double(allocCount.load() - allocs0) / iterations;
+    result.allocBytesPerOp = double(allocBytes.load() - allocBytes0) / iterations;
+    results.push_back(result);
+
+    fprintf(stderr, "%-22s %10zu B %14.0f ns/op %10.2f MB/s", kernel.c_str(), bytes,
+            result.nsPerOp, bytes * 1e3 / result.nsPerOp);
+    if (samples > 0) {
+        fprintf(stderr, " %9.2f Msamples/s", samples * 1e3 / result.nsPerOp);
+    }
+    if (symbols > 0) {
+        fprintf(stderr, " %9.0f ns/symbol", result.nsPerOp / symbols);
+    }
+    fprintf(stderr, " %8.1f allocs/op\n", result.allocsPerOp);
+}
+
+// ---------------------------------------------------------------------------
+// Kernels
+
+void benchCrc() {
+    if (!selected("crc32")) return;
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        std::vector<uint8_t> data = randomBytes(size, 1);
+        measure("crc32", size, 0, 0, [&] {
+            sink = ErrorCorrection::calculateCRC32(data);
+        });
+    }
+}
+
+void benchReedSolomon() {
+    ErrorCorrection ecc;
+    ecc.setNumThreads(1);
+
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        std::vector<uint8_t> data = randomBytes(size, 2);
+        std::vector<uint8_t> encoded = ecc.encode(data);
+
+        if (selected("rs_encode")) {
+            measure("rs_encode", size, 0, 0, [&] {
+                sink = ecc.encode(data).size();
+            });
+        }
+        if (selected("rs_decode_clean")) {
+            measure("rs_decode_clean", size, 0, 0, [&] {
+                sink = ecc.decode(encoded).size();
+            });
+        }
+        if (selected("rs_decode_errors")) {
+            // 8 symbol errors per codeword, half the correction capacity
+            std::vector<uint8_t> corrupted = encoded;
+            for (size_t block = 0; block < corrupted.size(); block += ErrorCorrection::ENCODED_BLOCK_SIZE) {
+                size_t length = std::min<size_t>(ErrorCorrection::ENCODED_BLOCK_SIZE, corrupted.size() - block);
+                for (size_t k = 0; k < 8; k++) {
+                    corrupted[block + (k * 31 + 7) % length] ^= 0x5A;
+                }
+            }
+            measure("rs_decode_errors", size, 0, 0, [&] {
+                sink = ecc.decode(corrupted).size();
+            });
+        }
+    }
+}
+
+void benchInterleaver() {
+    if (!selected("interleave")) return;
+    Interleaver interleaver(8, ErrorCorrection::ENCODED_BLOCK_SIZE);
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        std::vector<uint8_t> data = randomBytes(size, 3);
+        std::vector<uint8_t> out(size);
+        measure("interleave", size, 0, 0, [&] {
+            interleaver.interleave(data.data(), data.size(), out.data());
+            sink = out[0];
+        });
+    }
+}
+
+void benchFountain() {
+    const size_t symbolSize = 207;      // A frame's payload
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        std::vector<uint8_t> data = randomBytes(size, 8);
+        Fountain encoder(size, symbolSize);
+        const uint32_t K = encoder.getSourceSymbols();
+        std::vector<uint8_t> symbol(symbolSize);
+
+        if (selected("fountain_encode")) {
+            // Precode, then as many repair symbols as source symbols
+            measure("fountain_encode", size, 0, 0, [&] {
+                encoder.setSource(data.data());
+                for (uint32_t esi = K; esi < 2 * K; esi++) {
+                    encoder.encodeSymbol(esi, symbol.data());
+                }
+                sink = symbol[0];
+            });
+        }
+        if (selected("fountain_decode")) {
+            // K + 10 symbols: every third source symbol lost, repair symbols in their place
+            encoder.setSource(data.data());
+            Fountain decoder(size, symbolSize);
+            for (uint32_t esi = 0; decoder.getReceived() < K + 10; esi++) {
+                if (esi < K && esi % 3 == 0) {
+                    continue;
+                }
+                encoder.encodeSymbol(esi, symbol.data());
+                decoder.addSymbol(esi, symbol.data());
+            }
+            std::vector<uint8_t> out;
+            measure("fountain_decode", size, 0, 0, [&] {
+                sink = decoder.decode(out);
+            });
+        }
+    }
+}
+
+void benchCompressor() {
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        std::vector<uint8_t> text = textBytes(size);
+        std::vector<uint8_t> packed = Compressor::compress(text.data(), text.size());
+
+        if (selected("compress")) {
+            measure("compress", size, 0, 0, [&] {
+                sink = Compressor::compress(text.data(), text.size()).size();
+            });
+        }
+        if (selected("decompress")) {
+            std::vector<uint8_t> out;
+            measure("decompress", size, 0, 0, [&] {
+                sink = Compressor::decompress(packed.data(), packed.size(), size, out);
+            });
+        }
+    }
+}
+
+void benchModem(AudioModulator::Modulation modulation, size_t limit) {
+    const bool ofdm = modulation == AudioModulator::MOD_OFDM;
+    const std::string suffix = ofdm ? "_ofdm" : "_fsk";
+    const int bytesPerSymbol = AudioModulator::symbolBytes(modulation);
+
+    AudioModulator modulator;
+    modulator.setNumThreads(1);
+    modulator.setModulation(modulation);
+    const long symbolLength = modulator.symbolSamples(modulation);
+
+    for (size_t size : sizesUpTo(limit)) {
+        std::vector<uint8_t> data = randomBytes(size, 4);
+        const double symbols = double((size + bytesPerSymbol - 1) / bytesPerSymbol);
+        std::vector<float> signal = modulator.modulate(data);
+
+        if (selected("modulate" + suffix)) {
+            measure("modulate" + suffix, size, (double)signal.size(), symbols, [&] {
+                sink = modulator.modulate(data).size();
+            });
+        }
+
+        // Symbol synthesis alone, into a preallocated buffer
+        if (selected("write_symbols" + suffix)) {
+            std::vector<float> out(modulator.maxSymbolSamples(size));
+            measure("write_symbols" + suffix, size, symbols * symbolLength, symbols, [&] {
+                float* end = modulator.writeSymbols(data.data(), data.size(), out.data());
+                end = modulator.flushSymbols(end);
+                sink = end - out.data();
+            });
+        }
+
+        if (selected("demodulate" + suffix)) {
+            measure("demodulate" + suffix, size, (double)signal.size(), symbols, [&] {
+                sink = modulator.demodulate(signal).size();
+            });
+        }
+
+        // Per-symbol tone detection (FFT kernels and the Goertzel reference)
+        long sync = modulator.findSync(signal, 0);
+        AudioModulator::StreamHeader header;
+        long first = sync < 0 ? -1 : modulator.readStreamHeader(signal, sync, AudioModulator::SYNC_CHIRP, header);
+        if (first < 0) {
+            fprintf(stderr, "Error: benchmark signal did not sync\n");
+            continue;
+        }
+        const AudioModulator::DemodMode modes[] = {AudioModulator::DEMOD_FFT, AudioModulator::DEMOD_GOERTZEL};
+        for (AudioModulator::DemodMode mode : modes) {
+            if (ofdm && mode == AudioModulator::DEMOD_GOERTZEL) {
+                continue;
+            }
+            std::string kernel = ofdm ? "detect_symbols_ofdm"
+                                      : (mode == AudioModulator::DEMOD_FFT ? "detect_tone_fft" : "detect_tone_goertzel");
+            if (!selected(kernel)) {
+                continue;
+            }
+            modulator.setDemodMode(mode);
+            uint8_t bytes[64];
+            measure(kernel, size, symbols * symbolLength, symbols, [&] {
+                uint64_t sum = 0;
+                for (size_t s = 0; s < (size_t)symbols; s++) {
+                    modulator.readDataSymbol(signal, first + s * symbolLength, modulation,
+                                             AudioModulator::PROFILE_STANDARD, bytes);
+                    sum += bytes[0];
+                }
+                sink = sum;
+            });
+        }
+        modulator.setDemodMode(AudioModulator::DEMOD_FFT);
+    }
+}
+
+// Preamble search over noise as long as an FSK transmission of each size
+void benchFindSync() {
+    if (!selected("find_sync")) return;
+    AudioModulator modulator;
+    modulator.setNumThreads(1);
+    std::vector<float> message = modulator.modulate(randomBytes(16, 5));
+
+    for (size_t size : sizesUpTo(options.maxModemBytes)) {
+        size_t noiseSamples = size * modulator.getSamplesPerSymbol();
+        std::vector<uint8_t> noise = randomBytes(noiseSamples, 6);
+        std::vector<float> signal(noiseSamples);
+        for (size_t i = 0; i < noiseSamples; i++) {
+            signal[i] = (noise[i] - 127.5f) / 1280.0f;
+        }
+        signal.insert(signal.end(), message.begin(), message.end());
+
+        measure("find_sync", size, (double)signal.size(), 0, [&] {
+            sink = modulator.findSync(signal, 0);
+        });
+    }
+}
+
+void benchWavFile() {
+    WavFile wav;
+    wav.setVerbose(false);
+    std::string path = (std::filesystem::temp_directory_path() /
+                        ("audio_bench_" + std::to_string(::getpid()) + ".wav")).string();
+
+    for (size_t size : sizesUpTo(SIZE_MAX)) {
+        // size bytes of 16-bit PCM
+        std::vector<uint8_t> noise = randomBytes(size / 2, 7);
+        std::vector<float> samples(size / 2);
+        for (size_t i = 0; i < samples.size(); i++) {
+            samples[i] = (noise[i] - 127.5f) / 128.0f;
+        }
+        wav.write(path, samples);
+
+        if (selected("wav_write")) {
+            measure("wav_write", size, (double)samples.size(), 0, [&] {
+                sink = wav.write(path, samples);
+            });
+        }
+        if (selected("wav_read")) {
+            std::vector<float> in;
+            int rate, channels;
+            measure("wav_read", size, (double)samples.size(), 0, [&] {
+                sink = wav.read(path, in, rate, channels);
+            });
+        }
+        if (selected("wav_map")) {
+            std::vector<float> in(samples.size());
+            measure("wav_map", size, (double)samples.size(), 0, [&] {
+                WavFile::PcmView view;
+                if (wav.map(path, view)) {
+                    WavFile::convertToFloat(view, 0, view.frames, in.data());
+                    wav.unmap();
+                }
+                sink = in[0] != 0.0f;
+            });
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Report
+
+std::string jsonReport() {
+    std::ostringstream out;
+    out.precision(6);
+    out << "{\n  \"schema\": 1,\n"
+        << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+        << "  \"min_time\": " << options.minTime << ",\n"
+        << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"kernel\": \"" << r.kernel << "\", \"bytes\": " << r.bytes
+            << ", \"iterations\": " << r.iterations
+            << ", \"ns_per_op\": " << std::fixed << std::setprecision(1) << r.nsPerOp
+            << ", \"bytes_per_sec\": " << std::setprecision(0) << r.bytes * 1e9 / r.nsPerOp;
+        if (r.samples > 0) {
+            out << ", \"samples_per_sec\": " << r.samples * 1e9 / r.nsPerOp;
+        }
+        if (r.symbols > 0) {
+            out << ", \"ns_per_symbol\": " << std::setprecision(1) << r.nsPerOp / r.symbols;
+        }
+        out << ", \"allocs_per_op\": " << std::setprecision(2) << r.allocsPerOp
+            << ", \"alloc_bytes_per_op\": " << std::setprecision(0) << r.allocBytesPerOp << "}";
+        out.unsetf(std::ios::fixed);
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+void printUsage(const char* programName) {
+    std::cerr << "Usage: " << programName << " [options]\n"
+              << "  --filter=TEXT         Only kernels whose name contains TEXT\n"
+              << "  --max-bytes=N         Largest payload (default: 10000000)\n"
+              << "  --max-modem-bytes=N   Largest FSK payload (default: 10000)\n"
+              << "  --max-ofdm-bytes=N    Largest OFDM payload (default: 1000000)\n"
+              << "  --min-time=SEC        Measurement time per case (default: 0.25)\n"
+              << "  --json=PATH           Write the JSON report to PATH instead of stdout\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (name == "--filter") {
+            options.filter = value;
+        } else if (name == "--max-bytes") {
+            options.maxBytes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--max-modem-bytes") {
+            options.maxModemBytes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--max-ofdm-bytes") {
+            options.maxOfdmBytes = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--min-time") {
+            options.minTime = std::atof(value.c_str());
+        } else if (name == "--json") {
+            options.jsonPath = value;
+        } else {
+            printUsage(argv[0]);
+            return name == "--help" ? 0 : 1;
+        }
+    }
+
+    // Keep the library's progress output out of the measurements
+    Console::setQuiet(true);
+
+    benchCrc();
+    benchReedSolomon();
+    benchInterleaver();
+    benchFountain();
+    benchCompressor();
+    benchModem(AudioModulator::MOD_FSK, options.maxModemBytes);
+    benchModem(AudioModulator::MOD_OFDM, options.maxOfdmBytes);
+    benchFindSync();
+    benchWavFile();
+
+    std::string errors = Console::takeErrors();
+    Console::setQuiet(false);
+    if (!errors.empty()) {
+        std::cerr << errors;
+    }
+
+    std::string report = jsonReport();
+    if (options.jsonPath.empty()) {
+        std::cout << report;
+    } else {
+        std::ofstream file(options.jsonPath);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not write " << options.jsonPath << std::endl;
+            return 1;
+        }
+        file << report;
+    }
+    return 0;
+}
@@ -7,32 +7,105 @@
 #include "AudioModulator.h"
 #include "ErrorCorrection.h"
 #include "WavFile.h"
+#include "Interleaver.h"
+#include "Compressor.h"
+#include "Framer.h"
 
 /**
  * @brief Main decoder class for converting audio back to files
  */
 class AudioDecoder {
 public:
+    /**
+     * @brief Outcome of the last decodeFile() or decodeStream() call (a stream's last file)
+     */
+    struct DecodeResult {
+        std::string outputPath;         // Empty if no file was written
+        uint64_t fileBytes = 0;
+        double audioSeconds = 0.0;
+        bool crcMatches = false;        // Packet CRC32 verified (file CRC32 when framed)
+        uint32_t crc = 0;               // CRC32 computed over the received packet
+        size_t correctedSymbols = 0;
+        size_t failedBlocks = 0;
+        bool framed = false;            // Framed transmission, written frame by frame
+        std::vector<Framer::Range> missing;     // Byte ranges no intact frame delivered
+    };
+
     AudioDecoder();
     ~AudioDecoder();
 
     /**
      * @brief Decode an audio file back to the original file
+     *
+     * A framed transmission writes every intact frame at its offset; the
+     * byte ranges still missing are in getLastResult().missing.
      * @param inputFile Path to input audio file (.wav)
      * @param outputDir Directory to save decoded file
-     * @return true if successful, false otherwise
+     * @return true if a file was written, false otherwise
      */
     bool decodeFile(const std::string& inputFile, const std::string& outputDir);
 
+    /**
+     * @brief Decode transmissions from a live PCM stream as they arrive
+     *
+     * Reads raw 16-bit PCM or a WAV stream from a FIFO or stdin ("-"),
+     * keeping only the samples that sync and symbol detection still need.
+     * Each Reed-Solomon block is decoded and written to the output file as
+     * soon as its last symbol arrives. Keeps listening for further
+     * transmissions until the input ends. A framed transmission cut short
+     * still writes its file, with the missing ranges in getLastResult().
+     * @param input Input path, FIFO or "-" for stdin
+     * @param outputDir Directory to save decoded files
+     * @param sampleRate Sample rate of raw (headerless) input
+     * @param channels Channel count of raw (headerless) input
+     * @return true if at least one file was decoded, false otherwise
+     */
+    bool decodeStream(const std::string& input, const std::string& outputDir,
+                      int sampleRate = 44100, int channels = 1);
+
+    /**
+     * @brief Sample format of raw (headerless) decodeStream() input (default: 16-bit)
+     */
+    void setRawFormat(WavFile::SampleFormat format) { wavFile.setRawFormat(format); }
+
+    /**
+     * @brief Select the tone detection engine (FFT tone bank or Goertzel reference)
+     */
+    void setDemodMode(AudioModulator::DemodMode mode) { modulator.setDemodMode(mode); }
+
+    /**
+     * @brief Worker threads for symbol demodulation and RS decoding (0 = one per core)
+     */
+    void setNumThreads(int threads) {
+        modulator.setNumThreads(threads);
+        errorCorrection.setNumThreads(threads);
+    }
+
+    /**
+     * @brief Print WAV reader progress (on by default)
+     */
+    void setVerbose(bool enable) { wavFile.setVerbose(enable); }
+
+    const DecodeResult& getLastResult() const { return lastResult; }
+
 private:
     AudioModulator modulator;
     ErrorCorrection errorCorrection;
     WavFile wavFile;
+    DecodeResult lastResult;
 
     bool parseDataPacket(const std::vector<uint8_t>& packet,
                         std::string& filename,
                         std::vector<uint8_t>& fileData);
     bool writeOutputFile(const std::string& path, const std::vector<uint8_t>& data);
+
+    /**
+     * @brief decodeStream() picking up after a transmission decodeFile() already demodulated
+     * @param decoded That transmission's decoded bytes
+     * @param resumeSample Samples to skip at the modem rate, so up to that transmission's end
+     */
+    bool decodeStream(const std::string& input, const std::string& outputDir, int sampleRate, int channels,
+                      const std::vector<uint8_t>& decoded, long resumeSample);
 };
 
 #endif // AUDIO_DECODER_H
@@ -7,12 +7,47 @@
 #include "AudioModulator.h"
 #include "ErrorCorrection.h"
 #include "WavFile.h"
+#include "Interleaver.h"
+#include "Compressor.h"
+#include "Framer.h"
+#include "Fountain.h"
 
 /**
  * @brief Main encoder class for converting files to audio
  */
 class AudioEncoder {
 public:
+    /**
+     * @brief When to compress the file data before error correction
+     *
+     * AUTO skips formats that are already compressed (JPEG, PNG, ZIP, ...)
+     * and tone-sync (legacy) streams, and keeps the result only if it saves
+     * at least one Reed-Solomon block.
+     * ON always tries; OFF sends the data as is.
+     */
+    enum CompressMode {
+        COMPRESS_OFF,
+        COMPRESS_AUTO,
+        COMPRESS_ON
+    };
+
+    static constexpr uint32_t FOUNTAIN_BURST = 16;          // Frames per fountain transmission
+    static constexpr uint32_t FOUNTAIN_ENDLESS = 0xFFFFFFFF;
+
+    /**
+     * @brief Outcome of the last encodeFile() or encodeFileStreaming() call
+     */
+    struct EncodeResult {
+        uint64_t inputBytes = 0;        // Size of the input file
+        uint64_t packetBytes = 0;       // Packet (after compression) before error correction
+        uint64_t encodedBytes = 0;      // After Reed-Solomon coding
+        double audioSeconds = 0.0;
+        uint32_t crc = 0;               // Packet CRC32 (file CRC32 when framed)
+        Compressor::Codec codec = Compressor::CODEC_NONE;
+        uint32_t frames = 0;            // Frames sent, 0 for a single packet
+        uint32_t transmissions = 1;     // Preamble-to-trailer transmissions in the output
+    };
+
     AudioEncoder();
     ~AudioEncoder();
 
@@ -24,14 +59,138 @@ public:
      */
     bool encodeFile(const std::string& inputFile, const std::string& outputFile);
 
+    /**
+     * @brief Encode a file into audio samples in memory
+     * @param inputFile Path to input file
+     * @param symbols Optional output of the data bytes as sent on air
+     *                (after error correction and interleaving)
+     * @return Audio samples at getSampleRate(), empty on failure
+     */
+    std::vector<float> encodeSamples(const std::string& inputFile, std::vector<uint8_t>* symbols = nullptr);
+
+    /**
+     * @brief Encode a file with bounded memory, writing audio as it is produced
+     *
+     * Reads the input in chunks, Reed-Solomon encodes each block as it fills
+     * and appends the modulated audio to the output immediately; peak memory
+     * does not depend on file size. The data is never compressed, so the
+     * output matches encodeFile() only where that sends the file as is (a
+     * note is printed when it would have compressed).
+     * @param inputFile Path to input file
+     * @param outputFile Path to output audio file (.wav), or "-" for raw PCM on stdout
+     * @return true if successful, false otherwise
+     */
+    bool encodeFileStreaming(const std::string& inputFile, const std::string& outputFile);
+
+    /**
+     * @brief Select the preamble (chirp by default, tone for legacy decoders)
+     */
+    void setSyncMode(AudioModulator::SyncMode mode) { modulator.setSyncMode(mode); }
+
+    /**
+     * @brief Select the data modulation (FSK by default, OFDM needs chirp sync)
+     */
+    void setModulation(AudioModulator::Modulation mode) { modulator.setModulation(mode); }
+
+    /**
+     * @brief Select the FSK modem profile (announced in the stream header)
+     */
+    void setProfile(AudioModulator::ModemProfile profile) { modulator.setProfile(profile); }
+
+    /**
+     * @brief Reed-Solomon blocks interleaved per group (1 = off, default 8)
+     *
+     * Spreads each block over depth times as many symbols so a burst of up
+     * to 16 * depth lost symbols stays correctable. Chirp sync only; tone
+     * streams have no header field for it and are never interleaved.
+     */
+    void setInterleaveDepth(int depth) { interleaveDepth = depth; }
+
+    /**
+     * @brief Send the file as self-describing frames instead of one packet
+     *
+     * Every frame that arrives intact is written at its offset, so a lost
+     * Reed-Solomon block leaves a reported gap instead of a failed file.
+     * Framed data is never compressed. With ranges, only the data frames
+     * overlapping them are sent, to fill the gaps a receiver reported.
+     */
+    void setFramed(bool enable, const std::vector<Framer::Range>& ranges = std::vector<Framer::Range>()) {
+        framed = enable;
+        frameRanges = ranges;
+    }
+
+    /**
+     * @brief Broadcast the file as a rateless fountain code
+     *
+     * The output is a series of short transmissions of FOUNTAIN_BURST
+     * frames: a file frame, then coded frames with increasing ids. The
+     * first coded frames are the file itself; a listener who joins late or
+     * loses some catches up from any frames that follow, and needs only a
+     * few more than the file's frame count in all. encodeFile() and
+     * encodeFileStreaming() both write the broadcast; the data is sent
+     * uncompressed.
+     * @param frames Coded frames to send: 0 sends 1.5 times the file's
+     *               frames, FOUNTAIN_ENDLESS never stops (raw PCM output only)
+     */
+    void setFountain(bool enable, uint32_t frames = 0) {
+        fountain = enable;
+        fountainFrames = frames;
+    }
+
+    /**
+     * @brief Select the output sample format (16-bit PCM by default)
+     * @return false if the format cannot be written
+     */
+    bool setOutputFormat(WavFile::SampleFormat format) { return wavFile.setOutputFormat(format); }
+
+    /**
+     * @brief Apply TPDF dither when quantizing to integer PCM
+     */
+    void setDither(bool enable) { wavFile.setDither(enable); }
+
+    /**
+     * @brief Select the compression stage (AUTO by default, file encoder only)
+     */
+    void setCompressMode(CompressMode mode) { compressMode = mode; }
+
+    /**
+     * @brief Worker threads for Reed-Solomon encoding (0 = one per core)
+     */
+    void setNumThreads(int threads) { errorCorrection.setNumThreads(threads); }
+
+    /**
+     * @brief Print WAV writer progress (on by default)
+     */
+    void setVerbose(bool enable) { wavFile.setVerbose(enable); }
+
+    int getSampleRate() const { return modulator.getSampleRate(); }
+
+    const EncodeResult& getLastResult() const { return lastResult; }
+
 private:
     AudioModulator modulator;
     ErrorCorrection errorCorrection;
     WavFile wavFile;
+    int interleaveDepth;
+    CompressMode compressMode;
+    bool framed;
+    std::vector<Framer::Range> frameRanges;
+    bool fountain;
+    uint32_t fountainFrames;
+    EncodeResult lastResult;
+
+    int effectiveInterleaveDepth() const;
+    void printDataRate() const;
 
     std::vector<uint8_t> readInputFile(const std::string& filename);
     std::vector<uint8_t> createDataPacket(const std::string& filename, 
                                           const std::vector<uint8_t>& fileData);
+    std::vector<uint8_t> createFrames(const std::string& filename, const std::vector<uint8_t>& fileData);
+    bool encodeFountain(const std::string& inputFile, const std::string& outputFile);
+    std::vector<uint8_t> createPacketHeader(const std::string& filename, uint32_t fileDataLen,
+                                            Compressor::Codec codec = Compressor::CODEC_NONE,
+                                            uint32_t originalLen = 0);
+    double secondsPerEncodedByte() const;
     std::string extractFileName(const std::string& path);
 };
 
@@ -3,7 +3,10 @@
 
 #include <vector>
 #include <cstdint>
+#include <cmath>
 #include <complex>
+#include <string>
+#include "FFT.h"
 
 /**
  * @brief Multi-tone FSK (Frequency Shift Keying) modulator/demodulator
@@ -13,24 +16,236 @@
  */
 class AudioModulator {
 public:
+    /**
+     * @brief Tone detection engine used by demodulate()
+     *
+     * FFT computes every tone bin of a symbol with one transform sized to the
+     * tone grid; GOERTZEL runs one filter per candidate tone and is kept as
+     * the reference implementation. Both produce identical bytes.
+     */
+    enum DemodMode {
+        DEMOD_FFT,
+        DEMOD_GOERTZEL
+    };
+
+    /**
+     * @brief Preamble emitted by modulate()
+     *
+     * CHIRP is a linear sweep located by FFT matched filtering to the exact
+     * sample. TONE is the original 1000 Hz burst, kept so recordings made
+     * before the chirp was introduced still decode. demodulate() accepts both.
+     */
+    enum SyncMode {
+        SYNC_CHIRP,
+        SYNC_TONE
+    };
+
+    /**
+     * @brief Modulation of the data section (the header is always FSK)
+     *
+     * FSK sends one byte per 30 ms tone. OFDM sends OFDM_SYMBOL_BYTES per
+     * 13 ms multi-carrier symbol: QPSK on every data subcarrier from 2 to
+     * 14.5 kHz, pilot subcarriers for per-symbol channel estimation and a
+     * cyclic prefix against echoes. OFDM needs chirp sync.
+     */
+    enum Modulation {
+        MOD_FSK = 0,
+        MOD_OFDM = 1
+    };
+
+    static constexpr int OFDM_SYMBOL_BYTES = 31;
+
+    /**
+     * @brief Tone grid and symbol length of the FSK data section
+     *
+     * Every profile sends one byte per symbol on 256 tones and trades speed
+     * for robustness. STANDARD is the original modem (30 ms, 50 Hz grid from
+     * 2 kHz) and also carries every preamble and stream header, so the
+     * decoder can read the profile before the data starts. ROBUST sends
+     * 80 ms symbols on a 25 Hz grid from 1 kHz, FAST 16 ms symbols on a
+     * 63 Hz grid, and ULTRASONIC 40 ms symbols at 15-21.4 kHz. Profiles are
+     * defined at 44.1 kHz and only apply to FSK with chirp sync.
+     */
+    enum ModemProfile {
+        PROFILE_STANDARD = 0,
+        PROFILE_ROBUST = 1,
+        PROFILE_FAST = 2,
+        PROFILE_ULTRASONIC = 3,
+        PROFILE_COUNT
+    };
+
+    struct ProfileInfo {
+        const char* name;
+        int symbolSamples;          // Samples per symbol at 44.1 kHz
+        int baseFreq;               // Frequency of tone 0 (Hz)
+        int freqSpacing;            // Tone spacing (Hz)
+    };
+
+    static const ProfileInfo& profileInfo(ModemProfile profile);
+    static int topFrequency(ModemProfile profile);   // Highest data tone (Hz)
+    static bool findProfile(const std::string& name, ModemProfile& profile);
+
+    // Largest playback/record clock mismatch that timing tracking follows
+    static constexpr double MAX_CLOCK_OFFSET = 1e-3;
+
+    // Lowest capture rate that holds every stream header tone (up to 14.75 kHz)
+    static constexpr int MIN_CAPTURE_RATE = 32000;
+
+    /**
+     * @brief Follows the symbol clock through one data section
+     *
+     * A clock mismatch between the playing and the recording device stretches
+     * every symbol by the same factor, so a fixed step walks off the symbol
+     * boundaries on long transmissions. at(n) is where the n-th symbol from
+     * the current one starts. correct() takes the timing error measured on
+     * the current symbol and nudges both the position and the step (a
+     * second-order loop, so a constant clock offset is learnt rather than
+     * chased). Errors count relative to the first few measurements, where
+     * sync placed the window, so fixed channel delays are left alone.
+     */
+    class TimingLoop {
+    public:
+        TimingLoop(double start, double step);
+
+        long at(long symbols = 0) const { return std::lround(position + symbols * step); }
+        double getStep() const { return step; }
+
+        /**
+         * @param error Measured start of the current symbol relative to at() (samples)
+         * @param symbols Symbols since the previous correction
+         */
+        void correct(double error, int symbols = 1);
+        void advance(long symbols = 1) { position += symbols * step; }
+
+        /**
+         * @brief Follow the sample buffer when offset samples are dropped from its front
+         */
+        void rebase(long offset) { position -= offset; }
+
+    private:
+        static constexpr int REFERENCE_COUNT = 4;
+        static constexpr double POSITION_GAIN = 0.5;
+        static constexpr double STEP_GAIN = 0.05;
+
+        double position;
+        double step;
+        double nominal;         // Step at construction
+        double reference;       // Mean error over the first REFERENCE_COUNT measurements
+        int measured;
+    };
+
+    /**
+     * @brief Fields carried between the preamble and the data symbols
+     *
+     * Chirp streams (version 3) send: version, mode (modulation in the low
+     * nibble, FSK profile in the high nibble), interleave depth, 4 length
+     * bytes and a CRC-8 over the fields after the version. Version 2 has no
+     * mode byte; version 1 and tone streams carry only the length. Missing
+     * fields decode as standard FSK with depth 1.
+     */
+    struct StreamHeader {
+        uint32_t dataLength = 0;    // Data bytes that follow the header
+        int interleaveDepth = 1;    // RS blocks per interleaving group
+        Modulation modulation = MOD_FSK;
+        ModemProfile profile = PROFILE_STANDARD;
+        int version = 0;            // Set by readStreamHeader(); 0 for tone streams
+        long endSample = 0;         // Set by demodulate(): the sample after the transmission's end
+    };
+
     AudioModulator(int sampleRate = 44100);
     ~AudioModulator();
 
     /**
      * @brief Modulate binary data into audio samples
      * @param data Binary data to modulate
+     * @param interleaveDepth Depth announced in the stream header (the data is already interleaved)
      * @return Audio samples as float values (-1.0 to 1.0)
      */
-    std::vector<float> modulate(const std::vector<uint8_t>& data);
+    std::vector<float> modulate(const std::vector<uint8_t>& data, int interleaveDepth = 1);
 
     /**
      * @brief Demodulate audio samples into binary data
      * @param samples Audio samples to demodulate
+     * @param header Optional output of the stream header that was read
+     * @param confidence Optional output of how sure each decided byte is,
+     *        one entry per returned byte (see readDataSymbol())
      * @return Demodulated binary data
      */
-    std::vector<uint8_t> demodulate(const std::vector<float>& samples);
+    std::vector<uint8_t> demodulate(const std::vector<float>& samples, StreamHeader* header = nullptr,
+                                    std::vector<uint8_t>* confidence = nullptr);
+
+    /**
+     * @brief Streaming modulation, producing the same samples as modulate()
+     *
+     * A transmission is writeHeader(), writeSymbols() for every chunk of
+     * data (dataLength bytes in total), flushSymbols(), then writeTrailer().
+     * Each call writes into a caller-provided buffer and returns the end of
+     * what it wrote. OFDM holds back a partial symbol until more data or
+     * flushSymbols() arrives; maxSymbolSamples(count) bounds what one
+     * writeSymbols() or flushSymbols() (count = 0) call can produce.
+     */
+    size_t headerSamples() const;
+    size_t trailerSamples() const;
+    size_t maxSymbolSamples(size_t count) const;
+    float* writeHeader(const StreamHeader& header, float* out);
+    float* writeSymbols(const uint8_t* data, size_t count, float* out);
+    float* flushSymbols(float* out);
+    float* writeTrailer(float* out);
+
+    /**
+     * @brief Streaming demodulation primitives used by the real-time decoder
+     *
+     * findSync() returns the index just past the first chirp preamble at or
+     * after begin (-1 if none). readStreamHeader() reads the header that
+     * follows a preamble and returns the index of the first data symbol
+     * (-1 on failure). readDataSymbol() decodes the data symbol at pos
+     * (symbolBytes() bytes, spanning symbolSamples() samples) for the
+     * modulation and profile named in the header; with timing set it also
+     * measures where the symbol really starts relative to pos, for a
+     * TimingLoop. That looks timingLookahead() samples past the symbol
+     * (and as far before it) and reads 0 where those are missing.
+     * With confidence set it writes one soft value per decoded byte, in
+     * quarter dB (0-255): for FSK the chosen tone's power over the
+     * runner-up's, for OFDM the weakest of the byte's four QPSK carriers,
+     * measured as its distance from the decision boundary over the noise
+     * in that symbol.
+     */
+    long findSync(const std::vector<float>& samples, size_t begin);
+    long readStreamHeader(const std::vector<float>& samples, long pos,
+                          SyncMode sync, StreamHeader& header);
+    int readDataSymbol(const std::vector<float>& samples, size_t pos,
+                       Modulation modulation, ModemProfile profile, uint8_t* out,
+                       double* timing = nullptr, uint8_t* confidence = nullptr);
+    long timingLookahead(Modulation modulation, ModemProfile profile = PROFILE_STANDARD) const;
+    long symbolSamples(Modulation modulation, ModemProfile profile = PROFILE_STANDARD) const;
+    static int symbolBytes(Modulation modulation);
 
     int getSampleRate() const { return sampleRate; }
+    int getSamplesPerSymbol() const { return samplesPerSymbol; }
+
+    void setDemodMode(DemodMode mode) { demodMode = mode; }
+    DemodMode getDemodMode() const { return demodMode; }
+
+    void setSyncMode(SyncMode mode) { syncMode = mode; }
+    SyncMode getSyncMode() const { return syncMode; }
+
+    /**
+     * @brief Select the data modulation; tone-sync streams always use FSK
+     */
+    void setModulation(Modulation mode) { modulation = mode; }
+    Modulation getModulation() const { return syncMode == SYNC_CHIRP ? modulation : MOD_FSK; }
+
+    /**
+     * @brief Select the FSK data profile; OFDM and tone-sync streams use STANDARD
+     */
+    void setProfile(ModemProfile p) { profile = p; }
+    ModemProfile getProfile() const { return getModulation() == MOD_FSK && syncMode == SYNC_CHIRP ? profile : PROFILE_STANDARD; }
+
+    /**
+     * @brief Worker threads used for symbol detection (0 = one per core)
+     */
+    void setNumThreads(int threads) { numThreads = threads; }
+    int getNumThreads() const { return numThreads; }
 
 private:
     int sampleRate;
@@ -38,17 +253,95 @@ private:
     int samplesPerSymbol;       // Number of samples per symbol
     
     // Frequency configuration for 256-FSK (8 bits per symbol) - MUCH FASTER!
+    // Preambles and headers always use this grid (the STANDARD profile)
     static constexpr int NUM_TONES = 256;
     static constexpr double BASE_FREQ = 2000.0;  // Start frequency (Hz)
     static constexpr double FREQ_SPACING = 50.0; // Frequency spacing (Hz)
     static constexpr double SYNC_FREQ = 1000.0;    // Synchronization frequency
+
+    // FFT tone bank: symbols are folded modulo toneFftSize so that every
+    // tone frequency lands exactly on a bin (bin width == FREQ_SPACING)
+    DemodMode demodMode;
+    int toneFftSize;            // 0 if the tone grid does not fit a bin grid
+    RealFFT toneFft;
+
+    // Symbol templates: NUM_TONES data tones followed by the sync tone, each
+    // samplesPerSymbol long with the envelope applied (built on first use)
+    std::vector<float> symbolTable;
+
+    // Chirp preamble: linear sweep lasting PREAMBLE_SYMBOLS symbols, followed
+    // by a STREAM_VERSION symbol so the header can evolve without a new preamble
+    static constexpr int PREAMBLE_SYMBOLS = 5;
+    static constexpr double CHIRP_START_FREQ = 1000.0;
+    static constexpr double CHIRP_END_FREQ = 6000.0;
+    static constexpr double CHIRP_THRESHOLD = 0.05; // Normalised correlation for a sync hit (data/tone preamble stay below 0.01)
+    static constexpr int STREAM_VERSION = 3;       // Versions 1 and 2 are still read
+    static constexpr int TRACKING_INTERVAL = 16;   // FSK symbols per timing measurement in demodulate()
+    static constexpr double RESAMPLE_CLOCK_OFFSET = 5e-5; // Larger clock offsets are resampled away (tones move too)
+
+    SyncMode syncMode;
+    std::vector<float> chirp;
+    double chirpEnergy;
+    FFT syncFft;                                      // Built on first use
+    std::vector<std::complex<double>> chirpSpectrum;  // conj(FFT(chirp)) / N
+
+    int numThreads;
+
+    // OFDM: OFDM_FFT_SIZE-point symbols with an OFDM_CP_SAMPLES cyclic prefix.
+    // Subcarrier bins OFDM_FIRST_BIN..OFDM_LAST_BIN, every OFDM_PILOT_SPACING-th
+    // one (starting at the first) a BPSK pilot, the rest QPSK data
+    static constexpr int OFDM_FFT_SIZE = 512;
+    static constexpr int OFDM_CP_SAMPLES = 64;
+    static constexpr int OFDM_FIRST_BIN = 24;       // ~2.07 kHz
+    static constexpr int OFDM_LAST_BIN = 168;       // ~14.5 kHz
+    static constexpr int OFDM_PILOT_SPACING = 8;
+    static constexpr int OFDM_WINDOW_BACKOFF = 16;  // FFT window starts this far inside the prefix
+    static constexpr double OFDM_RMS = 0.2;         // Output level; peaks stay below full scale
+
+    Modulation modulation;
+    FFT ofdmFft;                                    // Built on first use
+    RealFFT ofdmRealFft;
+    std::vector<int> ofdmDataBins;
+    std::vector<int> ofdmPilotBins;
+    std::vector<double> ofdmPilots;                 // +/-1 per pilot bin
+    std::vector<uint8_t> ofdmPending;               // Bytes waiting for a full OFDM symbol
+
+    // FSK data profiles. STANDARD data reuses symbolTable; the others get
+    // their own templates and folded-FFT tone bank, built on first use
+    ModemProfile profile;
+    std::vector<float> profileTables[PROFILE_COUNT];
+    RealFFT profileFfts[PROFILE_COUNT];
     
     // Helper functions
-    std::vector<float> generatePreamble();
     std::vector<float> generateTone(double frequency, int numSamples);
+    void buildSymbolTable();
+    float* writeSymbol(int tone, float* out) const;
+    float* writePreamble(float* out) const;
     int detectTone(const std::vector<float>& samples, int startIdx);
-    double goertzelFilter(const std::vector<float>& samples, int startIdx, double frequency);
-    std::vector<int> findPreamble(const std::vector<float>& samples);
+    int detectToneGoertzel(const std::vector<float>& samples, int startIdx, double baseFreq,
+                           double freqSpacing, int length, uint8_t* confidence = nullptr,
+                           float* snr = nullptr);
+    void detectSymbols(const std::vector<float>& samples, const long* starts, size_t count,
+                       ModemProfile profile, int* tones, uint8_t* confidence = nullptr, float* snr = nullptr);
+    double goertzelFilter(const std::vector<float>& samples, int startIdx, double frequency, int length);
+    void prepareProfile(ModemProfile profile);
+    int detectDataTone(const std::vector<float>& samples, size_t pos, ModemProfile profile);
+    void detectDataRange(const std::vector<float>& samples, const long* starts, size_t begin, size_t end,
+                         ModemProfile profile, int* tones, uint8_t* confidence = nullptr, float* snr = nullptr);
+    double toneTiming(const std::vector<float>& samples, long pos, ModemProfile profile, int tone);
+    long findEndPreamble(const std::vector<float>& samples, long preambleEnd, long dataEnd);
+    std::vector<uint8_t> demodulateData(const std::vector<float>& samples, TimingLoop clock,
+                                        const StreamHeader& header, std::vector<uint8_t>* confidence);
+    template <ModemProfile P> float* writeProfileSymbols(const uint8_t* data, size_t count, float* out) const;
+    template <ModemProfile P> int detectProfileTone(const float* symbol, uint8_t* confidence, float* snr) const;
+    std::vector<float> generateChirp(int numSamples);
+    void buildOfdm();
+    float* writeOfdmSymbol(const uint8_t* bytes, float* out);
+    void readOfdmSymbol(const std::vector<float>& samples, size_t pos, uint8_t* out, double* timing = nullptr,
+                        uint8_t* confidence = nullptr, float* snr = nullptr);
+    static uint8_t headerCrc8(const uint8_t* data, size_t length);
+    std::vector<int> findChirpPreamble(const std::vector<float>& samples, size_t begin, size_t maxHits);
+    std::vector<int> findTonePreamble(const std::vector<float>& samples);
     void applyBandpassFilter(std::vector<float>& samples);
 };
 
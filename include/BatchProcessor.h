@@ -0,0 +1,75 @@
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <ostream>
+#include "AudioEncoder.h"
+#include "AudioDecoder.h"
+#include "WorkStealingPool.h"
+
+/**
+ * @brief Encodes or decodes many files in one process
+ *
+ * Jobs run on a WorkStealingPool, largest input first. Every worker builds
+ * one encoder or decoder and reuses it (tone tables, FFT plans, chirp
+ * reference) for all of its jobs; each job runs single-threaded with its
+ * console output silenced. One JSON object per file is written to the
+ * summary stream as jobs finish (JSON Lines), with status, sizes, timings,
+ * CRC results and any error messages.
+ */
+class BatchProcessor {
+public:
+    struct Totals {
+        size_t jobs = 0;
+        size_t succeeded = 0;
+        size_t failed = 0;
+        double seconds = 0.0;
+    };
+
+    /**
+     * @param threads Worker threads (0 = one per core)
+     */
+    explicit BatchProcessor(int threads = 0);
+
+    int getNumThreads() const { return pool.size(); }
+
+    /**
+     * @brief List the inputs named by a directory or a manifest file
+     *
+     * A directory contributes its regular files (only *.wav when wavOnly),
+     * sorted by name; a manifest lists one path per line, with blank lines
+     * and lines starting with '#' ignored.
+     * @return false if the source cannot be read
+     */
+    static bool collectInputs(const std::string& source, bool wavOnly, std::vector<std::string>& files);
+
+    /**
+     * @brief Encode every input to outputDir/<name>.wav
+     * @param configure Applies the encode options to each worker's encoder
+     * @param streaming Use the constant-memory encoder
+     * @return true if every file was encoded
+     */
+    bool encode(const std::vector<std::string>& inputs, const std::string& outputDir,
+                const std::function<bool(AudioEncoder&)>& configure, bool streaming,
+                std::ostream& summary);
+
+    /**
+     * @brief Decode every input WAV into outputDir (file names come from the packets)
+     * @param configure Applies the decode options to each worker's decoder
+     * @return true if every file was decoded with a matching CRC
+     */
+    bool decode(const std::vector<std::string>& inputs, const std::string& outputDir,
+                const std::function<bool(AudioDecoder&)>& configure, std::ostream& summary);
+
+    const Totals& getTotals() const { return totals; }
+
+private:
+    WorkStealingPool pool;
+    Totals totals;
+
+    std::vector<size_t> largestFirst(const std::vector<std::string>& inputs) const;
+};
+
+#endif // BATCH_PROCESSOR_H
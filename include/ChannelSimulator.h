@@ -0,0 +1,73 @@
+#ifndef CHANNEL_SIMULATOR_H
+#define CHANNEL_SIMULATOR_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+/**
+ * @brief Deterministic model of an acoustic link between speaker and microphone
+ *
+ * Sits between the encoder output and the decoder input. The transmission
+ * is padded with lead-in and lead-out silence, then passes a room reverb,
+ * the speaker/microphone pass band, a gain change with optional slow fading,
+ * the receiver's sample-rate offset, additive white Gaussian noise and burst
+ * dropouts, in that order. Every random choice comes from the seed, so the
+ * same seed and conditions reproduce the same samples.
+ */
+class ChannelSimulator {
+public:
+    struct Conditions {
+        std::string name = "clean";
+        double snrDb = INFINITY;    // AWGN relative to the mean transmission power (INFINITY = none)
+        double gainDb = 0.0;        // Fixed level change
+        double fadeDb = 0.0;        // Peak-to-peak slow gain variation
+        double fadeHz = 0.5;        // Rate of that variation
+        double ppm = 0.0;           // Receiver clock fast (+) or slow (-) against the sender's
+        double lowCutHz = 0.0;      // Second-order high-pass corner (0 = off)
+        double highCutHz = 0.0;     // Second-order low-pass corner (0 = off)
+        double reverbMs = 0.0;      // Room RT60 (0 = off)
+        double reverbMix = 0.3;     // Reverberant level against the direct sound
+        double dropoutRate = 0.0;   // Dropout bursts per second
+        double dropoutMs = 0.0;     // Length of each burst
+        double leadSeconds = 0.5;   // Silence (noise only) before and after the transmission
+    };
+
+    explicit ChannelSimulator(int sampleRate = 44100);
+
+    /**
+     * @brief Parse "LO-HI" band limits in Hz, e.g. "300-3400"
+     * @return false if text is not a valid band
+     */
+    static bool parseBand(const std::string& text, Conditions& conditions);
+
+    /**
+     * @brief Run samples through the channel
+     * @param input Transmitted samples at the simulator's sample rate
+     * @param conditions Impairments to apply
+     * @param seed Seeds the noise, reverb tail, fading phase and dropout positions
+     * @return Received samples, longer than input by the lead-in/out and the clock offset
+     */
+    std::vector<float> process(const std::vector<float>& input, const Conditions& conditions,
+                               uint32_t seed) const;
+
+    int getSampleRate() const { return sampleRate; }
+
+private:
+    int sampleRate;
+
+    // Windowed-sinc fractional delay table for the clock offset
+    static constexpr int RESAMPLE_TAPS = 16;
+    static constexpr int RESAMPLE_PHASES = 512;
+    std::vector<float> resampleTable;
+
+    void applyReverb(std::vector<float>& samples, const Conditions& conditions, uint32_t seed) const;
+    void applyBandLimit(std::vector<float>& samples, const Conditions& conditions) const;
+    void applyGain(std::vector<float>& samples, const Conditions& conditions, uint32_t seed) const;
+    std::vector<float> applyClockOffset(const std::vector<float>& samples, double ppm) const;
+    void applyNoise(std::vector<float>& samples, double signalPower, double snrDb, uint32_t seed) const;
+    void applyDropouts(std::vector<float>& samples, const Conditions& conditions, uint32_t seed) const;
+};
+
+#endif // CHANNEL_SIMULATOR_H
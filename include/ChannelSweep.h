@@ -0,0 +1,104 @@
+#ifndef CHANNEL_SWEEP_H
+#define CHANNEL_SWEEP_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include "AudioEncoder.h"
+#include "AudioModulator.h"
+#include "ChannelSimulator.h"
+#include "ErrorCorrection.h"
+
+/**
+ * @brief End-to-end link measurements over simulated channels
+ *
+ * Encodes one file in memory, then for each channel condition runs a
+ * number of seeded trials through ChannelSimulator and the receive chain
+ * (sync, demodulation, deinterleaving, Reed-Solomon, packet CRC), comparing
+ * each stage against what was sent. Symbol errors are counted in the bytes
+ * fed to Reed-Solomon, so an OFDM symbol counts as OFDM_SYMBOL_BYTES
+ * symbols; a trial that fails to sync counts every symbol and block as lost.
+ */
+class ChannelSweep {
+public:
+    struct Stats {
+        std::string name;
+        ChannelSimulator::Conditions conditions;
+        int trials = 0;
+        int synced = 0;                 // Trials whose preamble and header were read
+        int crcPassed = 0;
+        uint64_t symbols = 0;           // Symbols sent, over all trials
+        uint64_t symbolErrors = 0;
+        uint64_t blocks = 0;            // RS blocks sent, over all trials
+        uint64_t failedBlocks = 0;
+        uint64_t correctedSymbols = 0;
+        uint64_t frames = 0;            // Data frames sent, over all trials (framed only)
+        uint64_t framesRecovered = 0;   // Data frames that arrived intact
+        double audioSeconds = 0.0;      // Airtime of one transmission
+        uint64_t fileBytes = 0;         // Payload of one transmission
+
+        double symbolErrorRate() const { return symbols ? double(symbolErrors) / symbols : 0.0; }
+        double blockFailureRate() const { return blocks ? double(failedBlocks) / blocks : 0.0; }
+        double crcPassRate() const { return trials ? double(crcPassed) / trials : 0.0; }
+        double frameRecoveryRate() const { return frames ? double(framesRecovered) / frames : 0.0; }
+
+        /**
+         * @brief File bits delivered intact per second of airtime, averaged over trials
+         */
+        double goodput() const {
+            return audioSeconds > 0.0 ? crcPassRate() * fileBytes * 8.0 / audioSeconds : 0.0;
+        }
+    };
+
+    ChannelSweep();
+
+    /**
+     * @brief Encode the file that every trial transmits
+     * @param encoder Configured encoder (modulation, profile, interleaving, ...)
+     * @return false if the file could not be encoded
+     */
+    bool prepare(AudioEncoder& encoder, const std::string& inputFile);
+
+    /**
+     * @brief Run trials with seeds seed, seed + 1, ... under one condition
+     */
+    Stats run(const ChannelSimulator::Conditions& conditions, int trials, uint32_t seed);
+
+    /**
+     * @brief The default sweep: AWGN, gain and fading, clock offset, band
+     * limits, reverb and dropouts, each on its own and a few combined
+     */
+    static std::vector<ChannelSimulator::Conditions> standardConditions();
+
+    /**
+     * @brief One JSON object (one line) with the condition and its results
+     */
+    static void writeJson(const Stats& stats, std::ostream& out);
+
+    void setDemodMode(AudioModulator::DemodMode mode) { receiver.setDemodMode(mode); }
+
+    /**
+     * @brief Worker threads for demodulation and RS decoding (0 = one per core)
+     */
+    void setNumThreads(int threads) {
+        receiver.setNumThreads(threads);
+        errorCorrection.setNumThreads(threads);
+    }
+
+private:
+    ChannelSimulator channel;
+    AudioModulator receiver;
+    ErrorCorrection errorCorrection;
+
+    std::vector<float> transmission;
+    std::vector<uint8_t> sentSymbols;
+    uint64_t packetBytes;
+    uint64_t fileBytes;
+    uint32_t dataFrames;                // Data frames per transmission; 0 if not framed
+    double audioSeconds;
+
+    void runTrial(const ChannelSimulator::Conditions& conditions, uint32_t seed, Stats& stats);
+};
+
+#endif // CHANNEL_SWEEP_H
@@ -0,0 +1,52 @@
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Self-contained compression stage applied before error correction
+ *
+ * CODEC_LZRC is LZ77 (hash-chain match finder with one-step lazy matching
+ * over a 4 MB window) followed by an adaptive binary range coder for
+ * literals, match lengths and distances. Text, JSON and logs typically
+ * shrink 3-10x; already compressed formats are recognised by their magic
+ * bytes and left alone. The codec id travels in the data packet.
+ */
+class Compressor {
+public:
+    enum Codec {
+        CODEC_NONE = 0,     // Stored as is
+        CODEC_LZRC = 1      // LZ77 + range coder
+    };
+
+    /**
+     * @brief Compress a buffer with CODEC_LZRC
+     */
+    static std::vector<uint8_t> compress(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Decompress a CODEC_LZRC payload
+     * @param data Compressed bytes
+     * @param length Compressed length
+     * @param originalSize Size of the uncompressed data
+     * @param out Receives exactly originalSize bytes on success
+     * @return false if the payload is corrupt or truncated
+     */
+    static bool decompress(const uint8_t* data, size_t length, size_t originalSize,
+                           std::vector<uint8_t>& out);
+
+    /**
+     * @brief Whether data starts like an already compressed format
+     *
+     * Checks the magic bytes of common image, audio, video and archive
+     * formats (JPEG, PNG, GIF, WebP, MP3, Ogg, FLAC, MP4, ZIP, gzip, bzip2,
+     * xz, 7z, zstd).
+     */
+    static bool looksCompressed(const uint8_t* data, size_t length);
+
+    static const char* codecName(Codec codec);
+};
+
+#endif // COMPRESSOR_H
@@ -0,0 +1,37 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Console output of the encoder and decoder, routed per thread
+ *
+ * Progress goes to info() and errors and warnings to error(), which are
+ * std::cout and std::cerr by default. A thread that calls setQuiet(true),
+ * such as a batch worker, has its progress discarded and its errors kept
+ * for takeErrors(), so concurrent jobs never interleave on the terminal.
+ * setProgress(false) only drops the progress, as for the --quiet option.
+ */
+class Console {
+public:
+    static std::ostream& info();
+    static std::ostream& error();
+
+    /**
+     * @brief Quiet or restore the calling thread's output
+     */
+    static void setQuiet(bool quiet);
+
+    /**
+     * @brief Drop or restore the calling thread's progress; errors still go to std::cerr
+     */
+    static void setProgress(bool enable);
+
+    /**
+     * @brief Errors buffered on the calling thread since the last call (quiet threads only)
+     */
+    static std::string takeErrors();
+};
+
+#endif // CONSOLE_H
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 /**
  * @brief Reed-Solomon error correction implementation
@@ -12,22 +13,95 @@
  */
 class ErrorCorrection {
 public:
+    static constexpr int RS_NSYM = 32;          // Parity bytes per block
+    static constexpr int RS_BLOCK_SIZE = 223;   // Data bytes per block
+    static constexpr int ENCODED_BLOCK_SIZE = RS_BLOCK_SIZE + RS_NSYM;
+
+    // Soft decoding: symbols whose confidence is below ERASURE_THRESHOLD
+    // (6 dB on the demodulator's quarter-dB scale) may be erased. At most
+    // MAX_ERASURES per block, so at least as many parity symbols are left
+    // to check the result and a wrong decode stays unlikely
+    static constexpr int ERASURE_THRESHOLD = 24;
+    static constexpr int MAX_ERASURES = RS_NSYM / 2;
+
+    /**
+     * @brief Per-block outcome of decode()
+     */
+    struct DecodeReport {
+        std::vector<int> corrections;   // Symbols corrected per block, -1 if uncorrectable
+        std::vector<int> erasures;      // Symbols erased per block (0 unless errors alone failed)
+        size_t correctedBlocks = 0;
+        size_t correctedSymbols = 0;
+        size_t failedBlocks = 0;
+        size_t erasureBlocks = 0;       // Blocks saved by erasing unreliable symbols
+    };
+
     ErrorCorrection();
     ~ErrorCorrection();
 
+    /**
+     * @brief Worker threads for block encode/decode (0 = one per core)
+     */
+    void setNumThreads(int threads) { numThreads = threads; }
+    int getNumThreads() const { return numThreads; }
+
     /**
      * @brief Encode data with Reed-Solomon error correction
+     *
+     * Blocks are independent and encoded in parallel.
      * @param data Input data to encode
      * @return Encoded data with parity bytes
      */
     std::vector<uint8_t> encode(const std::vector<uint8_t>& data);
 
+    /**
+     * @brief Compute the parity of one full data block
+     * @param data RS_BLOCK_SIZE data bytes
+     * @param parity Output of RS_NSYM parity bytes
+     */
+    static void encodeBlock(const uint8_t* data, uint8_t* parity);
+
     /**
      * @brief Decode Reed-Solomon encoded data
+     *
+     * Blocks are independent and decoded in parallel. An uncorrectable block
+     * keeps its received data bytes, so later blocks stay at their offsets.
      * @param data Encoded data with possible errors
-     * @return Decoded data with errors corrected
+     * @param report Optional per-block status and totals
+     * @param confidence Optional per-symbol confidence, aligned with data
+     * @return Decoded data with errors corrected (RS_BLOCK_SIZE bytes per full block)
+     */
+    std::vector<uint8_t> decode(const std::vector<uint8_t>& data,
+                                DecodeReport* report = nullptr,
+                                const std::vector<uint8_t>* confidence = nullptr);
+
+    /**
+     * @brief Correct one codeword in place
+     *
+     * Clean blocks cost only the syndrome check; otherwise runs
+     * Berlekamp-Massey, Chien search and Forney to fix up to RS_NSYM / 2
+     * symbol errors.
+     * @param codeword Data bytes followed by RS_NSYM parity bytes
+     * @param length Codeword length (at most ENCODED_BLOCK_SIZE)
+     * @return Number of symbols corrected, or -1 if uncorrectable
      */
-    std::vector<uint8_t> decode(const std::vector<uint8_t>& data);
+    int decodeBlock(uint8_t* codeword, int length = ENCODED_BLOCK_SIZE);
+
+    /**
+     * @brief Correct one codeword in place, erasing unreliable symbols if needed
+     *
+     * Errors alone are tried first. If that fails, the least confident
+     * symbols below ERASURE_THRESHOLD are erased, a few more on each
+     * attempt up to MAX_ERASURES (generalized minimum distance decoding).
+     * With f erasures, up to (RS_NSYM - f) / 2 further errors are fixed, so
+     * flagged damage costs half the parity that unflagged damage does.
+     * @param codeword Data bytes followed by RS_NSYM parity bytes
+     * @param length Codeword length (at most ENCODED_BLOCK_SIZE)
+     * @param confidence Per-symbol confidence (0 = unknown or missing)
+     * @param erased Optional output of the symbols erased by the successful attempt
+     * @return Number of symbols corrected, or -1 if uncorrectable
+     */
+    int decodeBlock(uint8_t* codeword, int length, const uint8_t* confidence, int* erased = nullptr);
 
     /**
      * @brief Calculate CRC32 checksum
@@ -36,19 +110,44 @@ public:
      */
     static uint32_t calculateCRC32(const std::vector<uint8_t>& data);
 
+    /**
+     * @brief Calculate CRC32 checksum of a span
+     * @param data Input data
+     * @param length Number of bytes
+     * @return CRC32 checksum value
+     */
+    static uint32_t calculateCRC32(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Continue a CRC32 over another span of data
+     *
+     * Start from CRC32_INIT and finish with finalizeCRC32(); the result
+     * matches calculateCRC32() over the concatenated spans. Uses PCLMULQDQ
+     * folding when the CPU supports it, slice-by-16 tables otherwise.
+     * @param crc Running (non-inverted) CRC state
+     * @param data Input data
+     * @param length Number of bytes
+     * @return Updated CRC state
+     */
+    static uint32_t updateCRC32(uint32_t crc, const uint8_t* data, size_t length);
+
+    static constexpr uint32_t CRC32_INIT = 0xFFFFFFFF;
+
+    /**
+     * @brief Convert a running CRC state into the checksum value
+     */
+    static uint32_t finalizeCRC32(uint32_t crc) { return ~crc; }
+
 private:
-    // Galois Field tables for Reed-Solomon
-    std::vector<uint8_t> gf_exp;
-    std::vector<uint8_t> gf_log;
-    
-    void initGaloisField();
+    int numThreads;
+
+    template <typename Fn>
+    void forEachBlockRange(size_t numBlocks, Fn fn);
     uint8_t gfMul(uint8_t a, uint8_t b);
     uint8_t gfDiv(uint8_t a, uint8_t b);
-    std::vector<uint8_t> gfPolyMul(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b);
-    std::vector<uint8_t> gfPolyDiv(const std::vector<uint8_t>& dividend, const std::vector<uint8_t>& divisor);
-    std::vector<uint8_t> rsGeneratorPoly(int nsym);
-    std::vector<uint8_t> rsEncode(const std::vector<uint8_t>& msg, int nsym);
-    std::vector<uint8_t> rsDecode(const std::vector<uint8_t>& msg, int nsym);
+    bool rsCalcSyndromes(const uint8_t* msg, int length, uint8_t* syndromes);
+    int correctErrata(uint8_t* codeword, int length, const uint8_t* syndromes,
+                      const int* erasures, int erasureCount);
 };
 
 #endif // ERROR_CORRECTION_H
@@ -0,0 +1,74 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+#include <complex>
+
+/**
+ * @brief Mixed-radix complex FFT for arbitrary sizes
+ *
+ * Handles any length by factoring it into radix-4/2/3/5 stages plus a
+ * generic butterfly for larger primes, so tone grids like 882 points
+ * (44.1 kHz / 50 Hz) transform directly without padding.
+ * All methods are const and safe to call from several threads at once.
+ */
+class FFT {
+public:
+    explicit FFT(int size = 0);
+    ~FFT();
+
+    /**
+     * @brief Forward transform (e^{-j...} kernel, unnormalised)
+     * @param in Input sequence of size() values
+     * @param out Output spectrum of size() values (must not alias in)
+     */
+    void forward(const std::complex<double>* in, std::complex<double>* out) const;
+
+    /**
+     * @brief Inverse transform (e^{+j...} kernel, unnormalised)
+     * @param in Input spectrum of size() values
+     * @param out Output sequence of size() values (must not alias in)
+     */
+    void inverse(const std::complex<double>* in, std::complex<double>* out) const;
+
+    int size() const { return n; }
+
+private:
+    int n;
+    std::vector<int> factors;                  // (radix, remaining length) pairs
+    std::vector<std::complex<double>> twiddles;
+
+    void work(std::complex<double>* out, const std::complex<double>* in,
+              int fstride, const int* stage) const;
+    void butterfly2(std::complex<double>* out, int fstride, int m) const;
+    void butterfly4(std::complex<double>* out, int fstride, int m) const;
+    void butterflyGeneric(std::complex<double>* out, int fstride, int m, int p) const;
+};
+
+/**
+ * @brief Real-input FFT built on a half-size complex transform
+ *
+ * Produces the non-negative half of the spectrum (size()/2 + 1 bins).
+ * The size must be even.
+ */
+class RealFFT {
+public:
+    explicit RealFFT(int size = 0);
+    ~RealFFT();
+
+    /**
+     * @brief Forward transform of real input
+     * @param in Input sequence of size() values
+     * @param out Output bins 0..size()/2 (size()/2 + 1 values)
+     */
+    void forward(const double* in, std::complex<double>* out) const;
+
+    int size() const { return n; }
+
+private:
+    int n;
+    FFT half;
+    std::vector<std::complex<double>> twiddles; // e^{-j2πk/n}, k < n/2
+};
+
+#endif // FFT_H
@@ -0,0 +1,99 @@
+#ifndef FOUNTAIN_H
+#define FOUNTAIN_H
+
+#include <vector>
+#include <unordered_set>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Rateless (Raptor-style) fountain code over fixed-size symbols
+ *
+ * The file is cut into K source symbols. A precode adds S sparse (LDPC)
+ * and H dense parity symbols; together these are the L intermediate
+ * symbols. Encoded symbol esi is the XOR of a few intermediate symbols
+ * picked by a generator seeded with esi, with a degree drawn from a
+ * soliton-like distribution. The encoder solves for the intermediate
+ * symbols that make symbols 0..K-1 come out as the source symbols
+ * themselves (systematic), so source and repair symbols are rows of the
+ * same code: any set of about K + a few distinct symbols reconstructs
+ * the file, whichever ones they are.
+ *
+ * Decoding is maximum likelihood over GF(2) by inactivation: rows are
+ * peeled while one has a single unknown left; when none has, the columns
+ * of the sparsest row but one are set aside as inactive. The few inactive
+ * columns are then solved by Gaussian elimination on bit-packed rows, and
+ * substituted back eight at a time through a 256-entry XOR table.
+ */
+class Fountain {
+public:
+    /**
+     * @param length File length in bytes
+     * @param symbolSize Bytes per symbol; the last source symbol is zero padded
+     */
+    Fountain(uint64_t length, size_t symbolSize);
+
+    uint32_t getSourceSymbols() const { return K; }
+    uint32_t getIntermediateSymbols() const { return L; }
+    size_t getSymbolSize() const { return symbolSize; }
+
+    /**
+     * @brief Encoder: take the file and compute the parity symbols
+     * @param data length bytes
+     */
+    void setSource(const uint8_t* data);
+
+    /**
+     * @brief Encoder: write encoded symbol esi (after setSource())
+     */
+    void encodeSymbol(uint32_t esi, uint8_t* out) const;
+
+    /**
+     * @brief Decoder: keep a received symbol
+     * @return false if esi was already received
+     */
+    bool addSymbol(uint32_t esi, const uint8_t* symbol);
+
+    size_t getReceived() const { return esis.size(); }
+
+    /**
+     * @brief Decoder: solve for the file from the symbols received so far
+     * @param out The length file bytes on success
+     * @return false if more symbols are needed
+     */
+    bool decode(std::vector<uint8_t>& out);
+
+    /**
+     * @brief Columns the last decode() solved by elimination rather than peeling
+     */
+    size_t getInactivated() const { return inactivated; }
+
+private:
+    uint64_t length;
+    size_t symbolSize;
+    uint32_t K;                         // Source symbols
+    uint32_t S;                         // LDPC parity symbols
+    uint32_t H;                         // Dense parity symbols
+    uint32_t L;                         // K + S + H
+    uint32_t seed;                      // First generator seed for which rows 0..K-1 are solvable
+
+    std::vector<uint8_t> intermediate;  // L symbols (encoder, and the decoder's solution)
+    std::vector<uint32_t> esis;         // Received symbol ids, in arrival order
+    std::vector<uint8_t> received;      // Their data
+    std::unordered_set<uint32_t> seen;
+    size_t inactivated;
+
+    void rowColumns(uint32_t esi, std::vector<uint32_t>& columns) const;
+    void appendConstraintRows(std::vector<uint32_t>& start, std::vector<uint32_t>& columns) const;
+    uint32_t denseMask(uint32_t column) const;
+
+    /**
+     * @brief Solve the intermediate symbols from encoded symbols and the precode
+     * @param esis Row ids
+     * @param values Their symbols, T bytes each; nullptr with T = 0 only tests the rank
+     * @return false if the rows do not determine every intermediate symbol
+     */
+    bool solve(const std::vector<uint32_t>& esis, const uint8_t* values, size_t T);
+};
+
+#endif // FOUNTAIN_H
@@ -0,0 +1,112 @@
+#ifndef FRAMER_H
+#define FRAMER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "ErrorCorrection.h"
+
+/**
+ * @brief Self-describing frames for partial recovery of a transmission
+ *
+ * A framed transmission replaces the single data packet with fixed-size
+ * frames, exactly one per Reed-Solomon block, so a block that cannot be
+ * corrected costs only the bytes of its own frame:
+ *
+ *   [2: marker][1: type][4: sequence][4: offset][1: payload length]
+ *   [PAYLOAD_SIZE: payload, zero padded][4: CRC32 of everything before]
+ *
+ * Data frame i (sequence i + 1) carries file bytes from offset
+ * i * PAYLOAD_SIZE. The file frame (sequence 0) carries the file name,
+ * length and CRC32; it is sent first and repeated last. The marker lets a
+ * receiver find frame boundaries again after lost or garbled bytes. All
+ * integers are little-endian.
+ *
+ * A fountain frame carries encoded symbol `sequence` of a Fountain code
+ * over the file, and the file length in the offset field, so any frame
+ * tells a receiver how many it needs. The file frame of a fountain
+ * broadcast has a flags byte after the CRC32, with bit 0 set.
+ */
+class Framer {
+public:
+    static constexpr int FRAME_SIZE = ErrorCorrection::RS_BLOCK_SIZE;
+    static constexpr int HEADER_SIZE = 12;
+    static constexpr int PAYLOAD_SIZE = FRAME_SIZE - HEADER_SIZE - 4;
+    static constexpr uint8_t MARKER0 = 0xA5;
+    static constexpr uint8_t MARKER1 = 0xF7;
+
+    enum FrameType {
+        FRAME_FILE = 0,     // Name, length and CRC32 of the whole file
+        FRAME_DATA = 1,     // PAYLOAD_SIZE bytes of the file at offset
+        FRAME_FOUNTAIN = 2  // Fountain-coded symbol; offset holds the file length
+    };
+
+    /**
+     * @brief A frame that passed its marker, CRC and field checks
+     */
+    struct Frame {
+        FrameType type = FRAME_DATA;
+        uint32_t sequence = 0;
+        uint32_t offset = 0;
+        uint8_t length = 0;
+        const uint8_t* payload = nullptr;   // Points into the parsed buffer
+    };
+
+    /**
+     * @brief Contents of a file frame
+     */
+    struct FileInfo {
+        std::string filename;
+        uint32_t length = 0;
+        uint32_t crc = 0;
+        bool fountain = false;      // Fountain broadcast: fountain frames follow, not data frames
+    };
+
+    /**
+     * @brief Inclusive byte range of the file
+     */
+    struct Range {
+        uint64_t first = 0;
+        uint64_t last = 0;
+    };
+
+    /**
+     * @brief Data frames needed for a file of the given length
+     */
+    static uint32_t dataFrames(uint64_t fileLength);
+
+    /**
+     * @brief Data frames of the file that overlap any range (all if ranges is empty)
+     */
+    static bool covers(const std::vector<Range>& ranges, uint32_t index);
+    static uint32_t coveredFrames(const std::vector<Range>& ranges, uint64_t fileLength);
+
+    /**
+     * @brief Write one FRAME_SIZE-byte frame
+     */
+    static void writeFileFrame(const FileInfo& info, uint8_t* out);
+    static void writeDataFrame(uint32_t index, const uint8_t* data, size_t length, uint8_t* out);
+    static void writeFountainFrame(uint32_t esi, uint32_t fileLength, const uint8_t* symbol, uint8_t* out);
+
+    /**
+     * @brief Check and decode the FRAME_SIZE bytes at frame
+     * @return false unless marker, CRC and fields are all valid
+     */
+    static bool readFrame(const uint8_t* frame, Frame& out);
+    static bool readFileInfo(const Frame& frame, FileInfo& info);
+
+    /**
+     * @brief Whether decoded data starts with a frame rather than a data packet
+     */
+    static bool isFramed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Parse "first-last[,first-last...]" (inclusive byte offsets)
+     * @return false on a malformed list
+     */
+    static bool parseRanges(const std::string& text, std::vector<Range>& ranges);
+    static std::string formatRanges(const std::vector<Range>& ranges);
+};
+
+#endif // FRAMER_H
@@ -0,0 +1,54 @@
+#ifndef INTERLEAVER_H
+#define INTERLEAVER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Block interleaver between Reed-Solomon coding and modulation
+ *
+ * Codewords are taken in groups of depth() blocks (the last group may be
+ * shorter) and sent column-wise: byte j of every block in the group before
+ * byte j + 1 of any. A burst of B consecutive symbol errors then costs each
+ * codeword at most ceil(B / depth) errors instead of B.
+ */
+class Interleaver {
+public:
+    static constexpr int MAX_DEPTH = 255;   // Depth travels in one header symbol
+
+    /**
+     * @param depth Blocks per interleaving group (1 = pass-through)
+     * @param blockSize Codeword length in bytes
+     */
+    explicit Interleaver(int depth = 1, size_t blockSize = 255);
+
+    int getDepth() const { return depth; }
+
+    /**
+     * @brief Bytes in a full interleaving group
+     */
+    size_t groupBytes() const { return static_cast<size_t>(depth) * blockSize; }
+
+    /**
+     * @brief Interleave whole codewords group by group
+     * @param in length bytes of consecutive codewords
+     * @param length Byte count; a trailing partial codeword is copied as is
+     * @param out Output buffer of length bytes (must not alias in)
+     */
+    void interleave(const uint8_t* in, size_t length, uint8_t* out) const;
+
+    /**
+     * @brief Undo interleave() on a span produced from the same group boundaries
+     */
+    void deinterleave(const uint8_t* in, size_t length, uint8_t* out) const;
+
+    std::vector<uint8_t> interleave(const std::vector<uint8_t>& data) const;
+    std::vector<uint8_t> deinterleave(const std::vector<uint8_t>& data) const;
+
+private:
+    int depth;
+    size_t blockSize;
+};
+
+#endif // INTERLEAVER_H
@@ -0,0 +1,104 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Per-stage timings and counters of one encode or decode, routed per thread
+ *
+ * A thread that calls attach() records every Metrics::Scope and count()
+ * made on it into that Metrics object; on any other thread they cost one
+ * thread-local load and do nothing. Stages nest, and each records wall
+ * time, process CPU time (which includes the stage's worker threads) and
+ * the bytes and samples it processed. Histograms and series hold value
+ * distributions (such as symbol confidence) and per-block maps. The report
+ * is written as JSON or as Chrome trace events (chrome://tracing, Perfetto).
+ */
+class Metrics {
+public:
+    struct Stage {
+        std::string name;
+        int depth = 0;              // Nesting level, 0 for top-level stages
+        double startUs = 0.0;       // Since the Metrics object was created
+        double wallUs = 0.0;
+        double cpuUs = 0.0;
+        uint64_t bytes = 0;
+        uint64_t samples = 0;
+    };
+
+    struct Histogram {
+        std::string name;
+        double bucketWidth = 1.0;   // Bucket i holds [i, i + 1) * bucketWidth
+        std::vector<uint64_t> counts;
+    };
+
+    /**
+     * @brief Times one stage from construction to destruction
+     */
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void addBytes(uint64_t count);
+        void addSamples(uint64_t count);
+
+    private:
+        Metrics* metrics;
+        size_t index;
+        double cpuStart;
+    };
+
+    Metrics();
+
+    /**
+     * @brief Record the calling thread's stages and counters here (nullptr to stop)
+     */
+    static void attach(Metrics* metrics);
+    static Metrics* current();
+
+    /**
+     * @brief Add to a counter of the attached Metrics, if any
+     */
+    static void count(const char* name, uint64_t delta = 1);
+
+    /**
+     * @brief Add bucket counts to a histogram of the attached Metrics, if any
+     *
+     * Callers bin their values locally and add the counts once; a histogram
+     * grows to the longest counts it is given.
+     */
+    static void addHistogram(const char* name, double bucketWidth, const std::vector<uint64_t>& counts);
+
+    /**
+     * @brief Append a value to a series of the attached Metrics, if any
+     */
+    static void append(const char* name, double value);
+
+    const std::vector<Stage>& getStages() const { return stages; }
+    const std::vector<std::pair<std::string, uint64_t>>& getCounters() const { return counters; }
+    const std::vector<Histogram>& getHistograms() const { return histograms; }
+    const std::vector<std::pair<std::string, std::vector<double>>>& getSeries() const { return series; }
+
+    void writeJson(std::ostream& out) const;
+    void writeTrace(std::ostream& out) const;
+
+private:
+    std::vector<Stage> stages;
+    std::vector<std::pair<std::string, uint64_t>> counters;    // In first-use order
+    std::vector<Histogram> histograms;
+    std::vector<std::pair<std::string, std::vector<double>>> series;
+    int depth;
+    double origin;              // Wall clock at construction (us)
+
+    static double wallNow();
+    static double cpuNow();
+};
+
+#endif // METRICS_H
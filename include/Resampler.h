@@ -0,0 +1,67 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Rational polyphase sample-rate converter
+ *
+ * Converts by L/M = outRate/inRate in lowest terms with a Kaiser-windowed
+ * sinc cut off at the lower of the two Nyquist rates.
+ * The filter is stored as L phases of contiguous taps (at most MAX_PHASES;
+ * beyond that the phase is rounded), so each output sample is one short
+ * dot product. Output sample n is the input evaluated at time n * M / L,
+ * so there is no added delay. Input may arrive in chunks of any size.
+ */
+class Resampler {
+public:
+    static constexpr int MAX_PHASES = 4096;
+
+    /**
+     * @param inRate Input sample rate in Hz
+     * @param outRate Output sample rate in Hz
+     */
+    Resampler(int inRate, int outRate);
+
+    int getInputRate() const { return inRate; }
+    int getOutputRate() const { return outRate; }
+
+    /**
+     * @brief Resample the next chunk of input, appending to out
+     *
+     * Holds back the last few input samples until the filter can see past
+     * them; flush() releases them at the end of the stream.
+     */
+    void process(const float* in, size_t count, std::vector<float>& out);
+
+    /**
+     * @brief Finish the stream (the input is taken as zero beyond its end)
+     */
+    void flush(std::vector<float>& out);
+
+    /**
+     * @brief Resample a whole signal in one call
+     */
+    std::vector<float> process(const std::vector<float>& in);
+
+private:
+    int inRate;
+    int outRate;
+    uint64_t up;                // L
+    uint64_t down;              // M
+    int taps;                   // Per phase, a multiple of 8
+    int phases;                 // min(L, MAX_PHASES)
+    std::vector<float> table;   // phases * taps, phase-major
+
+    // Streaming state: buffer[0] is input sample bufferStart
+    std::vector<float> buffer;
+    int64_t bufferStart;
+    uint64_t inputCount;        // Input samples received
+    uint64_t outputCount;       // Output samples produced
+
+    void produce(std::vector<float>& out, uint64_t available);
+};
+
+#endif // RESAMPLER_H
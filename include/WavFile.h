@@ -4,15 +4,68 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstdio>
 
 /**
  * @brief WAV file handler for reading and writing audio files
  */
 class WavFile {
 public:
+    /**
+     * @brief Sample encoding of a PCM view
+     */
+    enum SampleFormat {
+        FORMAT_UINT8,
+        FORMAT_INT16,
+        FORMAT_INT24,
+        FORMAT_INT32,
+        FORMAT_FLOAT32
+    };
+
+    /**
+     * @brief Zero-copy view of the sample data of a memory-mapped WAV file
+     *
+     * Valid until unmap(), the next map() or destruction of the WavFile.
+     */
+    struct PcmView {
+        const uint8_t* data;    // First byte of the data chunk
+        size_t frames;          // Samples per channel
+        int channels;
+        int sampleRate;
+        int bytesPerSample;
+        SampleFormat format;
+    };
+
     WavFile();
     ~WavFile();
 
+    /**
+     * @brief Select the sample format used by write()/beginWrite()
+     *
+     * FORMAT_INT16 (default), FORMAT_INT24 or FORMAT_FLOAT32. Raw "-" output
+     * uses the same encoding.
+     * @return false if the format cannot be written
+     */
+    bool setOutputFormat(SampleFormat format);
+    SampleFormat getOutputFormat() const { return outFormat; }
+
+    /**
+     * @brief Enable TPDF dither when quantizing to integer PCM (off by default)
+     */
+    void setDither(bool enable) { dither = enable; }
+
+    /**
+     * @brief Sample format of raw (headerless) input read by beginRead()
+     *
+     * FORMAT_INT16 by default; a WAV stream's own header takes precedence.
+     */
+    void setRawFormat(SampleFormat format) { rawFormat = format; }
+
+    /**
+     * @brief Print the "Wrote N samples" / "Read N samples" lines (on by default)
+     */
+    void setVerbose(bool enable) { verbose = enable; }
+
     /**
      * @brief Write audio samples to a WAV file
      * @param filename Output file path
@@ -26,6 +79,92 @@ public:
                int sampleRate = 44100,
                int channels = 1);
 
+    /**
+     * @brief Start writing a WAV file incrementally
+     *
+     * The RIFF sizes are written as placeholders and patched by endWrite().
+     * A filename of "-" streams raw little-endian PCM in the same format to stdout instead.
+     * @param filename Output file path or "-"
+     * @param sampleRate Sample rate in Hz
+     * @param channels Number of channels
+     * @return true if successful, false otherwise
+     */
+    bool beginWrite(const std::string& filename, int sampleRate = 44100, int channels = 1);
+
+    /**
+     * @brief Most samples (all channels) a WAV file in the output format can
+     * hold: its RIFF sizes are 32-bit. Raw output has no limit.
+     */
+    uint64_t getMaxSamples() const;
+
+    /**
+     * @brief Append samples to the file opened with beginWrite()
+     * @param samples Audio sample data (normalized -1.0 to 1.0)
+     * @param count Number of samples
+     * @return false on a write error, or if a WAV file would outgrow getMaxSamples()
+     */
+    bool writeSamples(const float* samples, size_t count);
+
+    /**
+     * @brief Finish the file opened with beginWrite() and patch its header
+     * @return true if successful, false otherwise
+     */
+    bool endWrite();
+
+    /**
+     * @brief Open a WAV file, FIFO or stdin ("-") for incremental reading
+     *
+     * Input starting with "RIFF" is parsed as a WAV stream (chunks before
+     * "data" are skipped and the data size is ignored, so live captures with
+     * an unknown length work) in any sample format map() accepts. Anything
+     * else is taken as raw little-endian PCM in the setRawFormat() format
+     * (16-bit by default) described by the sampleRate/channels passed in.
+     * @param filename Input path or "-"
+     * @param sampleRate In: rate of raw input; out: stream sample rate
+     * @param channels In: channels of raw input; out: stream channels
+     * @return true if successful, false otherwise
+     */
+    bool beginRead(const std::string& filename, int& sampleRate, int& channels);
+
+    /**
+     * @brief Read whatever samples are available, blocking until at least one
+     * @param samples Output buffer (interleaved, normalized -1.0 to 1.0)
+     * @param maxSamples Buffer capacity in samples
+     * @return Number of samples read, 0 at end of stream, -1 on error
+     */
+    long readSamples(float* samples, size_t maxSamples);
+
+    /**
+     * @brief Close the stream opened with beginRead()
+     */
+    void endRead();
+
+    /**
+     * @brief Memory-map a WAV file and locate its sample data
+     *
+     * Walks the RIFF chunk list, so LIST/fact/etc. chunks before "data" are
+     * skipped. Accepts 8/16/24/32-bit integer PCM and 32-bit IEEE float,
+     * including WAVE_FORMAT_EXTENSIBLE headers.
+     * @param filename Input file path
+     * @param view Output view of the PCM data
+     * @return true if successful, false otherwise
+     */
+    bool map(const std::string& filename, PcmView& view);
+
+    /**
+     * @brief Release the mapping created by map()
+     */
+    void unmap();
+
+    /**
+     * @brief Bulk-convert interleaved samples of a view to float (-1.0 to 1.0)
+     * @param view PCM view from map()
+     * @param first Index of the first interleaved sample
+     * @param count Number of interleaved samples
+     * @param out Output buffer of count floats
+     */
+    static void convertToFloat(const PcmView& view, size_t first, size_t count, float* out);
+
     /**
      * @brief Read audio samples from a WAV file
      * @param filename Input file path
@@ -56,7 +195,36 @@ private:
         uint32_t dataSize;      // Data size
     };
 
-    void prepareHeader(WavHeader& header, int numSamples, int sampleRate, int channels);
+    void prepareHeader(WavHeader& header, uint64_t frames, int sampleRate, int channels);
+    void encodeBlock(const float* samples, size_t count, uint8_t* out);
+
+    // Output options
+    SampleFormat outFormat;
+    bool dither;
+    bool verbose;
+
+    // Incremental writer state
+    std::FILE* outFile;
+    std::string outName;
+    bool rawOutput;             // Headerless PCM (stdout)
+    int outSampleRate;
+    int outChannels;
+    uint64_t samplesWritten;
+    std::vector<uint8_t> pcmBuffer;
+
+    // Memory-mapped input
+    void* mappedData;
+    size_t mappedSize;
+
+    // Incremental reader state
+    int inFd;
+    bool ownsInFd;
+    SampleFormat rawFormat;
+    SampleFormat inFormat;
+    std::vector<uint8_t> inBuffer;  // Holds a trailing partial sample between reads
+    size_t inPending;
+
+    bool readExact(uint8_t* data, size_t length);
 };
 
 #endif // WAV_FILE_H
@@ -0,0 +1,36 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief Runs a batch of independent jobs on a fixed set of worker threads
+ *
+ * Job indices are dealt round-robin onto one deque per worker. A worker
+ * takes its own jobs from the front, in the order given, and once its deque
+ * is empty steals from the back of the others', so the tail of a long run
+ * is shared out instead of waiting on one busy thread. Callers that list
+ * the largest jobs first get longest-job-first scheduling.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @param threads Worker count (0 = one per core)
+     */
+    explicit WorkStealingPool(int threads = 0);
+
+    int size() const { return numThreads; }
+
+    /**
+     * @brief Run jobs 0..count-1 and wait for all of them
+     * @param job Called as job(index, worker); worker is in [0, size()) and
+     *            identifies the calling thread, for per-worker state
+     */
+    void run(size_t count, const std::function<void(size_t, int)>& job);
+
+private:
+    int numThreads;
+};
+
+#endif // WORK_STEALING_POOL_H
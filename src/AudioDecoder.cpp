@@ -1,7 +1,550 @@
 #include "AudioDecoder.h"
+#include "Console.h"
+#include "Metrics.h"
+#include "Resampler.h"
+#include "Fountain.h"
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+namespace {
+
+std::string makeOutputPath(const std::string& outputDir, const std::string& filename) {
+    std::string outputPath = outputDir;
+    if (!outputPath.empty() && outputPath.back() != '/' && outputPath.back() != '\\') {
+        outputPath += "/";
+    }
+    outputPath += filename;
+    return outputPath;
+}
+
+// MIN_CAPTURE_RATE covers the stream header; the profile it names may use
+// higher tones, which a capture holds only below half its sample rate
+bool captureHoldsProfile(int captureRate, const AudioModulator::StreamHeader& header) {
+    if (header.modulation != AudioModulator::MOD_FSK) {
+        return true;
+    }
+    const int top = AudioModulator::topFrequency(header.profile);
+    if (2 * top < captureRate) {
+        return true;
+    }
+    Console::error() << "Error: The " << AudioModulator::profileInfo(header.profile).name
+              << " profile sends tones up to " << top << " Hz; a " << captureRate
+              << " Hz capture only holds tones below " << captureRate / 2 << " Hz" << std::endl;
+    return false;
+}
+
+/**
+ * @brief Incremental parser for the data packet that writes file data as it arrives
+ */
+class PacketStreamWriter {
+public:
+    enum State { MAGIC, NAME_LENGTH, NAME, CODEC, ORIGINAL_LENGTH, DATA_LENGTH, DATA, CRC, DONE, FAILED };
+
+    explicit PacketStreamWriter(const std::string& outputDir)
+        : state(MAGIC), outputDir(outputDir), fieldPos(0), nameLength(0), compressed(false),
+          codec(Compressor::CODEC_NONE), originalLength(0), dataLength(0), dataReceived(0),
+          dataWritten(0), storedCrc(0), crc(ErrorCorrection::CRC32_INIT) {}
+
+    State getState() const { return state; }
+    const std::string& getPath() const { return path; }
+    uint32_t getDataLength() const { return dataLength; }
+    uint32_t getDataWritten() const { return dataWritten; }
+    bool crcMatches() const { return state == DONE && storedCrc == ErrorCorrection::finalizeCRC32(crc); }
+    uint32_t getCalculatedCrc() const { return ErrorCorrection::finalizeCRC32(crc); }
+    uint32_t getStoredCrc() const { return storedCrc; }
+
+    /**
+     * @brief Consume decoded packet bytes; the output file is opened once the
+     * filename is known and each data span is written and flushed immediately.
+     * Compressed data is collected and written once the CRC has arrived.
+     */
+    void feed(const uint8_t* data, size_t length) {
+        const uint8_t* end = data + length;
+        while (data < end && state != DONE && state != FAILED) {
+            switch (state) {
+                case MAGIC:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    if (fieldPos == 3 && *data == 'Z') {
+                        compressed = true;
+                        data++;
+                        fieldPos++;
+                    } else if (*data++ != "AEDC"[fieldPos]) {
+                        Console::error() << "Error: Invalid magic number" << std::endl;
+                        state = FAILED;
+                        break;
+                    } else {
+                        fieldPos++;
+                    }
+                    if (fieldPos == 4) {
+                        state = NAME_LENGTH;
+                    }
+                    break;
+                case NAME_LENGTH:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    nameLength = *data++;
+                    filename.clear();
+                    state = nameLength ? NAME : afterName();
+                    fieldPos = 0;
+                    break;
+                case NAME:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    filename += static_cast<char>(*data++);
+                    if (filename.size() == nameLength) {
+                        state = afterName();
+                    }
+                    break;
+                case CODEC:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    codec = static_cast<Compressor::Codec>(*data++);
+                    if (codec != Compressor::CODEC_NONE && codec != Compressor::CODEC_LZRC) {
+                        Console::error() << "Error: Unknown compression codec " << (int)codec << std::endl;
+                        state = FAILED;
+                        break;
+                    }
+                    state = ORIGINAL_LENGTH;
+                    break;
+                case ORIGINAL_LENGTH:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    originalLength |= static_cast<uint32_t>(*data++) << (8 * fieldPos);
+                    if (++fieldPos == 4) {
+                        fieldPos = 0;
+                        state = DATA_LENGTH;
+                    }
+                    break;
+                case DATA_LENGTH:
+                    crc = ErrorCorrection::updateCRC32(crc, data, 1);
+                    dataLength |= static_cast<uint32_t>(*data++) << (8 * fieldPos);
+                    if (++fieldPos == 4) {
+                        fieldPos = 0;
+                        path = makeOutputPath(outputDir, filename);
+                        file.open(path, std::ios::binary);
+                        if (!file.is_open()) {
+                            Console::error() << "Error: Could not create output file: " << path << std::endl;
+                            state = FAILED;
+                            break;
+                        }
+                        Console::info() << "Receiving " << filename << " (";
+                        if (compressed) {
+                            Console::info() << originalLength << " bytes, " << dataLength << " compressed";
+                        } else {
+                            Console::info() << dataLength << " bytes";
+                        }
+                        Console::info() << ")" << std::endl;
+                        state = dataLength ? DATA : CRC;
+                    }
+                    break;
+                case DATA: {
+                    size_t n = std::min<size_t>(end - data, dataLength - dataReceived);
+                    crc = ErrorCorrection::updateCRC32(crc, data, n);
+                    if (compressed) {
+                        payload.insert(payload.end(), data, data + n);
+                    } else {
+                        file.write(reinterpret_cast<const char*>(data), n);
+                        dataWritten += n;
+                    }
+                    data += n;
+                    dataReceived += n;
+                    if (dataReceived == dataLength) {
+                        state = CRC;
+                    }
+                    break;
+                }
+                case CRC:
+                    storedCrc |= static_cast<uint32_t>(*data++) << (8 * fieldPos);
+                    if (++fieldPos == 4) {
+                        state = compressed ? writeDecompressed() : DONE;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (file.is_open()) {
+            file.flush();
+            if (state == DONE || state == FAILED) {
+                file.close();
+            }
+        }
+    }
+
+private:
+    State state;
+    std::string outputDir;
+    size_t fieldPos;
+    uint8_t nameLength;
+    std::string filename;
+    std::string path;
+    bool compressed;
+    Compressor::Codec codec;
+    uint32_t originalLength;
+    std::vector<uint8_t> payload;   // Compressed data, kept until complete
+    uint32_t dataLength;
+    uint32_t dataReceived;
+    uint32_t dataWritten;
+    uint32_t storedCrc;
+    uint32_t crc;
+    std::ofstream file;
+
+    State afterName() const { return compressed ? CODEC : DATA_LENGTH; }
+
+    State writeDecompressed() {
+        std::vector<uint8_t> fileData;
+        if (codec == Compressor::CODEC_NONE) {
+            fileData.swap(payload);
+        } else if (!Compressor::decompress(payload.data(), payload.size(), originalLength, fileData)) {
+            Console::error() << "Error: Decompression failed (" << Compressor::codecName(codec) << ")" << std::endl;
+            return FAILED;
+        }
+        file.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+        dataWritten = static_cast<uint32_t>(fileData.size());
+        return DONE;
+    }
+};
+
+/**
+ * @brief Gathers fountain frames across transmissions until the file can be solved
+ */
+class FountainCollector {
+public:
+    explicit FountainCollector(const std::string& outputDir)
+        : outputDir(outputDir), named(false), done(false), crcOk(false), fileCrc(0) {}
+
+    bool isStarted() const { return code != nullptr; }
+    bool isDone() const { return done; }
+    const std::string& getPath() const { return path; }
+    uint32_t getFileLength() const { return info.length; }
+    uint32_t getCalculatedCrc() const { return fileCrc; }
+    bool crcMatches() const { return crcOk; }
+
+    /**
+     * @brief Name the broadcast; a different file starts a new collection
+     */
+    void setInfo(const Framer::FileInfo& next) {
+        bool same = code && next.length == info.length && (!named || next.crc == info.crc);
+        if (!same) {
+            reset(next.length);
+        }
+        info = next;
+        named = true;
+    }
+
+    void add(const Framer::Frame& frame) {
+        // A fountain frame's offset field carries the file length
+        if (!code || frame.offset != info.length) {
+            reset(frame.offset);
+        }
+        if (!done) {
+            code->addSymbol(frame.sequence, frame.payload);
+        }
+    }
+
+    /**
+     * @brief Solve for the file once enough frames are in, and write it
+     * @return true if the file was written by this call
+     */
+    bool tryDecode() {
+        if (!code || done) {
+            return false;
+        }
+        Console::info() << "Fountain: " << code->getReceived() << " frames received, "
+                  << code->getSourceSymbols() << " needed at least" << std::endl;
+        if (code->getReceived() < code->getSourceSymbols()) {
+            return false;
+        }
+        if (!named) {
+            Console::info() << "Fountain: waiting for a file frame to name the file" << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> data;
+        {
+            Metrics::Scope stage("fountain_decode");
+            stage.addBytes(info.length);
+            if (!code->decode(data)) {
+                Console::info() << "Fountain: not solvable yet, listening for more frames" << std::endl;
+                return false;
+            }
+        }
+        Metrics::count("fountain_inactivated", code->getInactivated());
+        
+        fileCrc = ErrorCorrection::calculateCRC32(data);
+        crcOk = fileCrc == info.crc;
+        path = makeOutputPath(outputDir, info.filename);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+        if (!out) {
+            Console::error() << "Error: Could not write output file: " << path << std::endl;
+            return false;
+        }
+        done = true;
+        if (crcOk) {
+            Console::info() << "✓ CRC32 verified: 0x" << std::hex << fileCrc << std::dec << std::endl;
+        } else {
+            Console::error() << "Warning: CRC32 mismatch! Stored: 0x" << std::hex << info.crc
+                      << ", Calculated: 0x" << fileCrc << std::dec << std::endl;
+        }
+        Console::info() << "Wrote " << info.length << " bytes to " << path << std::endl;
+        return true;
+    }
+
+    /**
+     * @brief Why the broadcast ended without a file
+     */
+    void reportIncomplete() const {
+        if (code && !done) {
+            Console::error() << "Error: Fountain broadcast ended with " << code->getReceived() << " of at least "
+                      << code->getSourceSymbols() << " frames needed" << std::endl;
+        }
+    }
+
+private:
+    std::string outputDir;
+    std::unique_ptr<Fountain> code;
+    bool named;
+    bool done;
+    Framer::FileInfo info;
+    std::string path;
+    bool crcOk;
+    uint32_t fileCrc;
+
+    void reset(uint32_t length) {
+        code.reset(new Fountain(length, Framer::PAYLOAD_SIZE));
+        info = Framer::FileInfo();
+        info.length = length;
+        named = false;
+        done = false;
+    }
+};
+
+/**
+ * @brief Collects the frames of a framed transmission and writes each at its offset
+ *
+ * Decoded bytes are scanned for frames, so a frame is found again after
+ * garbled bytes. Data frames seen before the file frame are held until the
+ * file is named. An existing output file of the announced length is
+ * patched in place rather than replaced, so a resend of the missing ranges
+ * completes an earlier partial file.
+ */
+class FrameStreamWriter {
+public:
+    /**
+     * @param fountain Receives fountain frames; without one they are ignored
+     */
+    explicit FrameStreamWriter(const std::string& outputDir, FountainCollector* fountain = nullptr)
+        : outputDir(outputDir), fountain(fountain), named(false), opened(false), framesWritten(0),
+          fountainFrames(0), crcOk(false), fileCrc(0) {}
+
+    bool hasFile() const { return named; }
+    const std::string& getPath() const { return path; }
+    uint32_t getFileLength() const { return info.length; }
+    uint32_t getStoredCrc() const { return info.crc; }
+    uint32_t getCalculatedCrc() const { return fileCrc; }
+    bool crcMatches() const { return crcOk; }
+    uint32_t getFramesWritten() const { return framesWritten; }
+
+    /**
+     * @brief A fountain broadcast transmission: its frames went to the collector
+     */
+    bool isFountain() const {
+        return (named && info.fountain) || (fountainFrames > 0 && framesWritten == 0 && early.empty());
+    }
+
+    /**
+     * @brief Consume decoded bytes in order; frames may straddle calls
+     */
+    void feed(const uint8_t* data, size_t length) {
+        pending.insert(pending.end(), data, data + length);
+        size_t pos = 0;
+        Framer::Frame frame;
+        while (pos + Framer::FRAME_SIZE <= pending.size()) {
+            // Past a damaged frame, step a byte at a time to the next marker
+            if (Framer::readFrame(pending.data() + pos, frame)) {
+                accept(frame);
+                pos += Framer::FRAME_SIZE;
+            } else {
+                pos++;
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + pos);
+    }
+
+    /**
+     * @brief End of transmission: size the file, find the gaps and check the CRC
+     * @return false if the file frame never arrived
+     */
+    bool finish() {
+        Metrics::count("frames_ok", framesWritten);
+        Metrics::count("fountain_frames", fountainFrames);
+        if (isFountain()) {
+            return true;
+        }
+        if (!named) {
+            Console::error() << "Error: File frame lost; " << early.size()
+                      << " data frames received but the file cannot be named" << std::endl;
+            return false;
+        }
+        
+        // The file always ends up at its announced length; gaps read as zeros
+        ensureOpen();
+        file.close();
+        std::error_code error;
+        if (std::filesystem::file_size(path, error) != info.length && !error) {
+            std::filesystem::resize_file(path, info.length, error);
+        }
+        
+        missing.clear();
+        for (uint32_t i = 0; i < received.size(); i++) {
+            if (received[i]) {
+                continue;
+            }
+            uint64_t first = static_cast<uint64_t>(i) * Framer::PAYLOAD_SIZE;
+            uint64_t last = std::min<uint64_t>(first + Framer::PAYLOAD_SIZE, info.length) - 1;
+            if (!missing.empty() && missing.back().last + 1 == first) {
+                missing.back().last = last;
+            } else {
+                missing.push_back({first, last});
+            }
+        }
+        
+        // Read back what is on disk: an earlier pass may have filled the gaps
+        std::ifstream in(path, std::ios::binary);
+        std::vector<uint8_t> chunk(64 * 1024);
+        uint32_t crc = ErrorCorrection::CRC32_INIT;
+        while (in.read(reinterpret_cast<char*>(chunk.data()), chunk.size()) || in.gcount() > 0) {
+            crc = ErrorCorrection::updateCRC32(crc, chunk.data(), in.gcount());
+        }
+        fileCrc = ErrorCorrection::finalizeCRC32(crc);
+        crcOk = fileCrc == info.crc;
+        if (crcOk) {
+            missing.clear();
+        }
+        return true;
+    }
+
+    /**
+     * @brief Byte ranges of the file this transmission did not deliver (after finish())
+     */
+    const std::vector<Framer::Range>& getMissing() const { return missing; }
+
+private:
+    std::string outputDir;
+    FountainCollector* fountain;
+    std::vector<uint8_t> pending;       // Bytes not yet scanned past
+    bool named;
+    bool opened;                        // Output file created (on the first data frame)
+    Framer::FileInfo info;
+    std::string path;
+    std::fstream file;
+    std::vector<bool> received;         // Per data frame
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> early;  // Data frames before the file frame
+    uint32_t framesWritten;
+    uint32_t fountainFrames;
+    bool crcOk;
+    uint32_t fileCrc;
+    std::vector<Framer::Range> missing;
+
+    void accept(const Framer::Frame& frame) {
+        if (frame.type == Framer::FRAME_FILE) {
+            Framer::FileInfo next;
+            if (!named && Framer::readFileInfo(frame, next)) {
+                open(next);
+                if (fountain && (info.fountain || fountainFrames > 0)) {
+                    fountain->setInfo(info);
+                }
+            }
+            return;
+        }
+        if (frame.type == Framer::FRAME_FOUNTAIN) {
+            if (fountain) {
+                if (named && fountainFrames == 0 && !info.fountain) {
+                    fountain->setInfo(info);
+                }
+                fountain->add(frame);
+                fountainFrames++;
+            }
+            return;
+        }
+        uint32_t index = frame.sequence - 1;
+        if (!named) {
+            early.emplace_back(index, std::vector<uint8_t>(frame.payload, frame.payload + frame.length));
+            return;
+        }
+        write(index, frame.payload, frame.length);
+    }
+
+    void open(const Framer::FileInfo& next) {
+        info = next;
+        named = true;
+        path = makeOutputPath(outputDir, info.filename);
+        received.assign(Framer::dataFrames(info.length), false);
+        for (auto& frame : early) {
+            write(frame.first, frame.second.data(), frame.second.size());
+        }
+        early.clear();
+    }
+
+    // The file is created with the first data frame, so a fountain
+    // transmission's file frame leaves existing files alone
+    bool ensureOpen() {
+        if (opened) {
+            return file.is_open();
+        }
+        opened = true;
+        std::error_code error;
+        bool patch = std::filesystem::file_size(path, error) == info.length && !error;
+        if (!patch) {
+            std::ofstream create(path, std::ios::binary | std::ios::trunc);
+        }
+        file.open(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file.is_open()) {
+            Console::error() << "Error: Could not create output file: " << path << std::endl;
+        }
+        Console::info() << "Receiving " << info.filename << " (" << info.length << " bytes in "
+                  << received.size() << " frames" << (patch ? ", patching existing file" : "") << ")" << std::endl;
+        return file.is_open();
+    }
+
+    void write(uint32_t index, const uint8_t* data, size_t length) {
+        if (index >= received.size() || received[index] || !ensureOpen()) {
+            return;
+        }
+        uint64_t offset = static_cast<uint64_t>(index) * Framer::PAYLOAD_SIZE;
+        length = std::min<uint64_t>(length, info.length - offset);
+        file.seekp(offset);
+        file.write(reinterpret_cast<const char*>(data), length);
+        file.flush();
+        received[index] = true;
+        framesWritten++;
+    }
+};
+
+// Console report of a finished framed transmission
+void reportFrames(const FrameStreamWriter& writer) {
+    const std::vector<Framer::Range>& missing = writer.getMissing();
+    if (missing.empty()) {
+        Console::info() << "Received " << writer.getFramesWritten() << " data frames" << std::endl;
+    } else {
+        uint64_t bytes = 0;
+        for (const Framer::Range& range : missing) {
+            bytes += range.last - range.first + 1;
+        }
+        Console::error() << "Warning: " << bytes << " of " << writer.getFileLength()
+                  << " bytes missing in " << missing.size() << " ranges: "
+                  << Framer::formatRanges(missing) << std::endl;
+    }
+    if (writer.crcMatches()) {
+        Console::info() << "✓ CRC32 verified: 0x" << std::hex << writer.getCalculatedCrc() << std::dec << std::endl;
+    } else if (missing.empty()) {
+        Console::error() << "Warning: CRC32 mismatch! Stored: 0x" << std::hex << writer.getStoredCrc()
+                  << ", Calculated: 0x" << writer.getCalculatedCrc() << std::dec << std::endl;
+    }
+    Console::info() << "Wrote " << writer.getFileLength() << " bytes to " << writer.getPath() << std::endl;
+}
+
+}
 
 AudioDecoder::AudioDecoder() {}
 
@@ -11,24 +554,25 @@ bool AudioDecoder::parseDataPacket(const std::vector<uint8_t>& packet,
                                    std::string& filename,
                                    std::vector<uint8_t>& fileData) {
     if (packet.size() < 14) { // Minimum packet size
-        std::cerr << "Error: Packet too small" << std::endl;
+        Console::error() << "Error: Packet too small" << std::endl;
         return false;
     }
     
     size_t pos = 0;
     
-    // Verify magic number
-    if (packet[pos++] != 'A' || packet[pos++] != 'E' || 
-        packet[pos++] != 'D' || packet[pos++] != 'C') {
-        std::cerr << "Error: Invalid magic number" << std::endl;
+    // Verify magic number ("AEDZ" for compressed data)
+    if (packet[pos++] != 'A' || packet[pos++] != 'E' || packet[pos++] != 'D' ||
+        (packet[pos] != 'C' && packet[pos] != 'Z')) {
+        Console::error() << "Error: Invalid magic number" << std::endl;
         return false;
     }
+    bool compressed = packet[pos++] == 'Z';
     
     // Read filename length
     uint8_t filenameLen = packet[pos++];
     
     if (pos + filenameLen + 4 > packet.size()) {
-        std::cerr << "Error: Invalid filename length" << std::endl;
+        Console::error() << "Error: Invalid filename length" << std::endl;
         return false;
     }
     
@@ -38,6 +582,24 @@ bool AudioDecoder::parseDataPacket(const std::vector<uint8_t>& packet,
         filename += static_cast<char>(packet[pos++]);
     }
     
+    // Codec and original length of compressed data
+    Compressor::Codec codec = Compressor::CODEC_NONE;
+    uint32_t originalLen = 0;
+    if (compressed) {
+        if (pos + 9 > packet.size()) {
+            Console::error() << "Error: Invalid compression header" << std::endl;
+            return false;
+        }
+        codec = static_cast<Compressor::Codec>(packet[pos++]);
+        for (int i = 0; i < 4; i++) {
+            originalLen |= static_cast<uint32_t>(packet[pos++]) << (8 * i);
+        }
+        if (codec != Compressor::CODEC_NONE && codec != Compressor::CODEC_LZRC) {
+            Console::error() << "Error: Unknown compression codec " << (int)codec << std::endl;
+            return false;
+        }
+    }
+    
     // Read file data length
     uint32_t fileDataLen = packet[pos++];
     fileDataLen |= (static_cast<uint32_t>(packet[pos++]) << 8);
@@ -45,7 +607,7 @@ bool AudioDecoder::parseDataPacket(const std::vector<uint8_t>& packet,
     fileDataLen |= (static_cast<uint32_t>(packet[pos++]) << 24);
     
     if (pos + fileDataLen + 4 > packet.size()) {
-        std::cerr << "Error: Invalid file data length" << std::endl;
+        Console::error() << "Error: Invalid file data length" << std::endl;
         return false;
     }
     
@@ -61,20 +623,35 @@ bool AudioDecoder::parseDataPacket(const std::vector<uint8_t>& packet,
     storedCrc |= (static_cast<uint32_t>(packet[pos++]) << 24);
     
     // Calculate CRC32 of packet (excluding CRC32 itself)
-    std::vector<uint8_t> packetForCrc(packet.begin(), packet.begin() + pos - 4);
-    uint32_t calculatedCrc = ErrorCorrection::calculateCRC32(packetForCrc);
+    uint32_t calculatedCrc = ErrorCorrection::calculateCRC32(packet.data(), pos - 4);
+    lastResult.crc = calculatedCrc;
+    lastResult.crcMatches = storedCrc == calculatedCrc;
+    Metrics::count("crc_ok", lastResult.crcMatches ? 1 : 0);
     
     if (storedCrc != calculatedCrc) {
-        std::cerr << "Warning: CRC32 mismatch! Stored: 0x" << std::hex << storedCrc 
+        Console::error() << "Warning: CRC32 mismatch! Stored: 0x" << std::hex << storedCrc 
                   << ", Calculated: 0x" << calculatedCrc << std::dec << std::endl;
-        std::cerr << "Data may be corrupted, but attempting to save anyway..." << std::endl;
+        Console::error() << "Data may be corrupted, but attempting to save anyway..." << std::endl;
     } else {
-        std::cout << "✓ CRC32 verified: 0x" << std::hex << calculatedCrc << std::dec << std::endl;
+        Console::info() << "✓ CRC32 verified: 0x" << std::hex << calculatedCrc << std::dec << std::endl;
     }
     
-    std::cout << "Parsed packet:" << std::endl;
-    std::cout << "  Filename: " << filename << std::endl;
-    std::cout << "  File size: " << fileDataLen << " bytes" << std::endl;
+    if (compressed && codec != Compressor::CODEC_NONE) {
+        Metrics::Scope stage("decompress");
+        std::vector<uint8_t> packed;
+        packed.swap(fileData);
+        stage.addBytes(packed.size());
+        if (!Compressor::decompress(packed.data(), packed.size(), originalLen, fileData)) {
+            Console::error() << "Error: Decompression failed (" << Compressor::codecName(codec) << ")" << std::endl;
+            return false;
+        }
+        Console::info() << "Decompressed " << packed.size() << " -> " << fileData.size() << " bytes ("
+                  << Compressor::codecName(codec) << ")" << std::endl;
+    }
+    
+    Console::info() << "Parsed packet:" << std::endl;
+    Console::info() << "  Filename: " << filename << std::endl;
+    Console::info() << "  File size: " << fileData.size() << " bytes" << std::endl;
     
     return true;
 }
@@ -82,88 +659,613 @@ bool AudioDecoder::parseDataPacket(const std::vector<uint8_t>& packet,
 bool AudioDecoder::writeOutputFile(const std::string& path, const std::vector<uint8_t>& data) {
     std::ofstream file(path, std::ios::binary);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not create output file: " << path << std::endl;
+        Console::error() << "Error: Could not create output file: " << path << std::endl;
         return false;
     }
     
     file.write(reinterpret_cast<const char*>(data.data()), data.size());
     file.close();
     
-    std::cout << "Wrote " << data.size() << " bytes to " << path << std::endl;
+    Console::info() << "Wrote " << data.size() << " bytes to " << path << std::endl;
     return true;
 }
 
 bool AudioDecoder::decodeFile(const std::string& inputFile, const std::string& outputDir) {
-    std::cout << "\n=== DECODING ===" << std::endl;
-    std::cout << "Input file: " << inputFile << std::endl;
-    std::cout << "Output directory: " << outputDir << std::endl;
+    Console::info() << "\n=== DECODING ===" << std::endl;
+    Console::info() << "Input file: " << inputFile << std::endl;
+    Console::info() << "Output directory: " << outputDir << std::endl;
+    lastResult = DecodeResult();
+    Metrics::Scope total("decode");
     
     // Read WAV file
     std::vector<float> audioSamples;
     int sampleRate, channels;
     
-    std::cout << "\nReading WAV file..." << std::endl;
-    if (!wavFile.read(inputFile, audioSamples, sampleRate, channels)) {
+    Console::info() << "\nReading WAV file..." << std::endl;
+    {
+        Metrics::Scope stage("wav_read");
+        if (!wavFile.read(inputFile, audioSamples, sampleRate, channels)) {
+            return false;
+        }
+        stage.addSamples(audioSamples.size());
+    }
+    
+    if (sampleRate < AudioModulator::MIN_CAPTURE_RATE) {
+        Console::error() << "Error: Sample rate " << sampleRate << " Hz is too low; stream headers need at least "
+                  << AudioModulator::MIN_CAPTURE_RATE << " Hz" << std::endl;
         return false;
     }
+    lastResult.audioSeconds = static_cast<double>(audioSamples.size()) / channels / sampleRate;
     
-    // Convert stereo to mono if necessary
-    if (channels == 2) {
-        std::cout << "Converting stereo to mono..." << std::endl;
-        std::vector<float> mono;
-        for (size_t i = 0; i < audioSamples.size(); i += 2) {
-            mono.push_back((audioSamples[i] + audioSamples[i + 1]) / 2.0f);
+    // Mix down to mono in place if necessary
+    if (channels > 1) {
+        Console::info() << "Mixing " << channels << " channels to mono..." << std::endl;
+        Metrics::Scope stage("mixdown");
+        stage.addSamples(audioSamples.size());
+        size_t frames = audioSamples.size() / channels;
+        const float scale = 1.0f / channels;
+        for (size_t f = 0; f < frames; f++) {
+            const float* frame = &audioSamples[f * channels];
+            float sum = 0.0f;
+            for (int c = 0; c < channels; c++) {
+                sum += frame[c];
+            }
+            audioSamples[f] = sum * scale;
         }
-        audioSamples = mono;
+        audioSamples.resize(frames);
+    }
+    
+    // The modem's tone grids and symbol lengths are defined at its own rate
+    if (sampleRate != modulator.getSampleRate()) {
+        Console::info() << "Resampling " << sampleRate << " Hz to " << modulator.getSampleRate() << " Hz..." << std::endl;
+        Metrics::Scope stage("resample");
+        stage.addSamples(audioSamples.size());
+        audioSamples = Resampler(sampleRate, modulator.getSampleRate()).process(audioSamples);
     }
     
     // Demodulate audio
-    std::cout << "\nDemodulating audio..." << std::endl;
-    std::vector<uint8_t> encodedData = modulator.demodulate(audioSamples);
+    Console::info() << "\nDemodulating audio..." << std::endl;
+    AudioModulator::StreamHeader streamHeader;
+    std::vector<uint8_t> encodedData;
+    std::vector<uint8_t> confidence;
+    {
+        Metrics::Scope stage("demodulate");
+        stage.addSamples(audioSamples.size());
+        encodedData = modulator.demodulate(audioSamples, &streamHeader, &confidence);
+        stage.addBytes(encodedData.size());
+    }
     
     if (encodedData.empty()) {
-        std::cerr << "Error: Failed to demodulate audio" << std::endl;
+        Console::error() << "Error: Failed to demodulate audio" << std::endl;
+        return false;
+    }
+    if (!captureHoldsProfile(sampleRate, streamHeader)) {
         return false;
     }
     
-    std::cout << "Demodulated " << encodedData.size() << " bytes" << std::endl;
+    Console::info() << "Demodulated " << encodedData.size() << " bytes" << std::endl;
+    
+    // Undo the interleaver; missing trailing symbols are zero filled with
+    // no confidence, so the group layout still lines up and they are the
+    // first to be erased
+    if (streamHeader.interleaveDepth > 1) {
+        Metrics::Scope stage("deinterleave");
+        stage.addBytes(streamHeader.dataLength);
+        encodedData.resize(streamHeader.dataLength, 0);
+        confidence.resize(streamHeader.dataLength, 0);
+        Interleaver interleaver(streamHeader.interleaveDepth, ErrorCorrection::ENCODED_BLOCK_SIZE);
+        encodedData = interleaver.deinterleave(encodedData);
+        confidence = interleaver.deinterleave(confidence);
+    }
     
     // Apply error correction
-    std::cout << "\nApplying error correction..." << std::endl;
-    std::vector<uint8_t> decodedData = errorCorrection.decode(encodedData);
+    Console::info() << "\nApplying error correction..." << std::endl;
+    ErrorCorrection::DecodeReport report;
+    std::vector<uint8_t> decodedData;
+    {
+        Metrics::Scope stage("fec");
+        stage.addBytes(encodedData.size());
+        decodedData = errorCorrection.decode(encodedData, &report, &confidence);
+    }
+    Metrics::count("rs_blocks", report.corrections.size());
+    Metrics::count("rs_blocks_corrected", report.correctedBlocks);
+    Metrics::count("rs_blocks_failed", report.failedBlocks);
+    Metrics::count("rs_symbols_corrected", report.correctedSymbols);
+    Metrics::count("rs_blocks_erasure_decoded", report.erasureBlocks);
+    if (Metrics::current()) {
+        // Per-block confidence map: how many symbols each block could have
+        // erased, and how many it did
+        const size_t blockSize = ErrorCorrection::ENCODED_BLOCK_SIZE;
+        for (size_t b = 0; b < report.corrections.size(); b++) {
+            size_t begin = std::min(confidence.size(), b * blockSize);
+            size_t end = std::min(confidence.size(), begin + blockSize);
+            Metrics::append("block_low_confidence",
+                            std::count_if(confidence.begin() + begin, confidence.begin() + end, [](uint8_t c) {
+                                return c < ErrorCorrection::ERASURE_THRESHOLD;
+                            }));
+            Metrics::append("block_erasures", report.erasures[b]);
+            Metrics::count("rs_symbols_erased", report.erasures[b]);
+        }
+    }
     
     if (decodedData.empty()) {
-        std::cerr << "Error: Failed to decode data (too many errors)" << std::endl;
+        Console::error() << "Error: Failed to decode data (no complete blocks)" << std::endl;
         return false;
     }
     
-    std::cout << "Decoded " << decodedData.size() << " bytes" << std::endl;
+    lastResult.correctedSymbols = report.correctedSymbols;
+    lastResult.failedBlocks = report.failedBlocks;
+    Console::info() << "Corrected " << report.correctedSymbols << " symbol errors in "
+              << report.correctedBlocks << " of " << report.corrections.size() << " blocks";
+    if (report.erasureBlocks > 0) {
+        Console::info() << " (" << report.erasureBlocks << " recovered with erasures)";
+    }
+    Console::info() << std::endl;
+    if (report.failedBlocks > 0) {
+        Console::error() << "Warning: " << report.failedBlocks << " blocks uncorrectable:";
+        for (size_t i = 0; i < report.corrections.size(); i++) {
+            if (report.corrections[i] < 0) {
+                Console::error() << " " << i;
+            }
+        }
+        Console::error() << std::endl;
+    }
+    
+    Console::info() << "Decoded " << decodedData.size() << " bytes" << std::endl;
+    
+    // A framed transmission keeps every intact frame, wherever the gaps are
+    if (Framer::isFramed(decodedData.data(), decodedData.size())) {
+        Console::info() << "\nWriting frames..." << std::endl;
+        FountainCollector fountain(outputDir);
+        FrameStreamWriter writer(outputDir, &fountain);
+        {
+            Metrics::Scope stage("write");
+            stage.addBytes(decodedData.size());
+            writer.feed(decodedData.data(), decodedData.size());
+            
+            // A fountain broadcast spans many transmissions, which the stream
+            // decoder follows from where this one ended; a WAV header
+            // overrides the raw format arguments
+            if (writer.isFountain()) {
+                Console::info() << "Fountain broadcast: decoding the transmissions that follow" << std::endl;
+                return decodeStream(inputFile, outputDir, 44100, 1, decodedData,
+                                    streamHeader.endSample - modulator.getSamplesPerSymbol());
+            }
+            if (!writer.finish()) {
+                return false;
+            }
+        }
+        reportFrames(writer);
+        Metrics::count("crc_ok", writer.crcMatches() ? 1 : 0);
+        lastResult.framed = true;
+        lastResult.outputPath = writer.getPath();
+        lastResult.fileBytes = writer.getFileLength();
+        lastResult.crc = writer.getCalculatedCrc();
+        lastResult.crcMatches = writer.crcMatches();
+        lastResult.missing = writer.getMissing();
+        total.addBytes(writer.getFileLength());
+        total.addSamples(audioSamples.size());
+        return true;
+    }
     
     // Parse data packet
     std::string filename;
     std::vector<uint8_t> fileData;
     
-    std::cout << "\nParsing data packet..." << std::endl;
-    if (!parseDataPacket(decodedData, filename, fileData)) {
-        std::cerr << "Error: Failed to parse data packet" << std::endl;
-        return false;
+    Console::info() << "\nParsing data packet..." << std::endl;
+    {
+        Metrics::Scope stage("parse");
+        stage.addBytes(decodedData.size());
+        if (!parseDataPacket(decodedData, filename, fileData)) {
+            Console::error() << "Error: Failed to parse data packet" << std::endl;
+            return false;
+        }
     }
     
     // Construct output path
-    std::string outputPath = outputDir;
-    if (!outputPath.empty() && outputPath.back() != '/' && outputPath.back() != '\\') {
-        outputPath += "/";
-    }
-    outputPath += filename;
+    std::string outputPath = makeOutputPath(outputDir, filename);
     
     // Write output file
-    std::cout << "\nWriting output file..." << std::endl;
-    if (!writeOutputFile(outputPath, fileData)) {
-        return false;
+    Console::info() << "\nWriting output file..." << std::endl;
+    {
+        Metrics::Scope stage("write");
+        stage.addBytes(fileData.size());
+        if (!writeOutputFile(outputPath, fileData)) {
+            return false;
+        }
     }
+    lastResult.outputPath = outputPath;
+    lastResult.fileBytes = fileData.size();
+    total.addBytes(fileData.size());
+    total.addSamples(audioSamples.size());
     
-    std::cout << "\n✓ Decoding complete!" << std::endl;
-    std::cout << "Output file: " << outputPath << std::endl;
+    Console::info() << "\n✓ Decoding complete!" << std::endl;
+    Console::info() << "Output file: " << outputPath << std::endl;
     
     return true;
 }
+
+bool AudioDecoder::decodeStream(const std::string& input, const std::string& outputDir,
+                                int sampleRate, int channels) {
+    return decodeStream(input, outputDir, sampleRate, channels, std::vector<uint8_t>(), 0);
+}
+
+bool AudioDecoder::decodeStream(const std::string& input, const std::string& outputDir,
+                                int sampleRate, int channels,
+                                const std::vector<uint8_t>& decoded, long resumeSample) {
+    Console::info() << "\n=== STREAM DECODING ===" << std::endl;
+    Console::info() << "Input: " << (input == "-" ? "stdin" : input) << std::endl;
+    Console::info() << "Output directory: " << outputDir << std::endl;
+    lastResult = DecodeResult();
+    Metrics::Scope total("decode_stream");
+    
+    if (!wavFile.beginRead(input, sampleRate, channels)) {
+        return false;
+    }
+    if (channels < 1) {
+        Console::error() << "Error: Invalid channel count " << channels << std::endl;
+        return false;
+    }
+    if (sampleRate < 1) {
+        Console::error() << "Error: Invalid sample rate " << sampleRate << std::endl;
+        return false;
+    }
+    if (sampleRate < AudioModulator::MIN_CAPTURE_RATE) {
+        Console::error() << "Error: Sample rate " << sampleRate << " Hz is too low; stream headers need at least "
+                  << AudioModulator::MIN_CAPTURE_RATE << " Hz" << std::endl;
+        return false;
+    }
+    Console::info() << "Sample rate: " << sampleRate << " Hz, Channels: " << channels << std::endl;
+    
+    // Captures at other rates are converted to the modem rate as they arrive
+    std::unique_ptr<Resampler> resampler;
+    if (sampleRate != modulator.getSampleRate()) {
+        Console::info() << "Resampling to " << modulator.getSampleRate() << " Hz" << std::endl;
+        resampler.reset(new Resampler(sampleRate, modulator.getSampleRate()));
+    }
+    Console::info() << "\nListening..." << std::endl;
+    
+    const long sps = modulator.getSamplesPerSymbol();
+    const long preambleLen = modulator.trailerSamples();
+    const long headerLen = modulator.headerSamples() - preambleLen;
+    const long searchWindow = preambleLen + 32768; // Unsearched samples needed per sync attempt
+    const size_t blockSymbols = ErrorCorrection::ENCODED_BLOCK_SIZE;
+    Interleaver interleaver;
+    
+    // Sliding window over the input: samples before pos are no longer needed
+    // and are dropped once they make up half the buffer
+    std::vector<float> buffer;
+    long pos = 0;
+    uint64_t bufferOrigin = 0;  // Stream index of buffer[0]
+    long skip = 0;              // Upcoming samples to drop (end preamble)
+    
+    bool syncing = true;
+    AudioModulator::TimingLoop clock(0, sps);  // Start of the next data symbol
+    long lookahead = 0;                 // Samples past a symbol its timing measurement reads
+    uint32_t bytesLeft = 0;             // Data bytes of the transmission still to come
+    AudioModulator::Modulation modulation = AudioModulator::MOD_FSK;
+    AudioModulator::ModemProfile profile = AudioModulator::PROFILE_STANDARD;
+    long symbolLen = sps;
+    size_t blockIndex = 0;
+    std::vector<uint8_t> group;         // Received bytes of the current interleaving group
+    std::vector<uint8_t> groupConfidence;
+    size_t groupLength = 0;
+    std::vector<uint8_t> blocks;        // The group after deinterleaving
+    std::vector<uint8_t> blockConfidence;
+    std::unique_ptr<PacketStreamWriter> packet;
+    std::unique_ptr<FrameStreamWriter> frames;
+    FountainCollector fountain(outputDir);  // Outlives transmissions: a broadcast spans many
+    int lastTone = -1;                  // Previous FSK symbol, its timing and whether it had a leading edge
+    double lastTiming = 0.0;
+    bool edged = false;
+    int untimed = 0;                    // Symbols since the last timing correction
+    int filesDecoded = 0;
+    
+    // Decode and write a group's blocks as soon as its last byte arrives
+    auto decodeGroup = [&]() {
+        blocks.resize(group.size());
+        blockConfidence.resize(group.size());
+        interleaver.deinterleave(group.data(), group.size(), blocks.data());
+        interleaver.deinterleave(groupConfidence.data(), group.size(), blockConfidence.data());
+        
+        for (size_t offset = 0; offset < blocks.size(); offset += blockSymbols) {
+            size_t length = std::min(blockSymbols, blocks.size() - offset);
+            uint8_t* block = blocks.data() + offset;
+            int erased = 0;
+            int corrected = errorCorrection.decodeBlock(block, (int)length, blockConfidence.data() + offset, &erased);
+            Metrics::count("rs_blocks");
+            if (erased > 0) {
+                Metrics::count("rs_blocks_erasure_decoded");
+                Metrics::count("rs_symbols_erased", erased);
+            }
+            if (corrected < 0) {
+                Metrics::count("rs_blocks_failed");
+                Console::error() << "Warning: Block " << blockIndex
+                          << " uncorrectable, writing raw data" << std::endl;
+            } else if (corrected > 0) {
+                Metrics::count("rs_blocks_corrected");
+                Metrics::count("rs_symbols_corrected", corrected);
+                Console::info() << "Block " << blockIndex << ": corrected "
+                          << corrected << " symbol errors";
+                if (erased > 0) {
+                    Console::info() << " (" << erased << " symbols erased)";
+                }
+                Console::info() << std::endl;
+            }
+            
+            // The first block tells a framed transmission from a data packet;
+            // a lost first block can only be recovered from if it was framed
+            size_t dataLength = std::min<size_t>(length, ErrorCorrection::RS_BLOCK_SIZE);
+            if (!packet && !frames) {
+                if (corrected < 0 || Framer::isFramed(block, dataLength)) {
+                    frames.reset(new FrameStreamWriter(outputDir, &fountain));
+                } else {
+                    packet.reset(new PacketStreamWriter(outputDir));
+                }
+            }
+            if (frames) {
+                frames->feed(block, dataLength);
+            } else {
+                packet->feed(block, dataLength);
+            }
+            blockIndex++;
+        }
+        
+        group.clear();
+        groupConfidence.clear();
+        groupLength = std::min<size_t>(interleaver.groupBytes(), bytesLeft);
+    };
+    
+    // Each fountain transmission may complete the file
+    auto finishFountain = [&]() {
+        frames->finish();
+        if (fountain.tryDecode()) {
+            Metrics::count("crc_ok", fountain.crcMatches() ? 1 : 0);
+            total.addBytes(fountain.getFileLength());
+            lastResult.outputPath = fountain.getPath();
+            lastResult.fileBytes = fountain.getFileLength();
+            lastResult.crc = fountain.getCalculatedCrc();
+            lastResult.crcMatches = fountain.crcMatches();
+            lastResult.framed = true;
+            lastResult.missing.clear();
+            filesDecoded++;
+        }
+    };
+    
+    // A framed file is written, complete or with gaps, once its transmission ends
+    auto finishFrames = [&]() {
+        if (!frames->finish()) {
+            return;
+        }
+        reportFrames(*frames);
+        Metrics::count("crc_ok", frames->crcMatches() ? 1 : 0);
+        total.addBytes(frames->getFileLength());
+        lastResult.outputPath = frames->getPath();
+        lastResult.fileBytes = frames->getFileLength();
+        lastResult.crc = frames->getCalculatedCrc();
+        lastResult.crcMatches = frames->crcMatches();
+        lastResult.framed = true;
+        lastResult.missing = frames->getMissing();
+        filesDecoded++;
+    };
+    
+    // A data packet's file, once its CRC has arrived or the input ended
+    auto recordPacket = [&]() {
+        lastResult.outputPath = packet->getPath();
+        lastResult.fileBytes = packet->getDataWritten();
+        lastResult.crc = packet->getCalculatedCrc();
+        lastResult.crcMatches = packet->crcMatches();
+        lastResult.framed = false;
+        lastResult.missing.clear();
+    };
+    
+    // The transmission decodeFile() already demodulated
+    if (!decoded.empty()) {
+        frames.reset(new FrameStreamWriter(outputDir, &fountain));
+        frames->feed(decoded.data(), decoded.size());
+        finishFountain();
+        frames.reset();
+        skip = resumeSample;
+        bufferOrigin = resumeSample;
+    }
+    
+    std::vector<float> readBuffer(4096 * channels);
+    std::vector<float> mono;
+    std::vector<float> converted;
+    float frameSum = 0.0f;
+    int frameFill = 0;
+    bool eof = false;
+    
+    while (!eof) {
+        long n = wavFile.readSamples(readBuffer.data(), readBuffer.size());
+        if (n <= 0) {
+            eof = true;
+        } else {
+            total.addSamples(n);
+            lastResult.audioSeconds += static_cast<double>(n) / channels / sampleRate;
+        }
+        
+        // Mix to mono
+        mono.clear();
+        for (long i = 0; i < n; i++) {
+            frameSum += readBuffer[i];
+            if (++frameFill == channels) {
+                mono.push_back(frameSum / channels);
+                frameSum = 0.0f;
+                frameFill = 0;
+            }
+        }
+        if (resampler) {
+            converted.clear();
+            resampler->process(mono.data(), mono.size(), converted);
+            if (eof) {
+                resampler->flush(converted);
+            }
+        }
+        for (float sample : resampler ? converted : mono) {
+            if (skip > 0) {
+                skip--;
+            } else {
+                buffer.push_back(sample);
+            }
+        }
+        
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            
+            if (syncing) {
+                long avail = (long)buffer.size() - pos;
+                if (avail < preambleLen + headerLen || (!eof && avail < searchWindow)) {
+                    break;
+                }
+                
+                long hit = modulator.findSync(buffer, pos);
+                if (hit < 0) {
+                    // Keep enough for a preamble straddling the next read
+                    pos = std::max(pos, (long)buffer.size() - preambleLen);
+                    break;
+                }
+                if (!eof && hit + preambleLen > (long)buffer.size()) {
+                    break; // A stronger peak may still follow
+                }
+                if (hit + headerLen > (long)buffer.size()) {
+                    break;
+                }
+                
+                AudioModulator::StreamHeader streamHeader;
+                long dataPos = modulator.readStreamHeader(buffer, hit, AudioModulator::SYNC_CHIRP, streamHeader);
+                if (dataPos < 0 || !captureHoldsProfile(sampleRate, streamHeader)) {
+                    pos = hit;
+                    progress = true;
+                    continue;
+                }
+                
+                Console::info() << "\nSync at sample " << bufferOrigin + hit - preambleLen
+                          << ", " << streamHeader.dataLength << " encoded bytes";
+                if (streamHeader.interleaveDepth > 1) {
+                    Console::info() << ", interleave depth " << streamHeader.interleaveDepth;
+                }
+                Console::info() << std::endl;
+                syncing = false;
+                bytesLeft = streamHeader.dataLength;
+                modulation = streamHeader.modulation;
+                profile = streamHeader.profile;
+                symbolLen = modulator.symbolSamples(modulation, profile);
+                clock = AudioModulator::TimingLoop(dataPos, symbolLen);
+                lookahead = modulator.timingLookahead(modulation, profile);
+                blockIndex = 0;
+                interleaver = Interleaver(streamHeader.interleaveDepth, blockSymbols);
+                group.clear();
+                groupConfidence.clear();
+                groupLength = std::min<size_t>(interleaver.groupBytes(), bytesLeft);
+                packet.reset();
+                frames.reset();
+                lastTone = -1;
+                edged = false;
+                untimed = 0;
+                pos = dataPos;
+                progress = true;
+            } else {
+                // Each symbol's timing corrects the clock for the next one
+                while (bytesLeft > 0 && clock.at() + symbolLen + (eof ? 0 : lookahead) <= (long)buffer.size()) {
+                    uint8_t symbol[AudioModulator::OFDM_SYMBOL_BYTES];
+                    uint8_t confidence[AudioModulator::OFDM_SYMBOL_BYTES];
+                    double timing;
+                    int n = modulator.readDataSymbol(buffer, clock.at(), modulation, profile, symbol,
+                                                     &timing, confidence);
+                    if (modulation == AudioModulator::MOD_OFDM) {
+                        clock.correct(timing);
+                    } else {
+                        // An FSK symbol is timed by its edges, so its measurement
+                        // waits for the next tone: a repeated tone has no edge
+                        if (edged && symbol[0] != lastTone) {
+                            clock.correct(lastTiming, untimed);
+                            untimed = 0;
+                        }
+                        edged = symbol[0] != lastTone;
+                        lastTone = symbol[0];
+                        lastTiming = timing;
+                        untimed++;
+                    }
+                    clock.advance();
+                    Metrics::count("symbols_decoded");
+                    
+                    // OFDM padding past the data length is dropped
+                    for (int i = 0; i < n && bytesLeft > 0; i++) {
+                        group.push_back(symbol[i]);
+                        groupConfidence.push_back(confidence[i]);
+                        bytesLeft--;
+                        if (group.size() == groupLength) {
+                            decodeGroup();
+                        }
+                    }
+                }
+                pos = std::max(0L, clock.at() - lookahead);
+                
+                if (bytesLeft == 0) {
+                    if (frames && frames->isFountain()) {
+                        finishFountain();
+                    } else if (frames) {
+                        finishFrames();
+                    } else if (packet && packet->getState() == PacketStreamWriter::DONE) {
+                        Metrics::count("crc_ok", packet->crcMatches() ? 1 : 0);
+                        total.addBytes(packet->getDataWritten());
+                        if (packet->crcMatches()) {
+                            Console::info() << "✓ CRC32 verified: 0x" << std::hex << packet->getCalculatedCrc()
+                                      << std::dec << std::endl;
+                        } else {
+                            Console::error() << "Warning: CRC32 mismatch! Stored: 0x" << std::hex
+                                      << packet->getStoredCrc() << ", Calculated: 0x"
+                                      << packet->getCalculatedCrc() << std::dec << std::endl;
+                        }
+                        Console::info() << "Wrote " << packet->getDataWritten() << " bytes to "
+                                  << packet->getPath() << std::endl;
+                        recordPacket();
+                        filesDecoded++;
+                    } else {
+                        Console::error() << "Error: Transmission ended before the packet was complete" << std::endl;
+                    }
+                    
+                    // Skip the end preamble so it is not taken for a new transmission,
+                    // short of its end: a clock that ended late must not step past
+                    // the first lag of a preamble that follows straight on
+                    syncing = true;
+                    pos = clock.at() + preambleLen - sps / 4;
+                    if (pos > (long)buffer.size()) {
+                        skip = pos - (long)buffer.size();
+                        pos = buffer.size();
+                    }
+                    progress = true;
+                }
+            }
+        }
+        
+        if (pos >= 65536 && pos * 2 >= (long)buffer.size()) {
+            buffer.erase(buffer.begin(), buffer.begin() + pos);
+            bufferOrigin += pos;
+            clock.rebase(pos);
+            pos = 0;
+        }
+    }
+    
+    wavFile.endRead();
+    
+    if (!syncing) {
+        Console::error() << "Error: Input ended mid-transmission with " << bytesLeft
+                  << " bytes outstanding" << std::endl;
+        if (frames && frames->isFountain()) {
+            finishFountain();
+        } else if (frames) {
+            finishFrames();
+        } else if (packet && packet->getDataWritten() > 0) {
+            Console::error() << "Partial output left in " << packet->getPath() << std::endl;
+            recordPacket();
+        }
+    }
+    
+    fountain.reportIncomplete();
+    
+    Console::info() << "\nStream ended: " << filesDecoded << " file(s) decoded" << std::endl;
+    return filesDecoded > 0;
+}
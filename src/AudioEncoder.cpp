@@ -1,9 +1,13 @@
 #include "AudioEncoder.h"
+#include "Console.h"
+#include "Metrics.h"
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <algorithm>
 
-AudioEncoder::AudioEncoder() {}
+AudioEncoder::AudioEncoder()
+    : interleaveDepth(8), compressMode(COMPRESS_AUTO), framed(false), fountain(false), fountainFrames(0) {}
 
 AudioEncoder::~AudioEncoder() {}
 
@@ -16,9 +20,10 @@ std::string AudioEncoder::extractFileName(const std::string& path) {
 }
 
 std::vector<uint8_t> AudioEncoder::readInputFile(const std::string& filename) {
+    Metrics::Scope stage("read");
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open input file: " << filename << std::endl;
+        Console::error() << "Error: Could not open input file: " << filename << std::endl;
         return std::vector<uint8_t>();
     }
     
@@ -31,14 +36,15 @@ std::vector<uint8_t> AudioEncoder::readInputFile(const std::string& filename) {
     std::vector<uint8_t> data(fileSize);
     file.read(reinterpret_cast<char*>(data.data()), fileSize);
     file.close();
+    stage.addBytes(fileSize);
     
-    std::cout << "Read " << fileSize << " bytes from " << filename << std::endl;
+    Console::info() << "Read " << fileSize << " bytes from " << filename << std::endl;
     return data;
 }
 
-std::vector<uint8_t> AudioEncoder::createDataPacket(const std::string& filename, 
-                                                     const std::vector<uint8_t>& fileData) {
-    std::vector<uint8_t> packet;
+std::vector<uint8_t> AudioEncoder::createPacketHeader(const std::string& filename, uint32_t fileDataLen,
+                                                      Compressor::Codec codec, uint32_t originalLen) {
+    std::vector<uint8_t> header;
     
     // Extract just the filename (not full path)
     std::string baseFilename = extractFileName(filename);
@@ -50,79 +56,616 @@ std::vector<uint8_t> AudioEncoder::createDataPacket(const std::string& filename,
     // [4 bytes: File data length]
     // [M bytes: File data]
     // [4 bytes: CRC32 checksum]
+    //
+    // The CRC trails the data, so a packet can be produced while streaming.
+    // Compressed packets use the magic "AEDZ" and carry a codec byte and the
+    // original file length (4 bytes) after the filename; the data length and
+    // CRC then refer to the compressed bytes.
     
     // Magic number
-    packet.push_back('A');
-    packet.push_back('E');
-    packet.push_back('D');
-    packet.push_back('C');
+    bool compressed = codec != Compressor::CODEC_NONE;
+    header.push_back('A');
+    header.push_back('E');
+    header.push_back('D');
+    header.push_back(compressed ? 'Z' : 'C');
     
     // Filename length and filename
     uint8_t filenameLen = std::min((size_t)255, baseFilename.length());
-    packet.push_back(filenameLen);
+    header.push_back(filenameLen);
     
     for (size_t i = 0; i < filenameLen; i++) {
-        packet.push_back(static_cast<uint8_t>(baseFilename[i]));
+        header.push_back(static_cast<uint8_t>(baseFilename[i]));
+    }
+    
+    if (compressed) {
+        header.push_back(static_cast<uint8_t>(codec));
+        for (int i = 0; i < 4; i++) {
+            header.push_back((originalLen >> (i * 8)) & 0xFF);
+        }
     }
     
     // File data length
-    uint32_t fileDataLen = fileData.size();
-    packet.push_back((fileDataLen >> 0) & 0xFF);
-    packet.push_back((fileDataLen >> 8) & 0xFF);
-    packet.push_back((fileDataLen >> 16) & 0xFF);
-    packet.push_back((fileDataLen >> 24) & 0xFF);
+    header.push_back((fileDataLen >> 0) & 0xFF);
+    header.push_back((fileDataLen >> 8) & 0xFF);
+    header.push_back((fileDataLen >> 16) & 0xFF);
+    header.push_back((fileDataLen >> 24) & 0xFF);
+    
+    Console::info() << "  Filename: " << baseFilename << " (" << (int)filenameLen << " bytes)" << std::endl;
+    if (compressed) {
+        Console::info() << "  File data: " << originalLen << " bytes, " << fileDataLen << " compressed ("
+                  << Compressor::codecName(codec) << ")" << std::endl;
+    } else {
+        Console::info() << "  File data: " << fileDataLen << " bytes" << std::endl;
+    }
     
-    // File data
-    packet.insert(packet.end(), fileData.begin(), fileData.end());
+    return header;
+}
+
+double AudioEncoder::secondsPerEncodedByte() const {
+    AudioModulator::Modulation mode = modulator.getModulation();
+    return static_cast<double>(modulator.symbolSamples(mode, modulator.getProfile())) /
+           (AudioModulator::symbolBytes(mode) * modulator.getSampleRate());
+}
+
+std::vector<uint8_t> AudioEncoder::createDataPacket(const std::string& filename, 
+                                                     const std::vector<uint8_t>& fileData) {
+    // Compress between packet creation and error correction when it pays off
+    std::vector<uint8_t> compressed;
+    bool useCompressed = false;
+    if (compressMode == COMPRESS_AUTO && modulator.getSyncMode() != AudioModulator::SYNC_CHIRP) {
+        Console::info() << "Compression: skipped (tone sync keeps the legacy packet format)" << std::endl;
+    } else if (compressMode == COMPRESS_AUTO && Compressor::looksCompressed(fileData.data(), fileData.size())) {
+        Console::info() << "Compression: skipped (already compressed format)" << std::endl;
+    } else if (compressMode != COMPRESS_OFF) {
+        {
+            Metrics::Scope stage("compress");
+            stage.addBytes(fileData.size());
+            compressed = Compressor::compress(fileData.data(), fileData.size());
+        }
+        
+        // Airtime is spent in whole RS blocks; the compressed header is 9 bytes longer
+        const size_t overhead = 4 + 1 + std::min<size_t>(255, extractFileName(filename).length()) + 4 + 4;
+        auto blocks = [&](size_t dataLength, size_t extra) {
+            return (overhead + extra + dataLength + ErrorCorrection::RS_BLOCK_SIZE - 1) /
+                   ErrorCorrection::RS_BLOCK_SIZE;
+        };
+        size_t rawBlocks = blocks(fileData.size(), 0);
+        size_t packedBlocks = blocks(compressed.size(), 5);
+        useCompressed = compressMode == COMPRESS_ON ? compressed.size() + 5 < fileData.size()
+                                                    : packedBlocks < rawBlocks;
+        
+        Console::info() << "Compression: " << fileData.size() << " -> " << compressed.size() << " bytes";
+        if (!fileData.empty()) {
+            Console::info() << " (" << (100 * compressed.size() / fileData.size()) << "%)";
+        }
+        if (useCompressed) {
+            double saved = static_cast<double>(rawBlocks - packedBlocks) *
+                           ErrorCorrection::ENCODED_BLOCK_SIZE * secondsPerEncodedByte();
+            Console::info() << ", " << rawBlocks - packedBlocks << " fewer RS blocks, saves "
+                      << saved << " s of airtime" << std::endl;
+        } else {
+            Console::info() << ", no airtime saved; sending uncompressed" << std::endl;
+        }
+    }
+    
+    std::vector<uint8_t> packet;
+    if (useCompressed) {
+        packet = createPacketHeader(filename, compressed.size(), Compressor::CODEC_LZRC,
+                                    static_cast<uint32_t>(fileData.size()));
+        packet.insert(packet.end(), compressed.begin(), compressed.end());
+    } else {
+        packet = createPacketHeader(filename, fileData.size());
+        packet.insert(packet.end(), fileData.begin(), fileData.end());
+    }
     
     // Calculate CRC32 for integrity check
     uint32_t crc = ErrorCorrection::calculateCRC32(packet);
+    lastResult.crc = crc;
+    lastResult.codec = useCompressed ? Compressor::CODEC_LZRC : Compressor::CODEC_NONE;
     packet.push_back((crc >> 0) & 0xFF);
     packet.push_back((crc >> 8) & 0xFF);
     packet.push_back((crc >> 16) & 0xFF);
     packet.push_back((crc >> 24) & 0xFF);
     
-    std::cout << "Created data packet: " << packet.size() << " bytes" << std::endl;
-    std::cout << "  Filename: " << baseFilename << " (" << (int)filenameLen << " bytes)" << std::endl;
-    std::cout << "  File data: " << fileDataLen << " bytes" << std::endl;
-    std::cout << "  CRC32: 0x" << std::hex << crc << std::dec << std::endl;
+    Console::info() << "Created data packet: " << packet.size() << " bytes" << std::endl;
+    Console::info() << "  CRC32: 0x" << std::hex << crc << std::dec << std::endl;
     
     return packet;
 }
 
+std::vector<uint8_t> AudioEncoder::createFrames(const std::string& filename,
+                                                 const std::vector<uint8_t>& fileData) {
+    if (compressMode == COMPRESS_ON) {
+        Console::info() << "Note: frames are sent uncompressed (each must decode on its own)" << std::endl;
+    }
+    
+    Framer::FileInfo info;
+    info.filename = extractFileName(filename);
+    info.length = static_cast<uint32_t>(fileData.size());
+    info.crc = ErrorCorrection::calculateCRC32(fileData);
+    
+    // The file frame opens and closes the transmission, so either copy names the file
+    uint32_t total = Framer::dataFrames(fileData.size());
+    uint32_t sent = Framer::coveredFrames(frameRanges, fileData.size());
+    std::vector<uint8_t> frames(static_cast<size_t>(sent + 2) * Framer::FRAME_SIZE);
+    uint8_t* out = frames.data();
+    Framer::writeFileFrame(info, out);
+    out += Framer::FRAME_SIZE;
+    for (uint32_t i = 0; i < total; i++) {
+        if (Framer::covers(frameRanges, i)) {
+            size_t offset = static_cast<size_t>(i) * Framer::PAYLOAD_SIZE;
+            Framer::writeDataFrame(i, fileData.data() + offset, fileData.size() - offset, out);
+            out += Framer::FRAME_SIZE;
+        }
+    }
+    Framer::writeFileFrame(info, out);
+    
+    lastResult.crc = info.crc;
+    lastResult.frames = sent + 2;
+    Console::info() << "  Filename: " << info.filename << std::endl;
+    Console::info() << "  File data: " << fileData.size() << " bytes" << std::endl;
+    Console::info() << "Created " << sent + 2 << " frames of " << Framer::FRAME_SIZE << " bytes";
+    if (sent < total) {
+        Console::info() << " (" << sent << " of " << total << " data frames, ranges "
+                  << Framer::formatRanges(frameRanges) << ")";
+    }
+    Console::info() << std::endl;
+    Console::info() << "  CRC32: 0x" << std::hex << info.crc << std::dec << std::endl;
+    
+    return frames;
+}
+
+void AudioEncoder::printDataRate() const {
+    AudioModulator::Modulation mode = modulator.getModulation();
+    AudioModulator::ModemProfile profile = modulator.getProfile();
+    double bitsPerSecond = 8.0 / secondsPerEncodedByte();
+    Console::info() << "Raw data rate: " << static_cast<int>(bitsPerSecond) << " bit/s (";
+    if (mode == AudioModulator::MOD_OFDM) {
+        Console::info() << "OFDM";
+    } else {
+        Console::info() << "FSK, " << AudioModulator::profileInfo(profile).name << " profile";
+    }
+    Console::info() << ")" << std::endl;
+}
+
+int AudioEncoder::effectiveInterleaveDepth() const {
+    if (modulator.getSyncMode() != AudioModulator::SYNC_CHIRP) {
+        return 1;
+    }
+    return std::max(1, std::min(interleaveDepth, Interleaver::MAX_DEPTH));
+}
+
 bool AudioEncoder::encodeFile(const std::string& inputFile, const std::string& outputFile) {
-    std::cout << "\n=== ENCODING ===" << std::endl;
-    std::cout << "Input file: " << inputFile << std::endl;
-    std::cout << "Output file: " << outputFile << std::endl;
+    if (fountain) {
+        return encodeFountain(inputFile, outputFile);
+    }
+    Console::info() << "\n=== ENCODING ===" << std::endl;
+    Console::info() << "Input file: " << inputFile << std::endl;
+    Console::info() << "Output file: " << outputFile << std::endl;
+    Metrics::Scope total("encode");
+    
+    std::vector<float> audioSamples = encodeSamples(inputFile);
+    if (audioSamples.empty()) {
+        return false;
+    }
+    total.addBytes(lastResult.inputBytes);
+    total.addSamples(audioSamples.size());
+    
+    // Write WAV file
+    Console::info() << "\nWriting WAV file..." << std::endl;
+    Metrics::Scope stage("wav_write");
+    stage.addSamples(audioSamples.size());
+    if (!wavFile.write(outputFile, audioSamples, modulator.getSampleRate(), 1)) {
+        return false;
+    }
+    
+    Console::info() << "\n✓ Encoding complete!" << std::endl;
+    return true;
+}
+
+std::vector<float> AudioEncoder::encodeSamples(const std::string& inputFile, std::vector<uint8_t>* symbols) {
+    lastResult = EncodeResult();
+    if (fountain) {
+        Console::error() << "Error: A fountain broadcast is many transmissions; use encodeFile()" << std::endl;
+        return std::vector<float>();
+    }
     
     // Read input file
     std::vector<uint8_t> fileData = readInputFile(inputFile);
     if (fileData.empty()) {
-        return false;
+        return std::vector<float>();
     }
     
     // Create data packet with metadata
-    std::vector<uint8_t> packet = createDataPacket(inputFile, fileData);
+    std::vector<uint8_t> packet;
+    {
+        Metrics::Scope stage("packet");
+        stage.addBytes(fileData.size());
+        packet = framed ? createFrames(inputFile, fileData) : createDataPacket(inputFile, fileData);
+    }
     
     // Apply error correction
-    std::cout << "\nApplying error correction..." << std::endl;
-    std::vector<uint8_t> encodedData = errorCorrection.encode(packet);
-    std::cout << "Encoded data size: " << encodedData.size() << " bytes" << std::endl;
+    Console::info() << "\nApplying error correction..." << std::endl;
+    std::vector<uint8_t> encodedData;
+    {
+        Metrics::Scope stage("fec");
+        stage.addBytes(packet.size());
+        encodedData = errorCorrection.encode(packet);
+    }
+    Metrics::count("rs_blocks_encoded", encodedData.size() / ErrorCorrection::ENCODED_BLOCK_SIZE +
+                                        (encodedData.size() % ErrorCorrection::ENCODED_BLOCK_SIZE != 0));
+    lastResult.inputBytes = fileData.size();
+    lastResult.packetBytes = packet.size();
+    lastResult.encodedBytes = encodedData.size();
+    Console::info() << "Encoded data size: " << encodedData.size() << " bytes" << std::endl;
+    
+    // Spread each block across its interleaving group
+    Interleaver interleaver(effectiveInterleaveDepth(), ErrorCorrection::ENCODED_BLOCK_SIZE);
+    if (interleaver.getDepth() > 1) {
+        Console::info() << "Interleave depth: " << interleaver.getDepth() << " blocks" << std::endl;
+        Metrics::Scope stage("interleave");
+        stage.addBytes(encodedData.size());
+        encodedData = interleaver.interleave(encodedData);
+    }
     
     // Modulate to audio
-    std::cout << "\nModulating to audio..." << std::endl;
-    std::vector<float> audioSamples = modulator.modulate(encodedData);
+    Console::info() << "\nModulating to audio..." << std::endl;
+    std::vector<float> audioSamples;
+    {
+        Metrics::Scope stage("modulate");
+        stage.addBytes(encodedData.size());
+        audioSamples = modulator.modulate(encodedData, interleaver.getDepth());
+        stage.addSamples(audioSamples.size());
+    }
     
     double duration = static_cast<double>(audioSamples.size()) / modulator.getSampleRate();
-    std::cout << "Audio duration: " << duration << " seconds" << std::endl;
-    std::cout << "Audio samples: " << audioSamples.size() << std::endl;
+    lastResult.audioSeconds = duration;
+    Console::info() << "Audio duration: " << duration << " seconds" << std::endl;
+    Console::info() << "Audio samples: " << audioSamples.size() << std::endl;
+    printDataRate();
     
-    // Write WAV file
-    std::cout << "\nWriting WAV file..." << std::endl;
-    if (!wavFile.write(outputFile, audioSamples, modulator.getSampleRate(), 1)) {
+    if (symbols) {
+        symbols->swap(encodedData);
+    }
+    return audioSamples;
+}
+
+bool AudioEncoder::encodeFileStreaming(const std::string& inputFile, const std::string& outputFile) {
+    if (fountain) {
+        return encodeFountain(inputFile, outputFile);
+    }
+    Console::info() << "\n=== ENCODING (streaming) ===" << std::endl;
+    Console::info() << "Input file: " << inputFile << std::endl;
+    Console::info() << "Output file: " << (outputFile == "-" ? "stdout (raw PCM)" : outputFile) << std::endl;
+    lastResult = EncodeResult();
+    Metrics::Scope total("encode_stream");
+    
+    std::ifstream file(inputFile, std::ios::binary);
+    if (!file.is_open()) {
+        Console::error() << "Error: Could not open input file: " << inputFile << std::endl;
         return false;
     }
     
-    std::cout << "\n✓ Encoding complete!" << std::endl;
+    // The length fields precede the data, so the size must be known up front
+    file.seekg(0, std::ios::end);
+    std::streamoff fileSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (fileSize <= 0) {
+        Console::error() << "Error: Input file is empty or not seekable: " << inputFile << std::endl;
+        return false;
+    }
+    if (fileSize > 0xFFFFFFFFLL) {
+        Console::error() << "Error: Input file too large: " << inputFile << std::endl;
+        return false;
+    }
+    
+    // Compression needs the whole file. In AUTO mode, judge from the first
+    // chunk whether encodeFile() would have compressed, so the cost is known
+    bool wouldCompress = compressMode == COMPRESS_ON;
+    if (compressMode == COMPRESS_AUTO && !framed && modulator.getSyncMode() == AudioModulator::SYNC_CHIRP) {
+        std::vector<uint8_t> sample(64 * 1024);
+        file.read(reinterpret_cast<char*>(sample.data()), sample.size());
+        sample.resize(file.gcount());
+        file.clear();
+        file.seekg(0, std::ios::beg);
+        wouldCompress = !Compressor::looksCompressed(sample.data(), sample.size()) &&
+                        Compressor::compress(sample.data(), sample.size()).size() + 5 +
+                        ErrorCorrection::RS_BLOCK_SIZE <= sample.size();
+    }
+    if (wouldCompress) {
+        Console::info() << "Note: --stream sends data uncompressed (compression needs the whole file)" << std::endl;
+    }
+    
+    std::vector<uint8_t> header;
+    Framer::FileInfo info;
+    uint64_t packetSize;
+    if (framed) {
+        // The leading file frame holds the CRC of the whole file, so the
+        // file is read twice
+        Console::info() << "\nCreating frames..." << std::endl;
+        info.filename = extractFileName(inputFile);
+        info.length = static_cast<uint32_t>(fileSize);
+        std::vector<uint8_t> chunk(64 * 1024);
+        uint32_t crc = ErrorCorrection::CRC32_INIT;
+        while (file.read(reinterpret_cast<char*>(chunk.data()), chunk.size()) || file.gcount() > 0) {
+            crc = ErrorCorrection::updateCRC32(crc, chunk.data(), file.gcount());
+        }
+        info.crc = ErrorCorrection::finalizeCRC32(crc);
+        file.clear();
+        file.seekg(0, std::ios::beg);
+        lastResult.frames = Framer::coveredFrames(frameRanges, fileSize) + 2;
+        packetSize = static_cast<uint64_t>(lastResult.frames) * Framer::FRAME_SIZE;
+        Console::info() << "  Filename: " << info.filename << std::endl;
+        Console::info() << "  File data: " << fileSize << " bytes in " << lastResult.frames << " frames" << std::endl;
+    } else {
+        Console::info() << "\nCreating data packet..." << std::endl;
+        header = createPacketHeader(inputFile, static_cast<uint32_t>(fileSize));
+        packetSize = header.size() + static_cast<uint64_t>(fileSize) + 4;
+    }
+    uint64_t numBlocks = (packetSize + ErrorCorrection::RS_BLOCK_SIZE - 1) / ErrorCorrection::RS_BLOCK_SIZE;
+    uint64_t encodedSize = numBlocks * ErrorCorrection::ENCODED_BLOCK_SIZE;
+    if (encodedSize > 0xFFFFFFFFULL) {
+        Console::error() << "Error: Encoded stream too large: " << encodedSize << " bytes" << std::endl;
+        return false;
+    }
+    lastResult.inputBytes = fileSize;
+    lastResult.packetBytes = packetSize;
+    lastResult.encodedBytes = encodedSize;
+    Console::info() << "Packet size: " << packetSize << " bytes in " << numBlocks << " blocks" << std::endl;
+    Console::info() << "Encoded data size: " << encodedSize << " bytes" << std::endl;
+    
+    // Refuse before writing anything rather than stop short of the end
+    uint64_t expectedSamples = modulator.headerSamples() + modulator.maxSymbolSamples(encodedSize) +
+                               modulator.trailerSamples();
+    if (outputFile != "-" && expectedSamples > wavFile.getMaxSamples()) {
+        Console::error() << "Error: " << expectedSamples / modulator.getSampleRate()
+                  << " s of audio is more than a WAV file can hold (4 GB); use - for raw PCM output" << std::endl;
+        return false;
+    }
+    
+    if (!wavFile.beginWrite(outputFile, modulator.getSampleRate(), 1)) {
+        return false;
+    }
+    
+    Interleaver interleaver(effectiveInterleaveDepth(), ErrorCorrection::ENCODED_BLOCK_SIZE);
+    if (interleaver.getDepth() > 1) {
+        Console::info() << "Interleave depth: " << interleaver.getDepth() << " blocks" << std::endl;
+    }
+    
+    // Preamble and stream header
+    AudioModulator::StreamHeader streamHeader;
+    streamHeader.dataLength = static_cast<uint32_t>(encodedSize);
+    streamHeader.interleaveDepth = interleaver.getDepth();
+    std::vector<float> samples(modulator.headerSamples());
+    modulator.writeHeader(streamHeader, samples.data());
+    bool ok = wavFile.writeSamples(samples.data(), samples.size());
+    
+    // Reed-Solomon encode each block as it fills; modulate once its
+    // interleaving group is complete
+    std::vector<uint8_t> block;
+    block.reserve(ErrorCorrection::RS_BLOCK_SIZE);
+    std::vector<uint8_t> group;
+    group.reserve(interleaver.groupBytes());
+    std::vector<uint8_t> interleaved(interleaver.groupBytes());
+    samples.resize(std::max(modulator.maxSymbolSamples(interleaver.groupBytes()),
+                            modulator.maxSymbolSamples(0) + modulator.trailerSamples()));
+    uint64_t totalSamples = modulator.headerSamples();
+    
+    auto flushGroup = [&]() {
+        interleaver.interleave(group.data(), group.size(), interleaved.data());
+        float* end = modulator.writeSymbols(interleaved.data(), group.size(), samples.data());
+        ok = ok && wavFile.writeSamples(samples.data(), end - samples.data());
+        totalSamples += end - samples.data();
+        group.clear();
+    };
+    
+    auto flushBlock = [&]() {
+        Metrics::count("rs_blocks_encoded");
+        std::vector<uint8_t> encoded = errorCorrection.encode(block);
+        group.insert(group.end(), encoded.begin(), encoded.end());
+        block.clear();
+        if (group.size() == interleaver.groupBytes()) {
+            flushGroup();
+        }
+    };
+    
+    auto feed = [&](const uint8_t* data, size_t length) {
+        while (length > 0 && ok) {
+            size_t n = std::min(length, ErrorCorrection::RS_BLOCK_SIZE - block.size());
+            block.insert(block.end(), data, data + n);
+            data += n;
+            length -= n;
+            if (block.size() == (size_t)ErrorCorrection::RS_BLOCK_SIZE) {
+                flushBlock();
+            }
+        }
+    };
+    
+    if (framed) {
+        // Each frame fills one Reed-Solomon block exactly
+        uint8_t frame[Framer::FRAME_SIZE];
+        Framer::writeFileFrame(info, frame);
+        feed(frame, Framer::FRAME_SIZE);
+        
+        uint8_t chunk[Framer::PAYLOAD_SIZE];
+        uint64_t remaining = fileSize;
+        for (uint32_t i = 0; remaining > 0 && ok; i++) {
+            size_t n = std::min<uint64_t>(Framer::PAYLOAD_SIZE, remaining);
+            remaining -= n;
+            if (!Framer::covers(frameRanges, i)) {
+                file.seekg(n, std::ios::cur);
+                continue;
+            }
+            file.read(reinterpret_cast<char*>(chunk), n);
+            if ((size_t)file.gcount() != n) {
+                Console::error() << "Error: Short read from " << inputFile << std::endl;
+                ok = false;
+                break;
+            }
+            Framer::writeDataFrame(i, chunk, n, frame);
+            feed(frame, Framer::FRAME_SIZE);
+        }
+        
+        Framer::writeFileFrame(info, frame);
+        feed(frame, Framer::FRAME_SIZE);
+        lastResult.crc = info.crc;
+    } else {
+        uint32_t crc = ErrorCorrection::updateCRC32(ErrorCorrection::CRC32_INIT, header.data(), header.size());
+        feed(header.data(), header.size());
+        
+        std::vector<uint8_t> chunk(64 * 1024);
+        uint64_t remaining = fileSize;
+        while (remaining > 0 && ok) {
+            size_t n = std::min<uint64_t>(chunk.size(), remaining);
+            file.read(reinterpret_cast<char*>(chunk.data()), n);
+            if ((size_t)file.gcount() != n) {
+                Console::error() << "Error: Short read from " << inputFile << std::endl;
+                ok = false;
+                break;
+            }
+            crc = ErrorCorrection::updateCRC32(crc, chunk.data(), n);
+            feed(chunk.data(), n);
+            remaining -= n;
+        }
+        
+        crc = ErrorCorrection::finalizeCRC32(crc);
+        lastResult.crc = crc;
+        uint8_t crcBytes[4] = {
+            static_cast<uint8_t>(crc >> 0), static_cast<uint8_t>(crc >> 8),
+            static_cast<uint8_t>(crc >> 16), static_cast<uint8_t>(crc >> 24)
+        };
+        feed(crcBytes, 4);
+    }
+    if (!block.empty() && ok) {
+        flushBlock();
+    }
+    if (!group.empty() && ok) {
+        flushGroup();
+    }
+    Console::info() << "  CRC32: 0x" << std::hex << lastResult.crc << std::dec << std::endl;
+    
+    // Last partial symbol and ending preamble
+    float* end = modulator.flushSymbols(samples.data());
+    end = modulator.writeTrailer(end);
+    ok = ok && wavFile.writeSamples(samples.data(), end - samples.data());
+    totalSamples += end - samples.data();
+    
+    if (!wavFile.endWrite() || !ok) {
+        Console::error() << "Error: Failed to write audio output" << std::endl;
+        return false;
+    }
+    
+    double duration = static_cast<double>(totalSamples) / modulator.getSampleRate();
+    lastResult.audioSeconds = duration;
+    total.addBytes(fileSize);
+    total.addSamples(totalSamples);
+    Console::info() << "Audio duration: " << duration << " seconds" << std::endl;
+    printDataRate();
+    
+    Console::info() << "\n✓ Encoding complete!" << std::endl;
+    return true;
+}
+
+bool AudioEncoder::encodeFountain(const std::string& inputFile, const std::string& outputFile) {
+    Console::info() << "\n=== ENCODING (fountain) ===" << std::endl;
+    Console::info() << "Input file: " << inputFile << std::endl;
+    Console::info() << "Output file: " << (outputFile == "-" ? "stdout (raw PCM)" : outputFile) << std::endl;
+    lastResult = EncodeResult();
+    Metrics::Scope total("encode_fountain");
+    
+    const bool endless = fountainFrames == FOUNTAIN_ENDLESS;
+    if (endless && outputFile != "-") {
+        Console::error() << "Error: An endless broadcast needs raw PCM output ('-')" << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> fileData = readInputFile(inputFile);
+    if (fileData.empty()) {
+        return false;
+    }
+    if (fileData.size() > 0xFFFFFFFFULL) {
+        Console::error() << "Error: Input file too large: " << inputFile << std::endl;
+        return false;
+    }
+    if (compressMode == COMPRESS_ON) {
+        Console::info() << "Note: fountain frames are sent uncompressed" << std::endl;
+    }
+    
+    Framer::FileInfo info;
+    info.filename = extractFileName(inputFile);
+    info.length = static_cast<uint32_t>(fileData.size());
+    info.crc = ErrorCorrection::calculateCRC32(fileData);
+    info.fountain = true;
+    Fountain code(fileData.size(), Framer::PAYLOAD_SIZE);
+    {
+        Metrics::Scope stage("precode");
+        stage.addBytes(fileData.size());
+        code.setSource(fileData.data());
+    }
+    
+    // Each transmission repeats the file frame, so a late listener learns
+    // the name from the first one it hears
+    const uint32_t K = code.getSourceSymbols();
+    const uint32_t perBurst = FOUNTAIN_BURST - 1;
+    uint64_t frames = fountainFrames ? fountainFrames : K + (K + 1) / 2;
+    frames = (frames + perBurst - 1) / perBurst * perBurst;
+    Console::info() << "  Filename: " << info.filename << std::endl;
+    Console::info() << "  File data: " << info.length << " bytes in " << K << " source frames" << std::endl;
+    if (endless) {
+        Console::info() << "  Coded frames: endless, " << perBurst << " per transmission" << std::endl;
+    } else {
+        Console::info() << "  Coded frames: " << frames << " in " << frames / perBurst << " transmissions" << std::endl;
+    }
+    Console::info() << "  CRC32: 0x" << std::hex << info.crc << std::dec << std::endl;
+    
+    if (!wavFile.beginWrite(outputFile, modulator.getSampleRate(), 1)) {
+        return false;
+    }
+    Interleaver interleaver(std::min<int>(effectiveInterleaveDepth(), FOUNTAIN_BURST),
+                            ErrorCorrection::ENCODED_BLOCK_SIZE);
+    std::vector<uint8_t> burst;
+    burst.reserve(FOUNTAIN_BURST * Framer::FRAME_SIZE);
+    std::vector<uint8_t> symbol(Framer::PAYLOAD_SIZE);
+    uint64_t totalSamples = 0;
+    uint32_t esi = 0;
+    bool ok = true;
+    while (ok && (endless || esi < frames)) {
+        burst.resize(Framer::FRAME_SIZE);
+        Framer::writeFileFrame(info, burst.data());
+        for (uint32_t k = 0; k < perBurst; k++, esi++) {
+            size_t at = burst.size();
+            burst.resize(at + Framer::FRAME_SIZE);
+            code.encodeSymbol(esi, symbol.data());
+            Framer::writeFountainFrame(esi, info.length, symbol.data(), &burst[at]);
+        }
+        
+        std::vector<uint8_t> encoded = errorCorrection.encode(burst);
+        Metrics::count("rs_blocks_encoded", FOUNTAIN_BURST);
+        if (interleaver.getDepth() > 1) {
+            encoded = interleaver.interleave(encoded);
+        }
+        std::vector<float> samples = modulator.modulate(encoded, interleaver.getDepth());
+        ok = wavFile.writeSamples(samples.data(), samples.size());
+        totalSamples += samples.size();
+        lastResult.encodedBytes += encoded.size();
+        lastResult.transmissions = esi / perBurst;
+    }
+    
+    if (!wavFile.endWrite() || !ok) {
+        Console::error() << "Error: Failed to write audio output" << std::endl;
+        return false;
+    }
+    
+    lastResult.inputBytes = info.length;
+    lastResult.packetBytes = static_cast<uint64_t>(lastResult.transmissions) * FOUNTAIN_BURST * Framer::FRAME_SIZE;
+    lastResult.crc = info.crc;
+    lastResult.frames = esi;
+    double duration = static_cast<double>(totalSamples) / modulator.getSampleRate();
+    lastResult.audioSeconds = duration;
+    total.addBytes(info.length);
+    total.addSamples(totalSamples);
+    Console::info() << "Audio duration: " << duration << " seconds" << std::endl;
+    printDataRate();
+    
+    Console::info() << "\n✓ Encoding complete!" << std::endl;
     return true;
 }
@@ -1,33 +1,188 @@
 #include "AudioModulator.h"
+#include "Console.h"
+#include "Metrics.h"
+#include "Resampler.h"
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace {
+
+constexpr int PROFILE_SAMPLE_RATE = 44100;
+constexpr int PROFILE_TONES = 256;
+
+constexpr AudioModulator::ProfileInfo PROFILES[AudioModulator::PROFILE_COUNT] = {
+    {"standard", 1323, 2000, 50},   // 30 ms, 2000-14750 Hz, ~267 bit/s
+    {"robust", 3528, 1000, 25},     // 80 ms, 1000-7375 Hz, 100 bit/s
+    {"fast", 700, 1008, 63},        // 15.9 ms, 1008-17073 Hz, 504 bit/s
+    {"ultrasonic", 1764, 15000, 25} // 40 ms, 15000-21375 Hz, 200 bit/s
+};
+
+// Compile-time view of a profile: the tone grid is a bin grid of a
+// FOLD_SIZE-point FFT, so the detector folds each symbol onto FOLD_SIZE
+// samples and reads 256 consecutive bins, all with constant bounds
+template <AudioModulator::ModemProfile P>
+struct ProfileTraits {
+    static constexpr int SYMBOL_SAMPLES = PROFILES[P].symbolSamples;
+    static constexpr int SPACING = PROFILES[P].freqSpacing;
+    static constexpr int FOLD_SIZE = PROFILE_SAMPLE_RATE / SPACING;
+    static constexpr int BASE_BIN = PROFILES[P].baseFreq / SPACING;
+    static constexpr int FULL_FOLDS = SYMBOL_SAMPLES / FOLD_SIZE;
+    static constexpr int REST = SYMBOL_SAMPLES % FOLD_SIZE;
+
+    static_assert(PROFILE_SAMPLE_RATE % SPACING == 0 && PROFILES[P].baseFreq % SPACING == 0,
+                  "profile tones must sit on an FFT bin grid");
+    static_assert(FOLD_SIZE % 2 == 0 && BASE_BIN + PROFILE_TONES - 1 < FOLD_SIZE / 2,
+                  "profile tones must lie below Nyquist");
+    static_assert(FULL_FOLDS >= 1, "a symbol must cover at least one tone period");
+};
+
+// Soft values are power ratios in quarter dB, saturating at 63.75 dB
+uint8_t softLevel(double ratio) {
+    if (!(ratio > 1.0)) {
+        return 0;
+    }
+    return static_cast<uint8_t>(std::min(255.0, std::round(40.0 * std::log10(ratio))));
+}
+
+// Strongest and runner-up tone of one symbol; strict comparison keeps the
+// lowest tone on ties, as the hard detectors always have
+struct ToneDecision {
+    int tone = -1;
+    double best = 0.0;
+    double second = 0.0;
+    double total = 0.0;
+
+    void add(int candidate, double power) {
+        total += power;
+        if (power > best) {
+            second = best;
+            best = power;
+            tone = candidate;
+        } else if (power > second) {
+            second = power;
+        }
+    }
+
+    void report(int tones, uint8_t* confidence, float* snr) const {
+        if (confidence) {
+            *confidence = second > 0.0 ? softLevel(best / second) : (best > 0.0 ? 255 : 0);
+        }
+        if (snr) {
+            double noise = (total - best) / (tones - 1);
+            *snr = noise > 0.0 ? static_cast<float>(10.0 * std::log10(best / noise)) : 99.0f;
+        }
+    }
+};
+
+// Confidence and SNR distributions for the metrics report, in 1 dB buckets
+void recordSoftDecisions(const std::vector<uint8_t>& confidence, const std::vector<float>& snr) {
+    if (!Metrics::current()) {
+        return;
+    }
+    std::vector<uint64_t> counts(64, 0);
+    for (uint8_t level : confidence) {
+        counts[std::min(63, level / 4)]++;
+    }
+    Metrics::addHistogram("symbol_confidence_db", 1.0, counts);
+    
+    counts.assign(64, 0);
+    for (float db : snr) {
+        counts[std::max(0, std::min(63, (int)std::floor(db)))]++;
+    }
+    Metrics::addHistogram("symbol_snr_db", 1.0, counts);
+}
+
+} // namespace
+
+const AudioModulator::ProfileInfo& AudioModulator::profileInfo(ModemProfile profile) {
+    return PROFILES[profile];
+}
+
+int AudioModulator::topFrequency(ModemProfile profile) {
+    return PROFILES[profile].baseFreq + (PROFILE_TONES - 1) * PROFILES[profile].freqSpacing;
+}
+
+bool AudioModulator::findProfile(const std::string& name, ModemProfile& profile) {
+    for (int i = 0; i < PROFILE_COUNT; i++) {
+        if (name == PROFILES[i].name) {
+            profile = static_cast<ModemProfile>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+AudioModulator::TimingLoop::TimingLoop(double start, double step)
+    : position(start), step(step), nominal(step), reference(0.0), measured(0) {}
+
+void AudioModulator::TimingLoop::correct(double error, int symbols) {
+    if (measured < REFERENCE_COUNT) {
+        reference += (error - reference) / ++measured;
+        return;
+    }
+    error -= reference;
+    position += POSITION_GAIN * error;
+    step += STEP_GAIN * error / symbols;
+    step = std::max(nominal * (1.0 - MAX_CLOCK_OFFSET), std::min(nominal * (1.0 + MAX_CLOCK_OFFSET), step));
+}
+
 AudioModulator::AudioModulator(int sampleRate) 
-    : sampleRate(sampleRate) {
+    : sampleRate(sampleRate), demodMode(DEMOD_FFT), toneFftSize(0),
+      syncMode(SYNC_CHIRP), numThreads(0), modulation(MOD_FSK), profile(PROFILE_STANDARD) {
     // Each symbol is 30ms for faster transmission (was 50ms)
     symbolDuration = 0.03;
     samplesPerSymbol = static_cast<int>(sampleRate * symbolDuration);
+
+    chirp = generateChirp(PREAMBLE_SYMBOLS * samplesPerSymbol);
+    chirpEnergy = 0.0;
+    for (float v : chirp) {
+        chirpEnergy += static_cast<double>(v) * v;
+    }
+
+    // The tone bank FFT needs a bin width of exactly FREQ_SPACING with
+    // every tone on a bin; otherwise detection falls back to Goertzel
+    int spacing = static_cast<int>(FREQ_SPACING);
+    int baseFreq = static_cast<int>(BASE_FREQ);
+    if (spacing == FREQ_SPACING && baseFreq == BASE_FREQ &&
+        sampleRate % spacing == 0 && baseFreq % spacing == 0) {
+        int size = sampleRate / spacing;
+        int baseBin = baseFreq / spacing;
+        if (size % 2 == 0 && baseBin + NUM_TONES - 1 <= size / 2) {
+            toneFftSize = size;
+            toneFft = RealFFT(size);
+        }
+    }
 }
 
 AudioModulator::~AudioModulator() {}
 
-std::vector<float> AudioModulator::generatePreamble() {
-    // Generate a distinctive preamble for synchronization
-    // Uses alternating sync frequency and silence
-    std::vector<float> preamble;
+std::vector<float> AudioModulator::generateChirp(int numSamples) {
+    std::vector<float> sweep(numSamples);
+    
+    // Linear frequency sweep: phase = 2π (f0 t + (f1 - f0) t² / 2T)
+    double duration = static_cast<double>(numSamples) / sampleRate;
+    double rate = (CHIRP_END_FREQ - CHIRP_START_FREQ) / duration;
+    for (int i = 0; i < numSamples; i++) {
+        double t = static_cast<double>(i) / sampleRate;
+        double phase = 2.0 * M_PI * (CHIRP_START_FREQ * t + 0.5 * rate * t * t);
+        sweep[i] = 0.7f * std::sin(phase);
+    }
     
-    // Repeat sync tone 5 times for reliable detection
-    for (int i = 0; i < 5; i++) {
-        std::vector<float> syncTone = generateTone(SYNC_FREQ, samplesPerSymbol);
-        preamble.insert(preamble.end(), syncTone.begin(), syncTone.end());
+    // Same ramp length as a data symbol to reduce clicking
+    int rampSamples = samplesPerSymbol / 10;
+    for (int i = 0; i < rampSamples; i++) {
+        float envelope = static_cast<float>(i) / rampSamples;
+        sweep[i] *= envelope;
+        sweep[numSamples - 1 - i] *= envelope;
     }
     
-    return preamble;
+    return sweep;
 }
 
 std::vector<float> AudioModulator::generateTone(double frequency, int numSamples) {
@@ -49,44 +204,229 @@ std::vector<float> AudioModulator::generateTone(double frequency, int numSamples
     return tone;
 }
 
-std::vector<float> AudioModulator::modulate(const std::vector<uint8_t>& data) {
-    std::vector<float> samples;
+void AudioModulator::buildSymbolTable() {
+    symbolTable.resize(static_cast<size_t>(NUM_TONES + 1) * samplesPerSymbol);
+    
+    for (int tone = 0; tone <= NUM_TONES; tone++) {
+        double frequency = tone < NUM_TONES ? BASE_FREQ + tone * FREQ_SPACING : SYNC_FREQ;
+        std::vector<float> samples = generateTone(frequency, samplesPerSymbol);
+        std::copy(samples.begin(), samples.end(),
+                  symbolTable.begin() + static_cast<size_t>(tone) * samplesPerSymbol);
+    }
+}
+
+float* AudioModulator::writeSymbol(int tone, float* out) const {
+    const float* src = symbolTable.data() + static_cast<size_t>(tone) * samplesPerSymbol;
+    std::copy(src, src + samplesPerSymbol, out);
+    return out + samplesPerSymbol;
+}
+
+void AudioModulator::prepareProfile(ModemProfile p) {
+    if (symbolTable.empty()) {
+        buildSymbolTable();
+    }
+    if (p == PROFILE_STANDARD || !profileTables[p].empty()) {
+        return;
+    }
+    
+    const ProfileInfo& info = PROFILES[p];
+    profileTables[p].resize(static_cast<size_t>(PROFILE_TONES) * info.symbolSamples);
+    for (int tone = 0; tone < PROFILE_TONES; tone++) {
+        std::vector<float> samples = generateTone(info.baseFreq + tone * info.freqSpacing, info.symbolSamples);
+        std::copy(samples.begin(), samples.end(),
+                  profileTables[p].begin() + static_cast<size_t>(tone) * info.symbolSamples);
+    }
+    profileFfts[p] = RealFFT(PROFILE_SAMPLE_RATE / info.freqSpacing);
+}
+
+template <AudioModulator::ModemProfile P>
+float* AudioModulator::writeProfileSymbols(const uint8_t* data, size_t count, float* out) const {
+    constexpr int length = ProfileTraits<P>::SYMBOL_SAMPLES;
+    const float* table = profileTables[P].data();
+    for (size_t i = 0; i < count; i++) {
+        out = std::copy_n(table + static_cast<size_t>(data[i]) * length, length, out);
+    }
+    return out;
+}
+
+float* AudioModulator::writePreamble(float* out) const {
+    if (syncMode == SYNC_CHIRP) {
+        return std::copy(chirp.begin(), chirp.end(), out);
+    }
+    
+    // Legacy preamble: repeat sync tone for reliable detection
+    for (int i = 0; i < PREAMBLE_SYMBOLS; i++) {
+        out = writeSymbol(NUM_TONES, out);
+    }
+    return out;
+}
+
+size_t AudioModulator::headerSamples() const {
+    // Preamble, then version, modulation, depth, 4 length symbols and CRC
+    // for chirp streams, or just the 4 length symbols for tone streams
+    size_t headerSymbols = (syncMode == SYNC_CHIRP) ? 8 : 4;
+    return trailerSamples() + headerSymbols * samplesPerSymbol;
+}
+
+size_t AudioModulator::maxSymbolSamples(size_t count) const {
+    if (getModulation() == MOD_OFDM) {
+        // Held-back bytes can complete one extra symbol
+        return (count / OFDM_SYMBOL_BYTES + 1) * static_cast<size_t>(symbolSamples(MOD_OFDM));
+    }
+    return count * static_cast<size_t>(symbolSamples(MOD_FSK, getProfile()));
+}
+
+long AudioModulator::symbolSamples(Modulation mode, ModemProfile p) const {
+    if (mode == MOD_OFDM) {
+        return OFDM_FFT_SIZE + OFDM_CP_SAMPLES;
+    }
+    return p == PROFILE_STANDARD ? samplesPerSymbol : PROFILES[p].symbolSamples;
+}
+
+int AudioModulator::symbolBytes(Modulation mode) {
+    return mode == MOD_OFDM ? OFDM_SYMBOL_BYTES : 1;
+}
+
+size_t AudioModulator::trailerSamples() const {
+    return static_cast<size_t>(PREAMBLE_SYMBOLS) * samplesPerSymbol;
+}
+
+uint8_t AudioModulator::headerCrc8(const uint8_t* data, size_t length) {
+    // CRC-8, polynomial x^8 + x^2 + x + 1
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+float* AudioModulator::writeHeader(const StreamHeader& header, float* out) {
+    if (symbolTable.empty()) {
+        buildSymbolTable();
+    }
+    
+    ofdmPending.clear();
     
     // Add preamble for synchronization
-    std::vector<float> preamble = generatePreamble();
-    samples.insert(samples.end(), preamble.begin(), preamble.end());
+    out = writePreamble(out);
     
-    // Add data length (4 bytes)
-    uint32_t dataLength = data.size();
+    // Header fields, one symbol per byte (256-FSK) whatever the data modulation
+    uint8_t fields[6];
+    fields[0] = static_cast<uint8_t>(getModulation() | (getProfile() << 4));
+    fields[1] = static_cast<uint8_t>(header.interleaveDepth);
     for (int i = 0; i < 4; i++) {
-        uint8_t byte = (dataLength >> (i * 8)) & 0xFF;
+        fields[2 + i] = (header.dataLength >> (i * 8)) & 0xFF;
+    }
+    
+    if (syncMode != SYNC_CHIRP) {
+        // Legacy layout: length only
+        for (int i = 2; i < 6; i++) {
+            out = writeSymbol(fields[i], out);
+        }
+        return out;
+    }
+    
+    // Chirp streams carry a format version symbol ahead of the header
+    out = writeSymbol(STREAM_VERSION, out);
+    for (int i = 0; i < 6; i++) {
+        out = writeSymbol(fields[i], out);
+    }
+    return writeSymbol(headerCrc8(fields, 6), out);
+}
+
+float* AudioModulator::writeSymbols(const uint8_t* data, size_t count, float* out) {
+    if (symbolTable.empty()) {
+        buildSymbolTable();
+    }
+    
+    if (getModulation() == MOD_OFDM) {
+        if (ofdmDataBins.empty()) {
+            buildOfdm();
+        }
         
-        // Each byte is now 1 symbol (8 bits per symbol - 256-FSK)
-        double frequency = BASE_FREQ + byte * FREQ_SPACING;
-        std::vector<float> tone = generateTone(frequency, samplesPerSymbol);
-        samples.insert(samples.end(), tone.begin(), tone.end());
+        // Complete a held-back symbol first, then send whole symbols
+        // straight from the input
+        if (!ofdmPending.empty()) {
+            size_t n = std::min(count, OFDM_SYMBOL_BYTES - ofdmPending.size());
+            ofdmPending.insert(ofdmPending.end(), data, data + n);
+            data += n;
+            count -= n;
+            if (ofdmPending.size() < (size_t)OFDM_SYMBOL_BYTES) {
+                return out;
+            }
+            out = writeOfdmSymbol(ofdmPending.data(), out);
+            ofdmPending.clear();
+        }
+        for (; count >= (size_t)OFDM_SYMBOL_BYTES; count -= OFDM_SYMBOL_BYTES) {
+            out = writeOfdmSymbol(data, out);
+            data += OFDM_SYMBOL_BYTES;
+        }
+        ofdmPending.assign(data, data + count);
+        return out;
     }
     
-    // Encode data - each byte is one symbol now!
-    for (uint8_t byte : data) {
-        double frequency = BASE_FREQ + byte * FREQ_SPACING;
-        std::vector<float> tone = generateTone(frequency, samplesPerSymbol);
-        samples.insert(samples.end(), tone.begin(), tone.end());
+    // Encode data - each byte is one symbol of the profile's tone grid
+    ModemProfile p = getProfile();
+    prepareProfile(p);
+    switch (p) {
+        case PROFILE_ROBUST: return writeProfileSymbols<PROFILE_ROBUST>(data, count, out);
+        case PROFILE_FAST: return writeProfileSymbols<PROFILE_FAST>(data, count, out);
+        case PROFILE_ULTRASONIC: return writeProfileSymbols<PROFILE_ULTRASONIC>(data, count, out);
+        default: break;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out = writeSymbol(data[i], out);
+    }
+    return out;
+}
+
+float* AudioModulator::flushSymbols(float* out) {
+    // Zero-pad the last partial OFDM symbol
+    if (!ofdmPending.empty()) {
+        ofdmPending.resize(OFDM_SYMBOL_BYTES, 0);
+        out = writeOfdmSymbol(ofdmPending.data(), out);
+        ofdmPending.clear();
+    }
+    return out;
+}
+
+float* AudioModulator::writeTrailer(float* out) {
+    if (symbolTable.empty()) {
+        buildSymbolTable();
     }
     
     // Add ending preamble
-    samples.insert(samples.end(), preamble.begin(), preamble.end());
+    return writePreamble(out);
+}
+
+std::vector<float> AudioModulator::modulate(const std::vector<uint8_t>& data, int interleaveDepth) {
+    // Output buffer is sized once; symbols are copied straight into place
+    size_t totalSamples = headerSamples() + maxSymbolSamples(data.size()) + trailerSamples();
+    std::vector<float> samples(totalSamples);
+    
+    StreamHeader header;
+    header.dataLength = static_cast<uint32_t>(data.size());
+    header.interleaveDepth = interleaveDepth;
+    float* out = writeHeader(header, samples.data());
+    out = writeSymbols(data.data(), data.size(), out);
+    out = flushSymbols(out);
+    out = writeTrailer(out);
+    samples.resize(out - samples.data());
     
     return samples;
 }
 
-double AudioModulator::goertzelFilter(const std::vector<float>& samples, int startIdx, double frequency) {
+double AudioModulator::goertzelFilter(const std::vector<float>& samples, int startIdx, double frequency,
+                                      int length) {
     double omega = 2.0 * M_PI * frequency / sampleRate;
     double coeff = 2.0 * std::cos(omega);
     
     double q0 = 0.0, q1 = 0.0, q2 = 0.0;
     
-    int endIdx = std::min(startIdx + samplesPerSymbol, (int)samples.size());
+    int endIdx = std::min(startIdx + length, (int)samples.size());
     
     for (int i = startIdx; i < endIdx; i++) {
         q0 = coeff * q1 - q2 + samples[i];
@@ -103,24 +443,258 @@ double AudioModulator::goertzelFilter(const std::vector<float>& samples, int sta
 }
 
 int AudioModulator::detectTone(const std::vector<float>& samples, int startIdx) {
-    double maxMagnitude = 0.0;
-    int detectedTone = -1;
+    // Header symbols sit on the standard profile's grid
+    return detectDataTone(samples, startIdx, PROFILE_STANDARD);
+}
+
+template <AudioModulator::ModemProfile P>
+int AudioModulator::detectProfileTone(const float* symbol, uint8_t* confidence, float* snr) const {
+    using Traits = ProfileTraits<P>;
+    thread_local std::vector<double> folded;
+    thread_local std::vector<std::complex<double>> spectrum;
+    folded.resize(Traits::FOLD_SIZE);
+    spectrum.resize(Traits::FOLD_SIZE / 2 + 1);
+    
+    // Folding the symbol modulo the FFT size leaves the DFT at multiples of
+    // sampleRate / FOLD_SIZE unchanged, so each bin equals the Goertzel
+    // output for that tone over the full symbol. The fold is unrolled into
+    // whole periods plus the remainder
+    for (int j = 0; j < Traits::FOLD_SIZE; j++) {
+        folded[j] = symbol[j];
+    }
+    for (int f = 1; f < Traits::FULL_FOLDS; f++) {
+        const float* period = symbol + f * Traits::FOLD_SIZE;
+        for (int j = 0; j < Traits::FOLD_SIZE; j++) {
+            folded[j] += period[j];
+        }
+    }
+    const float* rest = symbol + Traits::FULL_FOLDS * Traits::FOLD_SIZE;
+    for (int j = 0; j < Traits::REST; j++) {
+        folded[j] += rest[j];
+    }
+    
+    const RealFFT& fft = P == PROFILE_STANDARD ? toneFft : profileFfts[P];
+    fft.forward(folded.data(), spectrum.data());
+    
+    const std::complex<double>* bins = spectrum.data() + Traits::BASE_BIN;
+    ToneDecision decision;
+    for (int tone = 0; tone < PROFILE_TONES; tone++) {
+        decision.add(tone, std::norm(bins[tone]));
+    }
+    decision.report(PROFILE_TONES, confidence, snr);
+    
+    return decision.tone;
+}
+
+int AudioModulator::detectDataTone(const std::vector<float>& samples, size_t pos, ModemProfile p) {
+    int tones[1];
+    long start = pos;
+    detectDataRange(samples, &start, 0, 1, p, tones);
+    return tones[0];
+}
+
+void AudioModulator::detectDataRange(const std::vector<float>& samples, const long* starts, size_t begin,
+                                     size_t end, ModemProfile p, int* tones, uint8_t* confidence, float* snr) {
+    const ProfileInfo& info = PROFILES[p];
+    const size_t length = symbolSamples(MOD_FSK, p);
+    
+    // Soft outputs are optional per array
+    auto soft = [](auto* values, size_t i) { return values ? values + i : nullptr; };
+    
+    // Goertzel reference, or a modem rate the profile kernels were not built for
+    if (demodMode == DEMOD_GOERTZEL || sampleRate != PROFILE_SAMPLE_RATE ||
+        (p == PROFILE_STANDARD && toneFftSize == 0)) {
+        for (size_t i = begin; i < end; i++) {
+            tones[i] = detectToneGoertzel(samples, (int)starts[i], info.baseFreq, info.freqSpacing,
+                                          (int)length, soft(confidence, i), soft(snr, i));
+        }
+        return;
+    }
+    
+    // Dispatch once per range so the per-symbol loop runs the specialised kernel
+    const float* base = samples.data();
+    switch (p) {
+        case PROFILE_ROBUST:
+            for (size_t i = begin; i < end; i++)
+                tones[i] = detectProfileTone<PROFILE_ROBUST>(base + starts[i], soft(confidence, i), soft(snr, i));
+            break;
+        case PROFILE_FAST:
+            for (size_t i = begin; i < end; i++)
+                tones[i] = detectProfileTone<PROFILE_FAST>(base + starts[i], soft(confidence, i), soft(snr, i));
+            break;
+        case PROFILE_ULTRASONIC:
+            for (size_t i = begin; i < end; i++)
+                tones[i] = detectProfileTone<PROFILE_ULTRASONIC>(base + starts[i], soft(confidence, i), soft(snr, i));
+            break;
+        default:
+            for (size_t i = begin; i < end; i++)
+                tones[i] = detectProfileTone<PROFILE_STANDARD>(base + starts[i], soft(confidence, i), soft(snr, i));
+            break;
+    }
+}
+
+double AudioModulator::toneTiming(const std::vector<float>& samples, long pos, ModemProfile p, int tone) {
+    const long length = symbolSamples(MOD_FSK, p);
+    const long shift = timingLookahead(MOD_FSK, p);
+    if (tone < 0 || pos < shift || pos + length + shift > (long)samples.size()) {
+        return 0.0;
+    }
+    
+    // Early/late gate on the decided tone: for a symbol starting tau samples
+    // after pos, the windows shifted by -shift and +shift overlap it by
+    // length - shift - tau and length - shift + tau samples
+    const ProfileInfo& info = PROFILES[p];
+    double frequency = info.baseFreq + tone * info.freqSpacing;
+    double early = goertzelFilter(samples, (int)(pos - shift), frequency, (int)length);
+    double late = goertzelFilter(samples, (int)(pos + shift), frequency, (int)length);
+    if (early + late <= 0.0) {
+        return 0.0;
+    }
+    double error = (late - early) / (late + early) * (length - shift);
+    return std::max<double>(-shift, std::min<double>(shift, error));
+}
+
+long AudioModulator::findEndPreamble(const std::vector<float>& samples, long preambleEnd, long dataEnd) {
+    // The end preamble is the same chirp as the start one, and is searched
+    // for as far from its nominal place as the largest clock offset moves it
+    const long chirpLen = chirp.size();
+    const long nominalEnd = dataEnd + chirpLen;
+    const long window = (long)((nominalEnd - preambleEnd) * MAX_CLOCK_OFFSET) + samplesPerSymbol;
+    long begin = std::max(preambleEnd, nominalEnd - chirpLen - window);
+    if (begin + chirpLen > (long)samples.size()) {
+        return -1;
+    }
+    
+    std::vector<int> positions = findChirpPreamble(samples, begin, 1);
+    if (positions.empty() || std::abs(positions[0] - nominalEnd) > window) {
+        return -1;
+    }
+    return positions[0];
+}
+
+int AudioModulator::detectToneGoertzel(const std::vector<float>& samples, int startIdx, double baseFreq,
+                                       double freqSpacing, int length, uint8_t* confidence, float* snr) {
+    ToneDecision decision;
     
     // Check all possible tones
     for (int tone = 0; tone < NUM_TONES; tone++) {
-        double frequency = BASE_FREQ + tone * FREQ_SPACING;
-        double magnitude = goertzelFilter(samples, startIdx, frequency);
+        double frequency = baseFreq + tone * freqSpacing;
+        double magnitude = goertzelFilter(samples, startIdx, frequency, length);
+        decision.add(tone, magnitude * magnitude);
+    }
+    decision.report(NUM_TONES, confidence, snr);
+    
+    return decision.tone;
+}
+
+std::vector<int> AudioModulator::findChirpPreamble(const std::vector<float>& samples, size_t begin,
+                                                   size_t maxHits) {
+    std::vector<int> positions;
+    const long chirpLen = chirp.size();
+    const long total = samples.size();
+    if (total - (long)begin < chirpLen || maxHits == 0) {
+        return positions;
+    }
+    
+    // Overlap-save matched filter; the reference spectrum is computed once
+    if (syncFft.size() == 0) {
+        int fftSize = 1;
+        while (fftSize < 8 * chirpLen) fftSize <<= 1;
+        syncFft = FFT(fftSize);
         
-        if (magnitude > maxMagnitude) {
-            maxMagnitude = magnitude;
-            detectedTone = tone;
+        std::vector<std::complex<double>> padded(fftSize);
+        for (long i = 0; i < chirpLen; i++) padded[i] = chirp[i];
+        chirpSpectrum.resize(fftSize);
+        syncFft.forward(padded.data(), chirpSpectrum.data());
+        for (auto& bin : chirpSpectrum) bin = std::conj(bin) / static_cast<double>(fftSize);
+    }
+    
+    const long fftSize = syncFft.size();
+    const long step = fftSize - chirpLen + 1; // Valid lags per block
+    const long lastLag = total - chirpLen;
+    const double energyFloor = 1e-9 * chirpLen;
+    
+    std::vector<std::complex<double>> block(fftSize), spectrum(fftSize), corr(fftSize);
+    
+    long peakLag = -1;       // Best lag of the hit being tracked
+    double peakScore = 0.0;
+    long peakWindowEnd = 0;  // Hit is final once lags pass this point
+    long resumeLag = 0;      // Lags before this belong to the previous hit
+    uint64_t scanned = 0;    // Lags scored, for the metrics
+    uint64_t candidates = 0; // Threshold crossings
+    
+    // Two consecutive blocks share one complex FFT (real and imaginary parts)
+    for (long base = begin; base <= lastLag; base += 2 * step) {
+        for (long i = 0; i < fftSize; i++) {
+            long a = base + i;
+            long b = base + step + i;
+            block[i] = std::complex<double>(a < total ? samples[a] : 0.0f,
+                                            b < total ? samples[b] : 0.0f);
+        }
+        syncFft.forward(block.data(), spectrum.data());
+        for (long i = 0; i < fftSize; i++) spectrum[i] *= chirpSpectrum[i];
+        syncFft.inverse(spectrum.data(), corr.data());
+        
+        for (int part = 0; part < 2; part++) {
+            long blockStart = base + part * step;
+            if (blockStart > lastLag) break;
+            
+            // Energy of the window under the chirp, slid one sample per lag
+            double energy = 0.0;
+            for (long k = 0; k < chirpLen; k++) {
+                energy += static_cast<double>(samples[blockStart + k]) * samples[blockStart + k];
+            }
+            
+            for (long j = 0; j < step; j++) {
+                long lag = blockStart + j;
+                if (lag > lastLag) break;
+                if (j > 0) {
+                    double leaving = samples[lag - 1];
+                    double entering = samples[lag + chirpLen - 1];
+                    energy += entering * entering - leaving * leaving;
+                }
+                if (lag < resumeLag) continue;
+                scanned++;
+                
+                double c = part == 0 ? corr[j].real() : corr[j].imag();
+                double score = energy > energyFloor ? c * c / (energy * chirpEnergy) : 0.0;
+                
+                if (peakLag < 0) {
+                    if (score >= CHIRP_THRESHOLD) {
+                        candidates++;
+                        peakLag = lag;
+                        peakScore = score;
+                        peakWindowEnd = lag + chirpLen;
+                    }
+                } else if (lag < peakWindowEnd) {
+                    if (score > peakScore) {
+                        peakLag = lag;
+                        peakScore = score;
+                    }
+                } else {
+                    positions.push_back(peakLag + chirpLen); // Position after preamble
+                    resumeLag = peakLag + chirpLen;
+                    peakLag = -1;
+                    if (positions.size() >= maxHits) {
+                        Metrics::count("sync_lags_scanned", scanned);
+                        Metrics::count("preamble_candidates", candidates);
+                        return positions;
+                    }
+                }
+            }
         }
     }
     
-    return detectedTone;
+    if (peakLag >= 0) {
+        positions.push_back(peakLag + chirpLen);
+    }
+    Metrics::count("sync_lags_scanned", scanned);
+    Metrics::count("preamble_candidates", candidates);
+    
+    return positions;
 }
 
-std::vector<int> AudioModulator::findPreamble(const std::vector<float>& samples) {
+std::vector<int> AudioModulator::findTonePreamble(const std::vector<float>& samples) {
     std::vector<int> positions;
     
     // Search for sync frequency pattern
@@ -129,7 +703,7 @@ std::vector<int> AudioModulator::findPreamble(const std::vector<float>& samples)
         
         // Check for 5 consecutive sync tones
         for (int j = 0; j < 5; j++) {
-            double magnitude = goertzelFilter(samples, i + j * samplesPerSymbol, SYNC_FREQ);
+            double magnitude = goertzelFilter(samples, i + j * samplesPerSymbol, SYNC_FREQ, samplesPerSymbol);
             
             // Check if magnitude is strong enough
             if (magnitude > 10.0) { // Threshold for sync detection
@@ -137,7 +711,9 @@ std::vector<int> AudioModulator::findPreamble(const std::vector<float>& samples)
             }
         }
         
+        Metrics::count("tone_sync_windows_scanned");
         if (matchCount >= 4) { // Allow 1 miss
+            Metrics::count("preamble_candidates");
             positions.push_back(i + 5 * samplesPerSymbol); // Position after preamble
             i += 5 * samplesPerSymbol; // Skip past this preamble
         }
@@ -146,57 +722,523 @@ std::vector<int> AudioModulator::findPreamble(const std::vector<float>& samples)
     return positions;
 }
 
-std::vector<uint8_t> AudioModulator::demodulate(const std::vector<float>& samples) {
+void AudioModulator::detectSymbols(const std::vector<float>& samples, const long* starts,
+                                   size_t count, ModemProfile p, int* tones, uint8_t* confidence, float* snr) {
+    // Tables and tone bank are built before the workers share them
+    prepareProfile(p);
+    
+    int threads = numThreads > 0 ? numThreads : (int)std::thread::hardware_concurrency();
+    
+    // Below a few hundred symbols per worker the spawn cost dominates
+    const size_t minSymbolsPerThread = 256;
+    threads = std::max(1, std::min<int>(threads, (int)(count / minSymbolsPerThread)));
+    
+    auto detectRange = [&](size_t begin, size_t end) {
+        detectDataRange(samples, starts, begin, end, p, tones, confidence, snr);
+    };
+    
+    if (threads == 1) {
+        detectRange(0, count);
+        return;
+    }
+    
+    // Contiguous ranges per worker; each writes only its own slots so the
+    // result is identical to the serial loop
+    std::vector<std::thread> workers;
+    size_t chunk = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(count, begin + chunk);
+        if (begin >= end) break;
+        workers.emplace_back(detectRange, begin, end);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+long AudioModulator::findSync(const std::vector<float>& samples, size_t begin) {
+    std::vector<int> positions = findChirpPreamble(samples, begin, 1);
+    return positions.empty() ? -1 : positions[0];
+}
+
+int AudioModulator::readDataSymbol(const std::vector<float>& samples, size_t pos,
+                                   Modulation mode, ModemProfile p, uint8_t* out, double* timing,
+                                   uint8_t* confidence) {
+    if (mode == MOD_OFDM) {
+        if (ofdmDataBins.empty()) {
+            buildOfdm();
+        }
+        readOfdmSymbol(samples, pos, out, timing, confidence);
+        return OFDM_SYMBOL_BYTES;
+    }
+    
+    prepareProfile(p);
+    int tone;
+    long start = pos;
+    detectDataRange(samples, &start, 0, 1, p, &tone, confidence);
+    out[0] = tone < 0 ? 0 : static_cast<uint8_t>(tone);
+    if (timing) {
+        *timing = toneTiming(samples, pos, p, tone);
+    }
+    return 1;
+}
+
+long AudioModulator::timingLookahead(Modulation mode, ModemProfile p) const {
+    // OFDM reads timing from its pilots, inside the symbol
+    return mode == MOD_OFDM ? 0 : symbolSamples(MOD_FSK, p) / 8;
+}
+
+void AudioModulator::buildOfdm() {
+    ofdmFft = FFT(OFDM_FFT_SIZE);
+    ofdmRealFft = RealFFT(OFDM_FFT_SIZE);
+    
+    // Pseudo-random pilot signs (5-bit LFSR) keep the pilots from adding up
+    // into one large peak in time
+    unsigned lfsr = 0x1F;
+    ofdmDataBins.clear();
+    ofdmPilotBins.clear();
+    ofdmPilots.clear();
+    for (int bin = OFDM_FIRST_BIN; bin <= OFDM_LAST_BIN; bin++) {
+        if ((bin - OFDM_FIRST_BIN) % OFDM_PILOT_SPACING == 0) {
+            ofdmPilotBins.push_back(bin);
+            ofdmPilots.push_back((lfsr & 1) ? -1.0 : 1.0);
+            lfsr = (lfsr >> 1) | ((((lfsr >> 0) ^ (lfsr >> 2)) & 1) << 4);
+        } else if ((int)ofdmDataBins.size() < OFDM_SYMBOL_BYTES * 4) {
+            ofdmDataBins.push_back(bin);
+        }
+    }
+}
+
+float* AudioModulator::writeOfdmSymbol(const uint8_t* bytes, float* out) {
+    thread_local std::vector<std::complex<double>> spectrum;
+    thread_local std::vector<std::complex<double>> signal;
+    spectrum.assign(OFDM_FFT_SIZE, std::complex<double>(0.0, 0.0));
+    signal.resize(OFDM_FFT_SIZE);
+    
+    // Gray-mapped QPSK, two bits per data carrier, most significant first
+    const double a = std::sqrt(0.5);
+    for (size_t c = 0; c < ofdmDataBins.size(); c++) {
+        int bits = (bytes[c / 4] >> (6 - 2 * (c % 4))) & 3;
+        spectrum[ofdmDataBins[c]] = std::complex<double>((bits & 2) ? -a : a, (bits & 1) ? -a : a);
+    }
+    for (size_t p = 0; p < ofdmPilotBins.size(); p++) {
+        spectrum[ofdmPilotBins[p]] = ofdmPilots[p];
+    }
+    
+    // Hermitian mirror so the inverse transform is real
+    for (int k = 1; k < OFDM_FFT_SIZE / 2; k++) {
+        spectrum[OFDM_FFT_SIZE - k] = std::conj(spectrum[k]);
+    }
+    ofdmFft.inverse(spectrum.data(), signal.data());
+    
+    // Every active carrier has unit magnitude and contributes 2|X|^2 power
+    int carriers = (int)(ofdmDataBins.size() + ofdmPilotBins.size());
+    double scale = OFDM_RMS / std::sqrt(2.0 * carriers);
+    
+    // Cyclic prefix, then the symbol
+    for (int i = 0; i < OFDM_CP_SAMPLES; i++) {
+        *out++ = static_cast<float>(signal[OFDM_FFT_SIZE - OFDM_CP_SAMPLES + i].real() * scale);
+    }
+    for (int i = 0; i < OFDM_FFT_SIZE; i++) {
+        *out++ = static_cast<float>(signal[i].real() * scale);
+    }
+    return out;
+}
+
+void AudioModulator::readOfdmSymbol(const std::vector<float>& samples, size_t pos, uint8_t* out, double* timing,
+                                    uint8_t* confidence, float* snr) {
+    thread_local std::vector<double> window;
+    thread_local std::vector<std::complex<double>> spectrum;
+    window.resize(OFDM_FFT_SIZE);
+    spectrum.resize(OFDM_FFT_SIZE / 2 + 1);
+    
+    // Start the window inside the cyclic prefix so a slightly late sync
+    // still sees only this symbol
+    size_t start = pos + OFDM_CP_SAMPLES - OFDM_WINDOW_BACKOFF;
+    for (int i = 0; i < OFDM_FFT_SIZE; i++) {
+        window[i] = samples[start + i];
+    }
+    ofdmRealFft.forward(window.data(), spectrum.data());
+    
+    // Undo the known phase ramp of the early window
+    auto bin = [&](int k) {
+        double phase = 2.0 * M_PI * k * OFDM_WINDOW_BACKOFF / OFDM_FFT_SIZE;
+        return spectrum[k] * std::complex<double>(std::cos(phase), std::sin(phase));
+    };
+    
+    // Channel estimate at the pilots, linearly interpolated in between
+    std::complex<double> channel[OFDM_LAST_BIN + 1];
+    for (size_t p = 0; p < ofdmPilotBins.size(); p++) {
+        channel[ofdmPilotBins[p]] = bin(ofdmPilotBins[p]) * ofdmPilots[p];
+    }
+    for (size_t p = 0; p + 1 < ofdmPilotBins.size(); p++) {
+        int lo = ofdmPilotBins[p];
+        int hi = ofdmPilotBins[p + 1];
+        for (int k = lo + 1; k < hi; k++) {
+            double t = static_cast<double>(k - lo) / (hi - lo);
+            channel[k] = channel[lo] + (channel[hi] - channel[lo]) * t;
+        }
+    }
+    
+    // A symbol starting tau samples late turns bin k by -2 pi k tau / N,
+    // so the phase step between neighbouring pilots gives tau
+    if (timing) {
+        std::complex<double> turn(0.0, 0.0);
+        for (size_t p = 0; p + 1 < ofdmPilotBins.size(); p++) {
+            turn += channel[ofdmPilotBins[p + 1]] * std::conj(channel[ofdmPilotBins[p]]);
+        }
+        *timing = -std::arg(turn) * OFDM_FFT_SIZE / (2.0 * M_PI * OFDM_PILOT_SPACING);
+    }
+    
+    // Phase-only equalization is enough for QPSK decisions
+    std::fill(out, out + OFDM_SYMBOL_BYTES, 0);
+    for (size_t c = 0; c < ofdmDataBins.size(); c++) {
+        int k = ofdmDataBins[c];
+        std::complex<double> z = bin(k) * std::conj(channel[k]);
+        int bits = (z.real() < 0 ? 2 : 0) | (z.imag() < 0 ? 1 : 0);
+        out[c / 4] |= static_cast<uint8_t>(bits << (6 - 2 * (c % 4)));
+    }
+    if (!confidence && !snr) {
+        return;
+    }
+    
+    // Soft values need the full equalizer: scaled by the pilots, a clean
+    // carrier lands on (+-a, +-a). The spread around the decided points
+    // gives the noise variance per axis, and a bit at distance x from the
+    // decision boundary is exp(2 a x / variance) times likelier right than
+    // wrong. A byte is as reliable as its weakest bit
+    const double a = std::sqrt(0.5);
+    thread_local std::vector<double> weakest;
+    weakest.resize(ofdmDataBins.size());
+    double noise = 0.0;
+    for (size_t c = 0; c < ofdmDataBins.size(); c++) {
+        int k = ofdmDataBins[c];
+        double gain = std::norm(channel[k]);
+        std::complex<double> z = gain > 0.0 ? bin(k) * std::conj(channel[k]) / gain : 0.0;
+        double re = std::abs(z.real());
+        double im = std::abs(z.imag());
+        noise += (re - a) * (re - a) + (im - a) * (im - a);
+        weakest[c] = std::min(re, im);
+    }
+    noise /= 2.0 * ofdmDataBins.size();
+    if (snr) {
+        *snr = noise > 0.0 ? static_cast<float>(10.0 * std::log10(a * a / noise)) : 99.0f;
+    }
+    if (confidence) {
+        for (int b = 0; b < OFDM_SYMBOL_BYTES; b++) {
+            double margin = std::min(std::min(weakest[4 * b], weakest[4 * b + 1]),
+                                     std::min(weakest[4 * b + 2], weakest[4 * b + 3]));
+            confidence[b] = noise > 0.0 ? softLevel(std::exp(2.0 * a * margin / noise)) : 255;
+        }
+    }
+}
+
+long AudioModulator::readStreamHeader(const std::vector<float>& samples, long pos,
+                                      SyncMode sync, StreamHeader& header) {
+    header = StreamHeader();
+    
+    // Chirp streams carry a format version symbol ahead of the header
+    int fieldCount = 4;
+    if (sync == SYNC_CHIRP) {
+        if (pos + samplesPerSymbol > (long)samples.size()) {
+            Console::error() << "Error: Audio too short to read stream version!" << std::endl;
+            return -1;
+        }
+        header.version = detectTone(samples, pos);
+        if (header.version == 3) {
+            fieldCount = 7; // modulation, depth, length, CRC
+        } else if (header.version == 2) {
+            fieldCount = 6; // depth, length, CRC
+        } else if (header.version != 1) {
+            Console::error() << "Error: Unsupported stream version " << header.version << std::endl;
+            return -1;
+        }
+        pos += samplesPerSymbol;
+    }
+    
+    // Read header fields, one byte per symbol (256-FSK)
+    uint8_t fields[7];
+    for (int i = 0; i < fieldCount; i++) {
+        if (pos + samplesPerSymbol > (long)samples.size()) {
+            Console::error() << "Error: Audio too short to read length!" << std::endl;
+            return -1;
+        }
+        
+        int tone = detectTone(samples, pos);
+        if (tone < 0 || tone >= NUM_TONES) {
+            Console::error() << "Error: Invalid tone detected!" << std::endl;
+            return -1;
+        }
+        
+        fields[i] = static_cast<uint8_t>(tone);
+        pos += samplesPerSymbol;
+    }
+    
+    const uint8_t* length = fields;
+    if (fieldCount > 4) {
+        if (headerCrc8(fields, fieldCount - 1) != fields[fieldCount - 1]) {
+            Console::error() << "Error: Stream header CRC mismatch" << std::endl;
+            return -1;
+        }
+        const uint8_t* field = fields;
+        if (fieldCount == 7) {
+            int mode = *field & 0x0F;
+            int p = *field >> 4;
+            field++;
+            if (mode > MOD_OFDM || p >= PROFILE_COUNT || (mode == MOD_OFDM && p != PROFILE_STANDARD)) {
+                Console::error() << "Error: Unsupported modulation " << mode << " / profile " << p << std::endl;
+                return -1;
+            }
+            header.modulation = static_cast<Modulation>(mode);
+            header.profile = static_cast<ModemProfile>(p);
+        }
+        if (*field == 0) {
+            Console::error() << "Error: Invalid interleave depth 0" << std::endl;
+            return -1;
+        }
+        header.interleaveDepth = *field++;
+        length = field;
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        header.dataLength |= (static_cast<uint32_t>(length[i]) << (i * 8));
+    }
+    
+    return pos;
+}
+
+std::vector<uint8_t> AudioModulator::demodulate(const std::vector<float>& samples, StreamHeader* header,
+                                                std::vector<uint8_t>* confidence) {
     std::vector<uint8_t> data;
     
-    // Find preamble
-    std::vector<int> preamblePositions = findPreamble(samples);
+    // Find preamble: sample-accurate chirp first, then the legacy tone burst
+    SyncMode detectedSync = SYNC_CHIRP;
+    std::vector<int> preamblePositions;
+    {
+        Metrics::Scope stage("sync");
+        stage.addSamples(samples.size());
+        preamblePositions = findChirpPreamble(samples, 0, 1);
+        if (preamblePositions.empty()) {
+            detectedSync = SYNC_TONE;
+            preamblePositions = findTonePreamble(samples);
+        }
+    }
     
     if (preamblePositions.empty()) {
-        std::cerr << "Error: No preamble found in audio!" << std::endl;
+        Console::error() << "Error: No preamble found in audio!" << std::endl;
         return data;
     }
     
     int startPos = preamblePositions[0];
     
-    // Read data length (4 bytes = 4 symbols now with 256-FSK)
-    uint32_t dataLength = 0;
-    for (int i = 0; i < 4; i++) {
-        if (startPos + (i + 1) * samplesPerSymbol > (int)samples.size()) {
-            std::cerr << "Error: Audio too short to read length!" << std::endl;
-            return data;
-        }
+    if (detectedSync == SYNC_CHIRP) {
+        Console::info() << "Chirp preamble found at sample " << startPos - (int)chirp.size() << std::endl;
+    } else {
+        Console::info() << "Tone preamble found (legacy stream)" << std::endl;
+    }
+    
+    StreamHeader streamHeader;
+    long dataPos;
+    {
+        Metrics::Scope stage("header");
+        dataPos = readStreamHeader(samples, startPos, detectedSync, streamHeader);
         
-        int tone = detectTone(samples, startPos + i * samplesPerSymbol);
-        if (tone < 0 || tone >= NUM_TONES) {
-            std::cerr << "Error: Invalid tone detected!" << std::endl;
-            return data;
+        // A capture that starts mid-transmission first syncs on that
+        // transmission's end preamble; the next one may still follow
+        while (dataPos < 0 && detectedSync == SYNC_CHIRP) {
+            Console::info() << "No stream header there; searching for the next preamble" << std::endl;
+            std::vector<int> next = findChirpPreamble(samples, startPos, 1);
+            if (next.empty()) {
+                break;
+            }
+            startPos = next[0];
+            Console::info() << "Chirp preamble found at sample " << startPos - (int)chirp.size() << std::endl;
+            dataPos = readStreamHeader(samples, startPos, detectedSync, streamHeader);
         }
-        
-        uint8_t byte = static_cast<uint8_t>(tone);
-        dataLength |= (static_cast<uint32_t>(byte) << (i * 8));
     }
+    if (dataPos < 0) {
+        return data;
+    }
+    uint32_t dataLength = streamHeader.dataLength;
     
-    std::cout << "Detected data length: " << dataLength << " bytes" << std::endl;
+    Console::info() << "Detected data length: " << dataLength << " bytes" << std::endl;
+    if (streamHeader.interleaveDepth > 1) {
+        Console::info() << "Interleave depth: " << streamHeader.interleaveDepth << " blocks" << std::endl;
+    }
     
-    // Read data - each symbol is now a full byte
-    startPos += 4 * samplesPerSymbol; // Skip length bytes
+    const Modulation mode = streamHeader.modulation;
+    const long unitSamples = symbolSamples(mode, streamHeader.profile);
+    const long units = (dataLength + symbolBytes(mode) - 1) / symbolBytes(mode);
+    const long dataEnd = dataPos + units * unitSamples;
     
-    for (uint32_t i = 0; i < dataLength; i++) {
-        if (startPos + samplesPerSymbol > (int)samples.size()) {
-            std::cerr << "Warning: Audio ended prematurely. Decoded " << i << " of " << dataLength << " bytes." << std::endl;
-            break;
+    // The end preamble sits a known number of samples after the start one;
+    // where it really lands gives the clock ratio of the whole capture
+    long endPos = -1;
+    if (detectedSync == SYNC_CHIRP) {
+        Metrics::Scope stage("clock");
+        endPos = findEndPreamble(samples, startPos, dataEnd);
+    }
+    streamHeader.endSample = endPos >= 0 ? endPos : dataEnd + (long)chirp.size();
+    if (header) {
+        *header = streamHeader;
+    }
+    if (endPos < 0) {
+        return demodulateData(samples, TimingLoop(dataPos, unitSamples), streamHeader, confidence);
+    }
+    
+    const long actualSpan = endPos - startPos;
+    const long nominalSpan = dataEnd + (long)chirp.size() - startPos;
+    const double clockRatio = static_cast<double>(actualSpan) / nominalSpan;
+    Console::info() << "Clock offset from end preamble: " << std::showpos
+                    << (clockRatio - 1.0) * 1e6 << std::noshowpos << " ppm" << std::endl;
+    if (std::abs(clockRatio - 1.0) <= RESAMPLE_CLOCK_OFFSET) {
+        return demodulateData(samples, TimingLoop(startPos + (dataPos - startPos) * clockRatio,
+                                                  unitSamples * clockRatio), streamHeader, confidence);
+    }
+    
+    // Larger offsets move the tones as well (by 10 Hz at 21 kHz and 500 ppm);
+    // resampling what follows the start preamble to the sender's clock
+    // corrects frequency and timing together
+    std::vector<float> corrected;
+    {
+        Metrics::Scope stage("resample");
+        stage.addSamples(samples.size() - startPos);
+        Resampler resampler((int)actualSpan, (int)nominalSpan);
+        resampler.process(samples.data() + startPos, samples.size() - startPos, corrected);
+        resampler.flush(corrected);
+    }
+    return demodulateData(corrected, TimingLoop(dataPos - startPos, unitSamples), streamHeader, confidence);
+}
+
+std::vector<uint8_t> AudioModulator::demodulateData(const std::vector<float>& samples, TimingLoop clock,
+                                                    const StreamHeader& streamHeader,
+                                                    std::vector<uint8_t>* confidence) {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> soft;
+    std::vector<float> snr;
+    const uint32_t dataLength = streamHeader.dataLength;
+    const Modulation mode = streamHeader.modulation;
+    const long unitSamples = symbolSamples(mode, streamHeader.profile);
+    const size_t units = (dataLength + symbolBytes(mode) - 1) / symbolBytes(mode);
+    
+    // A legacy header has no CRC, so noise can announce gigabytes; buffers
+    // are sized by what the capture can hold
+    const size_t capacity = std::min<size_t>(units, samples.size() / unitSamples + 1);
+    
+    if (mode == MOD_OFDM) {
+        Console::info() << "Modulation: OFDM" << std::endl;
+        if (ofdmDataBins.empty()) {
+            buildOfdm();
         }
         
-        int tone = detectTone(samples, startPos);
+        // Every symbol's pilots measure its timing, so the loop runs per symbol
+        Metrics::Scope stage("symbols");
+        data.resize(capacity * OFDM_SYMBOL_BYTES);
+        soft.resize(capacity * OFDM_SYMBOL_BYTES);
+        snr.resize(capacity);
+        size_t count = 0;
+        for (; count < capacity; count++) {
+            long pos = clock.at();
+            if (pos < 0 || pos + unitSamples > (long)samples.size()) {
+                break;
+            }
+            double timing;
+            readOfdmSymbol(samples, pos, data.data() + count * OFDM_SYMBOL_BYTES, &timing,
+                           soft.data() + count * OFDM_SYMBOL_BYTES, &snr[count]);
+            clock.correct(timing);
+            clock.advance();
+        }
+        stage.addSamples(count * unitSamples);
+        Metrics::count("symbols_decoded", count);
+        data.resize(count * OFDM_SYMBOL_BYTES);
+        soft.resize(data.size());
+        snr.resize(count);
+        if (data.size() > dataLength) {
+            data.resize(dataLength);
+            soft.resize(dataLength);
+        }
+        recordSoftDecisions(soft, snr);
+        if (confidence) {
+            *confidence = std::move(soft);
+        }
         
+        if (data.size() < dataLength) {
+            Console::error() << "Warning: Audio ended prematurely. Decoded " << data.size() << " of " << dataLength << " bytes." << std::endl;
+        }
+        return data;
+    }
+    
+    // Read data - each symbol is now a full byte
+    const ModemProfile p = streamHeader.profile;
+    if (p != PROFILE_STANDARD) {
+        Console::info() << "Profile: " << PROFILES[p].name << std::endl;
+    }
+    
+    // Timing is measured on every TRACKING_INTERVAL-th symbol, in order;
+    // the symbols in between take the loop's prediction, so the tone
+    // detection itself can still run in parallel. A symbol that repeats
+    // a neighbour's tone has no edge there and is not measured: a run of
+    // one tone would otherwise hold the loop at its reference offset
+    std::vector<long> starts;
+    {
+        Metrics::Scope stage("tracking");
+        prepareProfile(p);
+        starts.reserve(capacity);
+        int since = 0;
+        while (starts.size() < dataLength) {
+            long pos = clock.at();
+            if (pos < 0 || pos + unitSamples > (long)samples.size()) {
+                break;
+            }
+            since += TRACKING_INTERVAL;
+            int tone = detectDataTone(samples, pos, p);
+            long previous = clock.at(-1);
+            long next = clock.at(1);
+            if (previous >= 0 && next + unitSamples <= (long)samples.size() &&
+                tone != detectDataTone(samples, previous, p) && tone != detectDataTone(samples, next, p)) {
+                clock.correct(toneTiming(samples, pos, p, tone), since);
+                Metrics::count("timing_measurements");
+                since = 0;
+            }
+            
+            size_t n = std::min<size_t>(TRACKING_INTERVAL, dataLength - starts.size());
+            for (size_t i = 0; i < n; i++) {
+                starts.push_back(clock.at(i));
+            }
+            clock.advance(n);
+        }
+        while (!starts.empty() && starts.back() + unitSamples > (long)samples.size()) {
+            starts.pop_back();
+        }
+    }
+    size_t count = starts.size();
+    
+    Metrics::Scope stage("symbols");
+    stage.addSamples(count * unitSamples);
+    Metrics::count("symbols_decoded", count);
+    std::vector<int> tones(count);
+    soft.resize(count);
+    snr.resize(count);
+    detectSymbols(samples, starts.data(), count, p, tones.data(), soft.data(), snr.data());
+    
+    data.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        int tone = tones[i];
         if (tone < 0 || tone >= NUM_TONES) {
-            std::cerr << "Warning: Invalid tone at byte " << i << std::endl;
+            Metrics::count("invalid_tones");
+            Console::error() << "Warning: Invalid tone at byte " << i << std::endl;
             tone = 0; // Default to 0
         }
-        
-        data.push_back(static_cast<uint8_t>(tone));
-        startPos += samplesPerSymbol;
+        data[i] = static_cast<uint8_t>(tone);
+    }
+    recordSoftDecisions(soft, snr);
+    if (confidence) {
+        *confidence = std::move(soft);
+    }
+    
+    if (count < dataLength) {
+        Console::error() << "Warning: Audio ended prematurely. Decoded " << count << " of " << dataLength << " bytes." << std::endl;
     }
     
     return data;
@@ -0,0 +1,291 @@
+#include "BatchProcessor.h"
+#include "Console.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string jsonString(const std::string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\r': out << "\\r"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+                } else {
+                    out << c;
+                }
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+std::string crcString(uint32_t crc) {
+    std::ostringstream out;
+    out << '"' << std::hex << std::setw(8) << std::setfill('0') << crc << '"';
+    return out.str();
+}
+
+// Buffered error text as one line for the summary
+std::string errorText(std::string errors) {
+    while (!errors.empty() && errors.back() == '\n') {
+        errors.pop_back();
+    }
+    std::replace(errors.begin(), errors.end(), '\n', ';');
+    return errors;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool hasWavExtension(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav";
+}
+
+bool prepareOutputDir(const std::string& outputDir) {
+    std::error_code ec;
+    fs::create_directories(outputDir, ec);
+    if (!fs::is_directory(outputDir, ec)) {
+        Console::error() << "Error: Could not create output directory: " << outputDir << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+BatchProcessor::BatchProcessor(int threads) : pool(threads) {}
+
+bool BatchProcessor::collectInputs(const std::string& source, bool wavOnly,
+                                   std::vector<std::string>& files) {
+    files.clear();
+    std::error_code ec;
+
+    if (fs::is_directory(source, ec)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(source, ec)) {
+            if (entry.is_regular_file(ec) && (!wavOnly || hasWavExtension(entry.path()))) {
+                files.push_back(entry.path().string());
+            }
+        }
+        if (ec) {
+            Console::error() << "Error: Could not list directory " << source << ": " << ec.message() << std::endl;
+            return false;
+        }
+        std::sort(files.begin(), files.end());
+        return true;
+    }
+
+    std::ifstream manifest(source);
+    if (!manifest.is_open()) {
+        Console::error() << "Error: Could not open input directory or manifest: " << source << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            files.push_back(line);
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> BatchProcessor::largestFirst(const std::vector<std::string>& inputs) const {
+    std::vector<uintmax_t> sizes(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        std::error_code ec;
+        sizes[i] = fs::file_size(inputs[i], ec);
+        if (ec) {
+            sizes[i] = 0;
+        }
+    }
+
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+    return order;
+}
+
+bool BatchProcessor::encode(const std::vector<std::string>& inputs, const std::string& outputDir,
+                            const std::function<bool(AudioEncoder&)>& configure, bool streaming,
+                            std::ostream& summary) {
+    totals = Totals();
+    totals.jobs = inputs.size();
+    if (!prepareOutputDir(outputDir)) {
+        return false;
+    }
+
+    // Per-worker encoders, configured up front so option errors surface once
+    std::vector<std::unique_ptr<AudioEncoder>> encoders(pool.size());
+    for (std::unique_ptr<AudioEncoder>& encoder : encoders) {
+        encoder.reset(new AudioEncoder);
+        if (!configure(*encoder)) {
+            return false;
+        }
+        encoder->setNumThreads(1);
+        encoder->setVerbose(false);
+    }
+
+    // Output names follow the input names; repeated names get the job index
+    std::vector<std::string> outputs(inputs.size());
+    std::map<std::string, int> nameCount;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        std::string name = fs::path(inputs[i]).filename().string();
+        if (nameCount[name]++ > 0) {
+            name += "-" + std::to_string(i);
+        }
+        outputs[i] = (fs::path(outputDir) / (name + ".wav")).string();
+    }
+
+    std::vector<size_t> order = largestFirst(inputs);
+    std::mutex summaryMutex;
+    auto batchStart = std::chrono::steady_clock::now();
+
+    pool.run(order.size(), [&](size_t job, int worker) {
+        size_t index = order[job];
+        AudioEncoder& encoder = *encoders[worker];
+        Console::setQuiet(true);
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = streaming ? encoder.encodeFileStreaming(inputs[index], outputs[index])
+                            : encoder.encodeFile(inputs[index], outputs[index]);
+        double elapsed = millisecondsSince(start);
+        std::string errors = errorText(Console::takeErrors());
+        const AudioEncoder::EncodeResult& result = encoder.getLastResult();
+
+        std::ostringstream record;
+        record << std::fixed << std::setprecision(3)
+               << "{\"index\":" << index
+               << ",\"input\":" << jsonString(inputs[index])
+               << ",\"output\":" << jsonString(outputs[index])
+               << ",\"status\":\"" << (ok ? "ok" : "failed") << "\""
+               << ",\"input_bytes\":" << result.inputBytes
+               << ",\"packet_bytes\":" << result.packetBytes
+               << ",\"encoded_bytes\":" << result.encodedBytes
+               << ",\"codec\":" << jsonString(Compressor::codecName(result.codec))
+               << ",\"crc32\":" << crcString(result.crc)
+               << ",\"audio_seconds\":" << result.audioSeconds
+               << ",\"elapsed_ms\":" << elapsed
+               << ",\"error\":" << jsonString(errors) << "}";
+
+        std::lock_guard<std::mutex> lock(summaryMutex);
+        summary << record.str() << std::endl;
+        (ok ? totals.succeeded : totals.failed)++;
+    });
+
+    Console::setQuiet(false);
+    totals.seconds = millisecondsSince(batchStart) / 1000.0;
+    return totals.failed == 0;
+}
+
+bool BatchProcessor::decode(const std::vector<std::string>& inputs, const std::string& outputDir,
+                            const std::function<bool(AudioDecoder&)>& configure, std::ostream& summary) {
+    totals = Totals();
+    totals.jobs = inputs.size();
+    if (!prepareOutputDir(outputDir)) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<AudioDecoder>> decoders(pool.size());
+    for (std::unique_ptr<AudioDecoder>& decoder : decoders) {
+        decoder.reset(new AudioDecoder);
+        if (!configure(*decoder)) {
+            return false;
+        }
+        decoder->setNumThreads(1);
+        decoder->setVerbose(false);
+    }
+
+    std::vector<size_t> order = largestFirst(inputs);
+    std::mutex summaryMutex;
+    std::mutex nameMutex;
+    std::map<std::string, int> nameCount;
+    auto batchStart = std::chrono::steady_clock::now();
+
+    pool.run(order.size(), [&](size_t job, int worker) {
+        size_t index = order[job];
+        AudioDecoder& decoder = *decoders[worker];
+        Console::setQuiet(true);
+
+        // Output names come from the packets, so each job decodes into its
+        // own directory and then moves the file out; a name an earlier job
+        // of this batch took gets the job index, as in encode()
+        auto start = std::chrono::steady_clock::now();
+        fs::path staging = fs::path(outputDir) / (".decode-" + std::to_string(index));
+        std::error_code ec;
+        fs::create_directories(staging, ec);
+        bool decoded = decoder.decodeFile(inputs[index], staging.string());
+        const AudioDecoder::DecodeResult& result = decoder.getLastResult();
+        std::string output;
+        if (!result.outputPath.empty() && fs::exists(result.outputPath, ec)) {
+            std::string name = fs::path(result.outputPath).filename().string();
+            {
+                std::lock_guard<std::mutex> lock(nameMutex);
+                if (nameCount[name]++ > 0) {
+                    name += "-" + std::to_string(index);
+                }
+            }
+            output = (fs::path(outputDir) / name).string();
+            fs::rename(result.outputPath, output, ec);
+            if (ec) {
+                Console::error() << "Error: Could not move " << result.outputPath << " to " << output
+                          << ": " << ec.message() << std::endl;
+                decoded = false;
+                output.clear();
+            }
+        }
+        fs::remove_all(staging, ec);
+        double elapsed = millisecondsSince(start);
+        std::string errors = errorText(Console::takeErrors());
+        bool ok = decoded && result.crcMatches;
+
+        bool incomplete = decoded && !result.missing.empty();
+        const char* status = ok ? "ok" : (incomplete ? "incomplete" : (decoded ? "crc_mismatch" : "failed"));
+        std::ostringstream record;
+        record << std::fixed << std::setprecision(3)
+               << "{\"index\":" << index
+               << ",\"input\":" << jsonString(inputs[index])
+               << ",\"output\":" << jsonString(output)
+               << ",\"status\":\"" << status << "\""
+               << ",\"file_bytes\":" << result.fileBytes
+               << ",\"crc_ok\":" << (result.crcMatches ? "true" : "false")
+               << ",\"crc32\":" << crcString(result.crc)
+               << ",\"corrected_symbols\":" << result.correctedSymbols
+               << ",\"failed_blocks\":" << result.failedBlocks
+               << ",\"missing\":" << jsonString(Framer::formatRanges(result.missing))
+               << ",\"audio_seconds\":" << result.audioSeconds
+               << ",\"elapsed_ms\":" << elapsed
+               << ",\"error\":" << jsonString(errors) << "}";
+
+        std::lock_guard<std::mutex> lock(summaryMutex);
+        summary << record.str() << std::endl;
+        (ok ? totals.succeeded : totals.failed)++;
+    });
+
+    Console::setQuiet(false);
+    totals.seconds = millisecondsSince(batchStart) / 1000.0;
+    return totals.failed == 0;
+}
@@ -0,0 +1,280 @@
+#include "ChannelSimulator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Independent random streams per stage, so enabling one impairment does
+// not change the draws of another
+enum Stream { STREAM_REVERB = 1, STREAM_FADE, STREAM_NOISE, STREAM_DROPOUT };
+
+std::mt19937 makeRng(uint32_t seed, Stream stream) {
+    std::seed_seq seq{seed, static_cast<uint32_t>(stream)};
+    return std::mt19937(seq);
+}
+
+/**
+ * @brief RBJ cookbook biquad (Butterworth Q), direct form I
+ */
+class Biquad {
+public:
+    Biquad(bool highPass, double cornerHz, int sampleRate) : x1(0), x2(0), y1(0), y2(0) {
+        double w0 = 2.0 * M_PI * cornerHz / sampleRate;
+        double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+        double c = std::cos(w0);
+        double a0 = 1.0 + alpha;
+        if (highPass) {
+            b0 = (1.0 + c) / 2.0 / a0;
+            b1 = -(1.0 + c) / a0;
+        } else {
+            b0 = (1.0 - c) / 2.0 / a0;
+            b1 = (1.0 - c) / a0;
+        }
+        b2 = b0;
+        a1 = -2.0 * c / a0;
+        a2 = (1.0 - alpha) / a0;
+    }
+
+    void process(std::vector<float>& samples) {
+        for (float& sample : samples) {
+            double x0 = sample;
+            double y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            sample = static_cast<float>(y0);
+        }
+    }
+
+private:
+    double b0, b1, b2, a1, a2;
+    double x1, x2, y1, y2;
+};
+
+}
+
+ChannelSimulator::ChannelSimulator(int sampleRate) : sampleRate(sampleRate) {
+    // Blackman-windowed sinc, one row of taps per fractional phase; rows are
+    // normalised to unit DC gain so a constant signal passes unchanged
+    resampleTable.resize(static_cast<size_t>(RESAMPLE_PHASES + 1) * RESAMPLE_TAPS);
+    const int half = RESAMPLE_TAPS / 2;
+    for (int phase = 0; phase <= RESAMPLE_PHASES; phase++) {
+        double frac = static_cast<double>(phase) / RESAMPLE_PHASES;
+        float* row = &resampleTable[static_cast<size_t>(phase) * RESAMPLE_TAPS];
+        double sum = 0.0;
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            double x = (k - half + 1) - frac;    // Tap k reads input sample i + k - half + 1
+            double sinc = x == 0.0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+            double w = (x + half) / RESAMPLE_TAPS;
+            double window = 0.42 - 0.5 * std::cos(2.0 * M_PI * w) + 0.08 * std::cos(4.0 * M_PI * w);
+            row[k] = static_cast<float>(sinc * window);
+            sum += row[k];
+        }
+        for (int k = 0; k < RESAMPLE_TAPS; k++) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+bool ChannelSimulator::parseBand(const std::string& text, Conditions& conditions) {
+    size_t dash = text.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    char* end = nullptr;
+    double low = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + dash) {
+        return false;
+    }
+    double high = std::strtod(text.c_str() + dash + 1, &end);
+    if (*end != '\0' || low < 0.0 || high <= low) {
+        return false;
+    }
+    conditions.lowCutHz = low;
+    conditions.highCutHz = high;
+    return true;
+}
+
+std::vector<float> ChannelSimulator::process(const std::vector<float>& input, const Conditions& conditions,
+                                             uint32_t seed) const {
+    const size_t lead = static_cast<size_t>(std::max(0.0, conditions.leadSeconds) * sampleRate);
+    std::vector<float> samples(lead + input.size() + lead, 0.0f);
+    std::copy(input.begin(), input.end(), samples.begin() + lead);
+
+    applyReverb(samples, conditions, seed);
+    applyBandLimit(samples, conditions);
+    applyGain(samples, conditions, seed);
+    if (conditions.ppm != 0.0) {
+        samples = applyClockOffset(samples, conditions.ppm);
+    }
+
+    // Noise is set against the received transmission, not the silence around it
+    const double stretch = 1.0 + conditions.ppm * 1e-6;
+    size_t begin = std::min(samples.size(), static_cast<size_t>(lead * stretch));
+    size_t end = std::min(samples.size(), static_cast<size_t>((lead + input.size()) * stretch));
+    double power = 0.0;
+    for (size_t i = begin; i < end; i++) {
+        power += static_cast<double>(samples[i]) * samples[i];
+    }
+    if (end > begin) {
+        power /= end - begin;
+    }
+
+    if (std::isfinite(conditions.snrDb)) {
+        applyNoise(samples, power, conditions.snrDb, seed);
+    }
+    applyDropouts(samples, conditions, seed);
+    return samples;
+}
+
+void ChannelSimulator::applyReverb(std::vector<float>& samples, const Conditions& conditions,
+                                   uint32_t seed) const {
+    if (conditions.reverbMs <= 0.0 || conditions.reverbMix <= 0.0) {
+        return;
+    }
+
+    // Schroeder reverberator: four parallel feedback combs then two allpass
+    // diffusers. The seed jitters the comb delays by up to +/-10%, which
+    // moves the room's echo pattern between trials
+    static const double COMB_MS[4] = {29.7, 37.1, 41.1, 43.7};
+    static const double ALLPASS_MS[2] = {5.0, 1.7};
+    std::mt19937 rng = makeRng(seed, STREAM_REVERB);
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+
+    std::vector<float> wet(samples.size(), 0.0f);
+    double norm = 0.0;
+    for (double combMs : COMB_MS) {
+        size_t delay = std::max<size_t>(1, static_cast<size_t>(combMs * jitter(rng) * sampleRate / 1000.0));
+        // Each pass round the loop decays by 60 dB per RT60
+        double g = std::pow(10.0, -3.0 * (delay * 1000.0 / sampleRate) / conditions.reverbMs);
+        norm += 1.0 / (1.0 - g * g);
+        std::vector<float> line(delay, 0.0f);
+        size_t pos = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            float out = line[pos];
+            line[pos] = static_cast<float>(samples[i] + g * out);
+            wet[i] += out;
+            if (++pos == delay) pos = 0;
+        }
+    }
+    for (double allpassMs : ALLPASS_MS) {
+        size_t delay = std::max<size_t>(1, static_cast<size_t>(allpassMs * sampleRate / 1000.0));
+        const float g = 0.7f;
+        std::vector<float> line(delay, 0.0f);
+        size_t pos = 0;
+        for (float& sample : wet) {
+            float delayed = line[pos];
+            float v = sample + g * delayed;
+            line[pos] = v;
+            sample = delayed - g * v;
+            if (++pos == delay) pos = 0;
+        }
+    }
+
+    // Scale the tail to mix times the direct level (in power)
+    const float scale = static_cast<float>(conditions.reverbMix / std::sqrt(norm));
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] += scale * wet[i];
+    }
+}
+
+void ChannelSimulator::applyBandLimit(std::vector<float>& samples, const Conditions& conditions) const {
+    if (conditions.lowCutHz > 0.0) {
+        Biquad(true, conditions.lowCutHz, sampleRate).process(samples);
+    }
+    if (conditions.highCutHz > 0.0 && conditions.highCutHz < sampleRate / 2.0) {
+        Biquad(false, conditions.highCutHz, sampleRate).process(samples);
+    }
+}
+
+void ChannelSimulator::applyGain(std::vector<float>& samples, const Conditions& conditions,
+                                 uint32_t seed) const {
+    if (conditions.fadeDb == 0.0) {
+        if (conditions.gainDb != 0.0) {
+            const float gain = static_cast<float>(std::pow(10.0, conditions.gainDb / 20.0));
+            for (float& sample : samples) {
+                sample *= gain;
+            }
+        }
+        return;
+    }
+
+    // Slow sinusoidal fading in dB, random starting phase
+    std::mt19937 rng = makeRng(seed, STREAM_FADE);
+    double phase = std::uniform_real_distribution<double>(0.0, 2.0 * M_PI)(rng);
+    double step = 2.0 * M_PI * conditions.fadeHz / sampleRate;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double db = conditions.gainDb + 0.5 * conditions.fadeDb * std::sin(phase + step * i);
+        samples[i] *= static_cast<float>(std::pow(10.0, db / 20.0));
+    }
+}
+
+std::vector<float> ChannelSimulator::applyClockOffset(const std::vector<float>& samples, double ppm) const {
+    // A receiver clock fast by ppm takes (1 + ppm) samples per sent sample
+    const double step = 1.0 / (1.0 + ppm * 1e-6);
+    const long n = samples.size();
+    const size_t outLength = n > 0 ? static_cast<size_t>((n - 1) / step) + 1 : 0;
+    const int half = RESAMPLE_TAPS / 2;
+    std::vector<float> out(outLength);
+
+    for (size_t j = 0; j < outLength; j++) {
+        double t = j * step;
+        long i = static_cast<long>(t);
+        int phase = static_cast<int>((t - i) * RESAMPLE_PHASES + 0.5);
+        const float* row = &resampleTable[static_cast<size_t>(phase) * RESAMPLE_TAPS];
+        long first = i - half + 1;
+        float sum = 0.0f;
+        if (first >= 0 && first + RESAMPLE_TAPS <= n) {
+            const float* src = samples.data() + first;
+            for (int k = 0; k < RESAMPLE_TAPS; k++) {
+                sum += row[k] * src[k];
+            }
+        } else {
+            for (int k = 0; k < RESAMPLE_TAPS; k++) {
+                long idx = first + k;
+                if (idx >= 0 && idx < n) {
+                    sum += row[k] * samples[idx];
+                }
+            }
+        }
+        out[j] = sum;
+    }
+    return out;
+}
+
+void ChannelSimulator::applyNoise(std::vector<float>& samples, double signalPower, double snrDb,
+                                  uint32_t seed) const {
+    if (signalPower <= 0.0) {
+        return;
+    }
+    std::mt19937 rng = makeRng(seed, STREAM_NOISE);
+    std::normal_distribution<float> noise(0.0f, static_cast<float>(std::sqrt(signalPower / std::pow(10.0, snrDb / 10.0))));
+    for (float& sample : samples) {
+        sample += noise(rng);
+    }
+}
+
+void ChannelSimulator::applyDropouts(std::vector<float>& samples, const Conditions& conditions,
+                                     uint32_t seed) const {
+    if (conditions.dropoutRate <= 0.0 || conditions.dropoutMs <= 0.0) {
+        return;
+    }
+
+    // Poisson arrivals; each burst silences the input completely
+    std::mt19937 rng = makeRng(seed, STREAM_DROPOUT);
+    std::exponential_distribution<double> gap(conditions.dropoutRate);
+    const size_t length = static_cast<size_t>(conditions.dropoutMs * sampleRate / 1000.0);
+    double t = gap(rng);
+    while (t * sampleRate < samples.size()) {
+        size_t start = static_cast<size_t>(t * sampleRate);
+        size_t stop = std::min(samples.size(), start + length);
+        std::fill(samples.begin() + start, samples.begin() + stop, 0.0f);
+        t += gap(rng);
+    }
+}
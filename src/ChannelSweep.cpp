@@ -0,0 +1,224 @@
+#include "ChannelSweep.h"
+#include "Console.h"
+#include "Interleaver.h"
+#include <algorithm>
+#include <set>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+ChannelSimulator::Conditions condition(const std::string& name) {
+    ChannelSimulator::Conditions c;
+    c.name = name;
+    return c;
+}
+
+// JSON has no infinity; an absent noise source is null
+std::string jsonNumber(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+}
+
+ChannelSweep::ChannelSweep() : packetBytes(0), fileBytes(0), dataFrames(0), audioSeconds(0.0) {}
+
+bool ChannelSweep::prepare(AudioEncoder& encoder, const std::string& inputFile) {
+    transmission = encoder.encodeSamples(inputFile, &sentSymbols);
+    if (transmission.empty()) {
+        return false;
+    }
+    if (encoder.getSampleRate() != channel.getSampleRate()) {
+        channel = ChannelSimulator(encoder.getSampleRate());
+    }
+    const AudioEncoder::EncodeResult& result = encoder.getLastResult();
+    packetBytes = result.packetBytes;
+    fileBytes = result.inputBytes;
+    audioSeconds = result.audioSeconds;
+    dataFrames = result.frames > 2 ? result.frames - 2 : 0;
+    return true;
+}
+
+std::vector<ChannelSimulator::Conditions> ChannelSweep::standardConditions() {
+    std::vector<ChannelSimulator::Conditions> list;
+    list.push_back(condition("clean"));
+
+    for (double snr : {30.0, 20.0, 10.0, 5.0, 0.0, -5.0, -10.0}) {
+        ChannelSimulator::Conditions c = condition("awgn_" + jsonNumber(snr) + "db");
+        c.snrDb = snr;
+        list.push_back(c);
+    }
+
+    ChannelSimulator::Conditions c = condition("gain_-20db");
+    c.gainDb = -20.0;
+    list.push_back(c);
+    c = condition("fade_12db");
+    c.fadeDb = 12.0;
+    c.snrDb = 20.0;
+    list.push_back(c);
+
+    for (double ppm : {20.0, -20.0, 100.0}) {
+        c = condition(std::string("clock_") + (ppm > 0 ? "+" : "") + jsonNumber(ppm) + "ppm");
+        c.ppm = ppm;
+        list.push_back(c);
+    }
+
+    c = condition("band_300-3400");
+    c.lowCutHz = 300.0;
+    c.highCutHz = 3400.0;
+    list.push_back(c);
+    c = condition("band_200-8000");
+    c.lowCutHz = 200.0;
+    c.highCutHz = 8000.0;
+    list.push_back(c);
+
+    for (double rt60 : {300.0, 800.0}) {
+        c = condition("reverb_" + jsonNumber(rt60) + "ms");
+        c.reverbMs = rt60;
+        list.push_back(c);
+    }
+
+    c = condition("dropouts_20ms");
+    c.dropoutRate = 0.5;
+    c.dropoutMs = 20.0;
+    list.push_back(c);
+    c = condition("dropouts_200ms");
+    c.dropoutRate = 0.1;
+    c.dropoutMs = 200.0;
+    list.push_back(c);
+
+    // A small room: phone speaker to laptop microphone a metre away
+    c = condition("room");
+    c.snrDb = 20.0;
+    c.fadeDb = 6.0;
+    c.lowCutHz = 200.0;
+    c.highCutHz = 12000.0;
+    c.reverbMs = 400.0;
+    c.ppm = 20.0;
+    list.push_back(c);
+    c = condition("room_noisy");
+    c.snrDb = 10.0;
+    c.fadeDb = 6.0;
+    c.lowCutHz = 200.0;
+    c.highCutHz = 12000.0;
+    c.reverbMs = 400.0;
+    c.ppm = 20.0;
+    c.dropoutRate = 0.2;
+    c.dropoutMs = 50.0;
+    list.push_back(c);
+
+    return list;
+}
+
+ChannelSweep::Stats ChannelSweep::run(const ChannelSimulator::Conditions& conditions, int trials,
+                                      uint32_t seed) {
+    Stats stats;
+    stats.name = conditions.name;
+    stats.conditions = conditions;
+    stats.audioSeconds = audioSeconds;
+    stats.fileBytes = fileBytes;
+    for (int t = 0; t < trials; t++) {
+        runTrial(conditions, seed + t, stats);
+    }
+    return stats;
+}
+
+void ChannelSweep::runTrial(const ChannelSimulator::Conditions& conditions, uint32_t seed, Stats& stats) {
+    const size_t blockSize = ErrorCorrection::ENCODED_BLOCK_SIZE;
+    const size_t sent = sentSymbols.size();
+    const size_t blocks = (sent + blockSize - 1) / blockSize;
+    stats.trials++;
+    stats.symbols += sent;
+    stats.blocks += blocks;
+
+    std::vector<float> received = channel.process(transmission, conditions, seed);
+
+    AudioModulator::StreamHeader header;
+    std::vector<uint8_t> confidence;
+    std::vector<uint8_t> data = receiver.demodulate(received, &header, &confidence);
+    if (data.empty()) {
+        stats.symbolErrors += sent;
+        stats.failedBlocks += blocks;
+        return;
+    }
+    stats.synced++;
+
+    // Symbols missing at the end count as errors and are zero filled with
+    // no confidence, as in the decoder, so the group layout still lines up
+    data.resize(sent, 0);
+    confidence.resize(sent, 0);
+    for (size_t i = 0; i < sent; i++) {
+        stats.symbolErrors += data[i] != sentSymbols[i];
+    }
+
+    if (header.interleaveDepth > 1) {
+        Interleaver interleaver(header.interleaveDepth, blockSize);
+        data = interleaver.deinterleave(data);
+        confidence = interleaver.deinterleave(confidence);
+    }
+
+    ErrorCorrection::DecodeReport report;
+    std::vector<uint8_t> packet = errorCorrection.decode(data, &report, &confidence);
+    stats.failedBlocks += report.failedBlocks;
+    stats.correctedSymbols += report.correctedSymbols;
+
+    // A framed transmission is whole once every data frame and one copy
+    // of the file frame arrive intact
+    if (dataFrames > 0) {
+        std::set<uint32_t> intact;
+        Framer::Frame frame;
+        for (size_t pos = 0; pos + Framer::FRAME_SIZE <= packet.size(); pos += Framer::FRAME_SIZE) {
+            if (Framer::readFrame(packet.data() + pos, frame)) {
+                intact.insert(frame.sequence);
+            }
+        }
+        bool named = intact.count(0) > 0;
+        stats.frames += dataFrames;
+        stats.framesRecovered += intact.size() - named;
+        if (named && intact.size() == dataFrames + 1) {
+            stats.crcPassed++;
+        }
+        return;
+    }
+
+    // The packet CRC trails the packet, as parseDataPacket reads it
+    if (packetBytes >= 4 && packet.size() >= packetBytes) {
+        const uint8_t* stored = packet.data() + packetBytes - 4;
+        uint32_t storedCrc = stored[0] | (stored[1] << 8) | (stored[2] << 16) | (static_cast<uint32_t>(stored[3]) << 24);
+        if (ErrorCorrection::calculateCRC32(packet.data(), packetBytes - 4) == storedCrc) {
+            stats.crcPassed++;
+        }
+    }
+}
+
+void ChannelSweep::writeJson(const Stats& stats, std::ostream& out) {
+    const ChannelSimulator::Conditions& c = stats.conditions;
+    std::ostringstream line;
+    line << std::setprecision(6)
+         << "{\"condition\":\"" << stats.name << "\""
+         << ",\"snr_db\":" << jsonNumber(c.snrDb)
+         << ",\"gain_db\":" << c.gainDb
+         << ",\"fade_db\":" << c.fadeDb
+         << ",\"ppm\":" << c.ppm
+         << ",\"low_cut_hz\":" << c.lowCutHz
+         << ",\"high_cut_hz\":" << c.highCutHz
+         << ",\"reverb_ms\":" << c.reverbMs
+         << ",\"dropouts_per_s\":" << c.dropoutRate
+         << ",\"dropout_ms\":" << c.dropoutMs
+         << ",\"trials\":" << stats.trials
+         << ",\"sync_rate\":" << (stats.trials ? double(stats.synced) / stats.trials : 0.0)
+         << ",\"symbol_error_rate\":" << stats.symbolErrorRate()
+         << ",\"corrected_symbols\":" << stats.correctedSymbols
+         << ",\"block_failure_rate\":" << stats.blockFailureRate()
+         << ",\"crc_pass_rate\":" << stats.crcPassRate()
+         << ",\"frame_recovery_rate\":" << (stats.frames ? jsonNumber(stats.frameRecoveryRate()) : "null")
+         << ",\"goodput_bps\":" << stats.goodput()
+         << ",\"audio_seconds\":" << stats.audioSeconds
+         << ",\"file_bytes\":" << stats.fileBytes << "}";
+    out << line.str() << std::endl;
+}
@@ -0,0 +1,510 @@
+#include "Compressor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int MIN_MATCH = 3;
+constexpr int LEN_LOW = 8;                  // Lengths MIN_MATCH..+7: 3-bit tree
+constexpr int LEN_MID = 8;                  // Next 8: 3-bit tree
+constexpr int LEN_HIGH = 256;               // Rest: 8-bit tree
+constexpr int MAX_MATCH = MIN_MATCH + LEN_LOW + LEN_MID + LEN_HIGH - 1;
+
+constexpr int WINDOW_BITS = 22;             // Distances up to 4 MB
+constexpr int HASH_BITS = 16;
+constexpr int MAX_CHAIN = 48;               // Candidates checked per position
+constexpr int NICE_LENGTH = 128;            // Stop searching at this length
+constexpr int FAR_MATCH = 0x2000;           // 3-byte matches beyond this cost more than literals
+constexpr size_t RESERVE_RATIO = 8;         // Output reserved per compressed byte up front
+
+constexpr int NUM_STATES = 3;               // Previous token: literal, match, repeat
+constexpr int LEN_STATES = 4;               // Distance slot context: min(len - MIN_MATCH, 3)
+constexpr int SLOT_BITS = 6;
+constexpr int END_FOOTER_SLOT = 12;         // Slots below this code their footer with a tree
+constexpr int ALIGN_BITS = 4;
+
+// Adaptive binary range coder with 11-bit probabilities, as in LZMA
+constexpr int PROB_BITS = 11;
+constexpr uint16_t PROB_INIT = 1 << (PROB_BITS - 1);
+constexpr int MOVE_BITS = 5;
+constexpr uint32_t TOP = 1u << 24;
+
+struct LengthModel {
+    uint16_t choice;
+    uint16_t choice2;
+    uint16_t low[LEN_LOW];
+    uint16_t mid[LEN_MID];
+    uint16_t high[LEN_HIGH];
+};
+
+// Every field is a uint16_t probability, so the model initialises as one array
+struct Model {
+    uint16_t isMatch[NUM_STATES];
+    uint16_t isRep[NUM_STATES];
+    uint16_t literal[8][256];               // Context: top 3 bits of the previous byte
+    LengthModel matchLen;
+    LengthModel repLen;
+    uint16_t slot[LEN_STATES][1 << SLOT_BITS];
+    uint16_t footer[END_FOOTER_SLOT][1 << ALIGN_BITS];
+    uint16_t align[1 << ALIGN_BITS];
+
+    Model() {
+        std::fill_n(reinterpret_cast<uint16_t*>(this), sizeof(Model) / sizeof(uint16_t), PROB_INIT);
+    }
+};
+
+class RangeEncoder {
+public:
+    explicit RangeEncoder(std::vector<uint8_t>& out)
+        : out(out), low(0), range(0xFFFFFFFF), cache(0), cacheSize(1) {}
+
+    void encodeBit(uint16_t& prob, int bit) {
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        if (bit == 0) {
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> MOVE_BITS;
+        } else {
+            low += bound;
+            range -= bound;
+            prob -= prob >> MOVE_BITS;
+        }
+        while (range < TOP) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    void encodeDirect(uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; i--) {
+            range >>= 1;
+            if ((value >> i) & 1) {
+                low += range;
+            }
+            while (range < TOP) {
+                range <<= 8;
+                shiftLow();
+            }
+        }
+    }
+
+    void encodeTree(uint16_t* probs, int bits, uint32_t value) {
+        uint32_t m = 1;
+        for (int i = bits - 1; i >= 0; i--) {
+            int bit = (value >> i) & 1;
+            encodeBit(probs[m], bit);
+            m = (m << 1) | bit;
+        }
+    }
+
+    void flush() {
+        for (int i = 0; i < 5; i++) {
+            shiftLow();
+        }
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cacheSize;
+
+    // Holds back 0xFF bytes until it is known whether a carry reaches them
+    void shiftLow() {
+        if (static_cast<uint32_t>(low) < 0xFF000000u || (low >> 32) != 0) {
+            uint8_t carry = static_cast<uint8_t>(low >> 32);
+            uint8_t temp = cache;
+            do {
+                out.push_back(static_cast<uint8_t>(temp + carry));
+                temp = 0xFF;
+            } while (--cacheSize != 0);
+            cache = static_cast<uint8_t>(low >> 24);
+        }
+        cacheSize++;
+        low = (low & 0x00FFFFFF) << 8;
+    }
+};
+
+class RangeDecoder {
+public:
+    RangeDecoder(const uint8_t* data, size_t length)
+        : pos(data), end(data + length), range(0xFFFFFFFF), code(0), overrun(false) {
+        for (int i = 0; i < 5; i++) {
+            code = (code << 8) | next();
+        }
+    }
+
+    bool failed() const { return overrun; }
+
+    int decodeBit(uint16_t& prob) {
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        int bit;
+        if (code < bound) {
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> MOVE_BITS;
+            bit = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            prob -= prob >> MOVE_BITS;
+            bit = 1;
+        }
+        if (range < TOP) {
+            range <<= 8;
+            code = (code << 8) | next();
+        }
+        return bit;
+    }
+
+    uint32_t decodeDirect(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++) {
+            range >>= 1;
+            int bit = 0;
+            if (code >= range) {
+                code -= range;
+                bit = 1;
+            }
+            value = (value << 1) | bit;
+            if (range < TOP) {
+                range <<= 8;
+                code = (code << 8) | next();
+            }
+        }
+        return value;
+    }
+
+    uint32_t decodeTree(uint16_t* probs, int bits) {
+        uint32_t m = 1;
+        for (int i = 0; i < bits; i++) {
+            m = (m << 1) | decodeBit(probs[m]);
+        }
+        return m - (1u << bits);
+    }
+
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+    uint32_t range;
+    uint32_t code;
+    bool overrun;
+
+    uint8_t next() {
+        if (pos < end) {
+            return *pos++;
+        }
+        overrun = true;
+        return 0;
+    }
+};
+
+void encodeLength(RangeEncoder& rc, LengthModel& model, int length) {
+    length -= MIN_MATCH;
+    if (length < LEN_LOW) {
+        rc.encodeBit(model.choice, 0);
+        rc.encodeTree(model.low, 3, length);
+    } else if (length < LEN_LOW + LEN_MID) {
+        rc.encodeBit(model.choice, 1);
+        rc.encodeBit(model.choice2, 0);
+        rc.encodeTree(model.mid, 3, length - LEN_LOW);
+    } else {
+        rc.encodeBit(model.choice, 1);
+        rc.encodeBit(model.choice2, 1);
+        rc.encodeTree(model.high, 8, length - LEN_LOW - LEN_MID);
+    }
+}
+
+int decodeLength(RangeDecoder& rc, LengthModel& model) {
+    if (rc.decodeBit(model.choice) == 0) {
+        return MIN_MATCH + rc.decodeTree(model.low, 3);
+    }
+    if (rc.decodeBit(model.choice2) == 0) {
+        return MIN_MATCH + LEN_LOW + rc.decodeTree(model.mid, 3);
+    }
+    return MIN_MATCH + LEN_LOW + LEN_MID + rc.decodeTree(model.high, 8);
+}
+
+// Distances are coded as a 6-bit slot (the top two bits of distance - 1 and
+// their position) followed by the remaining footer bits
+int distanceSlot(uint32_t d) {
+    if (d < 4) {
+        return d;
+    }
+    int n = 31 - __builtin_clz(d);
+    return 2 * n + ((d >> (n - 1)) & 1);
+}
+
+void encodeDistance(RangeEncoder& rc, Model& model, uint32_t distance, int length) {
+    uint32_t d = distance - 1;
+    int slot = distanceSlot(d);
+    rc.encodeTree(model.slot[std::min(length - MIN_MATCH, LEN_STATES - 1)], SLOT_BITS, slot);
+    if (slot < 4) {
+        return;
+    }
+
+    int footerBits = (slot >> 1) - 1;
+    uint32_t footer = d - ((2u | (slot & 1)) << footerBits);
+    if (slot < END_FOOTER_SLOT) {
+        rc.encodeTree(model.footer[slot], footerBits, footer);
+    } else {
+        rc.encodeDirect(footer >> ALIGN_BITS, footerBits - ALIGN_BITS);
+        rc.encodeTree(model.align, ALIGN_BITS, footer & ((1u << ALIGN_BITS) - 1));
+    }
+}
+
+uint32_t decodeDistance(RangeDecoder& rc, Model& model, int length) {
+    int slot = rc.decodeTree(model.slot[std::min(length - MIN_MATCH, LEN_STATES - 1)], SLOT_BITS);
+    if (slot < 4) {
+        return slot + 1;
+    }
+
+    int footerBits = (slot >> 1) - 1;
+    uint32_t d = (2u | (slot & 1)) << footerBits;
+    if (slot < END_FOOTER_SLOT) {
+        d += rc.decodeTree(model.footer[slot], footerBits);
+    } else {
+        d += rc.decodeDirect(footerBits - ALIGN_BITS) << ALIGN_BITS;
+        d += rc.decodeTree(model.align, ALIGN_BITS);
+    }
+    return d + 1;
+}
+
+/**
+ * @brief Hash-chain match finder over the whole input
+ */
+class MatchFinder {
+public:
+    MatchFinder(const uint8_t* data, size_t length) : data(data), length(length) {
+        size_t window = 1;
+        while (window < length && window < (size_t(1) << WINDOW_BITS)) {
+            window <<= 1;
+        }
+        windowMask = window - 1;
+        head.assign(size_t(1) << HASH_BITS, -1);
+        prev.assign(window, -1);
+    }
+
+    void insert(size_t pos) {
+        if (pos + MIN_MATCH > length) {
+            return;
+        }
+        uint32_t h = hash(pos);
+        prev[pos & windowMask] = head[h];
+        head[h] = static_cast<int32_t>(pos);
+    }
+
+    // Longest earlier match at pos (length 0 if none worth coding)
+    int find(size_t pos, uint32_t& distance) const {
+        int maxLength = static_cast<int>(std::min<size_t>(MAX_MATCH, length - pos));
+        if (maxLength < MIN_MATCH) {
+            return 0;
+        }
+
+        int bestLength = MIN_MATCH - 1;
+        int32_t candidate = head[hash(pos)];
+        for (int chain = 0; chain < MAX_CHAIN && candidate >= 0; chain++) {
+            size_t dist = pos - candidate;
+            if (dist > windowMask) {
+                break;
+            }
+            if (data[candidate + bestLength] == data[pos + bestLength]) {
+                int len = matchLength(candidate, pos, maxLength);
+                if (len > bestLength && (len > MIN_MATCH || dist <= (size_t)FAR_MATCH)) {
+                    bestLength = len;
+                    distance = static_cast<uint32_t>(dist);
+                    if (len >= NICE_LENGTH || len == maxLength) {
+                        break;
+                    }
+                }
+            }
+
+            // A slot overwritten by a newer position ends the chain
+            int32_t next = prev[candidate & windowMask];
+            if (next >= candidate) {
+                break;
+            }
+            candidate = next;
+        }
+        return bestLength >= MIN_MATCH ? bestLength : 0;
+    }
+
+    int matchLength(size_t from, size_t pos, int maxLength) const {
+        int len = 0;
+        while (len < maxLength && data[from + len] == data[pos + len]) {
+            len++;
+        }
+        return len;
+    }
+
+private:
+    const uint8_t* data;
+    size_t length;
+    size_t windowMask;
+    std::vector<int32_t> head;
+    std::vector<int32_t> prev;
+
+    uint32_t hash(size_t pos) const {
+        uint32_t v = (uint32_t(data[pos]) << 16) | (uint32_t(data[pos + 1]) << 8) | data[pos + 2];
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+};
+
+enum TokenState { AFTER_LITERAL = 0, AFTER_MATCH = 1, AFTER_REP = 2 };
+
+} // namespace
+
+std::vector<uint8_t> Compressor::compress(const uint8_t* data, size_t length) {
+    std::vector<uint8_t> out;
+    out.reserve(length / 2 + 16);
+    RangeEncoder rc(out);
+    Model model;
+    MatchFinder finder(data, length);
+
+    int state = AFTER_LITERAL;
+    uint32_t rep0 = 0;
+    size_t pos = 0;
+    bool haveNext = false;          // Lazy evaluation already searched pos
+    int nextLength = 0;
+    uint32_t nextDistance = 0;
+
+    while (pos < length) {
+        uint32_t distance = 0;
+        int matchLength;
+        if (haveNext) {
+            matchLength = nextLength;
+            distance = nextDistance;
+            haveNext = false;
+        } else {
+            matchLength = finder.find(pos, distance);
+        }
+        finder.insert(pos);
+
+        int maxLength = static_cast<int>(std::min<size_t>(MAX_MATCH, length - pos));
+        int repLength = 0;
+        if (rep0 != 0 && rep0 <= pos) {
+            repLength = finder.matchLength(pos - rep0, pos, maxLength);
+        }
+
+        // Repeating the last distance is cheap enough to win near-ties
+        bool useRep = repLength >= MIN_MATCH && repLength + 1 >= matchLength;
+
+        // Lazy matching: emit a literal if the next position matches longer
+        if (!useRep && matchLength >= MIN_MATCH && matchLength < NICE_LENGTH && pos + 1 < length) {
+            nextLength = finder.find(pos + 1, nextDistance);
+            haveNext = true;
+            if (nextLength > matchLength) {
+                matchLength = 0;
+            }
+        }
+
+        if (useRep) {
+            rc.encodeBit(model.isMatch[state], 1);
+            rc.encodeBit(model.isRep[state], 1);
+            encodeLength(rc, model.repLen, repLength);
+            matchLength = repLength;
+            state = AFTER_REP;
+        } else if (matchLength >= MIN_MATCH) {
+            rc.encodeBit(model.isMatch[state], 1);
+            rc.encodeBit(model.isRep[state], 0);
+            encodeLength(rc, model.matchLen, matchLength);
+            encodeDistance(rc, model, distance, matchLength);
+            rep0 = distance;
+            state = AFTER_MATCH;
+        } else {
+            rc.encodeBit(model.isMatch[state], 0);
+            int context = pos > 0 ? data[pos - 1] >> 5 : 0;
+            rc.encodeTree(model.literal[context], 8, data[pos]);
+            state = AFTER_LITERAL;
+            pos++;
+            continue;
+        }
+
+        // The lookahead is stale once a match covers it
+        haveNext = false;
+        for (int i = 1; i < matchLength; i++) {
+            finder.insert(pos + i);
+        }
+        pos += matchLength;
+    }
+
+    rc.flush();
+    return out;
+}
+
+bool Compressor::decompress(const uint8_t* data, size_t length, size_t originalSize,
+                            std::vector<uint8_t>& out) {
+    out.clear();
+    // originalSize comes from the packet and may be corrupt: reserve what
+    // typical data expands to and let the output grow as it decodes
+    out.reserve(std::min<size_t>(originalSize, length * RESERVE_RATIO + 4096));
+    RangeDecoder rc(data, length);
+    Model model;
+
+    int state = AFTER_LITERAL;
+    uint32_t rep0 = 0;
+
+    while (out.size() < originalSize) {
+        if (rc.decodeBit(model.isMatch[state]) == 0) {
+            int context = out.empty() ? 0 : out.back() >> 5;
+            out.push_back(static_cast<uint8_t>(rc.decodeTree(model.literal[context], 8)));
+            state = AFTER_LITERAL;
+        } else {
+            int matchLength;
+            if (rc.decodeBit(model.isRep[state]) == 1) {
+                matchLength = decodeLength(rc, model.repLen);
+                state = AFTER_REP;
+            } else {
+                matchLength = decodeLength(rc, model.matchLen);
+                rep0 = decodeDistance(rc, model, matchLength);
+                state = AFTER_MATCH;
+            }
+
+            if (rep0 == 0 || rep0 > out.size() ||
+                static_cast<size_t>(matchLength) > originalSize - out.size()) {
+                return false;
+            }
+
+            // Byte by byte: the source may overlap what is being written
+            size_t from = out.size() - rep0;
+            for (int i = 0; i < matchLength; i++) {
+                out.push_back(out[from + i]);
+            }
+        }
+
+        if (rc.failed()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Compressor::looksCompressed(const uint8_t* data, size_t length) {
+    auto startsWith = [&](size_t offset, const char* magic, size_t n) {
+        return length >= offset + n && std::memcmp(data + offset, magic, n) == 0;
+    };
+
+    return startsWith(0, "\xFF\xD8\xFF", 3) ||                  // JPEG
+           startsWith(0, "\x89PNG", 4) ||                       // PNG
+           startsWith(0, "GIF8", 4) ||                          // GIF
+           (startsWith(0, "RIFF", 4) && startsWith(8, "WEBP", 4)) ||
+           startsWith(0, "ID3", 3) ||                           // MP3 with tags
+           (length >= 2 && data[0] == 0xFF && (data[1] & 0xE0) == 0xE0) || // MPEG audio frame
+           startsWith(0, "OggS", 4) ||
+           startsWith(0, "fLaC", 4) ||
+           startsWith(4, "ftyp", 4) ||                          // MP4, MOV, HEIC
+           startsWith(0, "PK\x03\x04", 4) ||                    // ZIP, DOCX, JAR, APK
+           startsWith(0, "\x1F\x8B", 2) ||                      // gzip
+           startsWith(0, "BZh", 3) ||
+           startsWith(0, "\xFD" "7zXZ", 5) ||                   // xz
+           startsWith(0, "7z\xBC\xAF\x27\x1C", 6) ||
+           startsWith(0, "\x28\xB5\x2F\xFD", 4);                // zstd
+}
+
+const char* Compressor::codecName(Codec codec) {
+    switch (codec) {
+        case CODEC_NONE: return "none";
+        case CODEC_LZRC: return "lz77+range";
+        default: return "unknown";
+    }
+}
@@ -0,0 +1,52 @@
+#include "Console.h"
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Accepts and drops everything without ever failing the stream
+class DiscardBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct ThreadConsole {
+    bool quiet = false;
+    bool progress = true;
+    DiscardBuffer discardBuffer;
+    std::ostream discard{&discardBuffer};
+    std::ostringstream errors;
+};
+
+ThreadConsole& threadConsole() {
+    thread_local ThreadConsole console;
+    return console;
+}
+
+}
+
+std::ostream& Console::info() {
+    ThreadConsole& console = threadConsole();
+    return console.quiet || !console.progress ? console.discard : std::cout;
+}
+
+std::ostream& Console::error() {
+    ThreadConsole& console = threadConsole();
+    return console.quiet ? static_cast<std::ostream&>(console.errors) : std::cerr;
+}
+
+void Console::setQuiet(bool quiet) {
+    threadConsole().quiet = quiet;
+}
+
+void Console::setProgress(bool enable) {
+    threadConsole().progress = enable;
+}
+
+std::string Console::takeErrors() {
+    ThreadConsole& console = threadConsole();
+    std::string errors = console.errors.str();
+    console.errors.str(std::string());
+    return errors;
+}
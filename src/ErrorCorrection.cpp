@@ -1,187 +1,614 @@
 #include "ErrorCorrection.h"
 #include <algorithm>
 #include <cstring>
+#include <thread>
 
-ErrorCorrection::ErrorCorrection() {
-    initGaloisField();
-}
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
-ErrorCorrection::~ErrorCorrection() {}
+namespace {
 
-void ErrorCorrection::initGaloisField() {
-    // Initialize GF(256) with primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D)
-    gf_exp.resize(512);
-    gf_log.resize(256);
-    
+constexpr int NSYM = ErrorCorrection::RS_NSYM;
+
+// GF(256) with primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D)
+struct GaloisField {
+    uint8_t exp[512];   // Duplicated so exp[log a + log b] needs no modulo
+    uint8_t log[256];   // log[0] is undefined and left as 0
+};
+
+constexpr GaloisField makeGaloisField() {
+    GaloisField gf{};
     int x = 1;
     for (int i = 0; i < 255; i++) {
-        gf_exp[i] = x;
-        gf_log[x] = i;
+        gf.exp[i] = static_cast<uint8_t>(x);
+        gf.log[x] = static_cast<uint8_t>(i);
         x <<= 1;
         if (x & 0x100) {
-            x ^= 0x11D; // Primitive polynomial
+            x ^= 0x11D;
         }
     }
-    
-    // Duplicate the table for convenience
     for (int i = 255; i < 512; i++) {
-        gf_exp[i] = gf_exp[i - 255];
+        gf.exp[i] = gf.exp[i - 255];
     }
-    
-    gf_log[0] = 0; // Log of 0 is undefined, but we set it to 0 for convenience
+    return gf;
+}
+
+constexpr GaloisField GF = makeGaloisField();
+
+constexpr uint8_t mul(uint8_t a, uint8_t b) {
+    return (a == 0 || b == 0) ? 0 : GF.exp[GF.log[a] + GF.log[b]];
 }
 
+// Generator polynomial prod (x - alpha^i), i < Parity, highest degree first
+template <int Parity>
+struct Generator {
+    uint8_t coef[Parity + 1];
+};
+
+template <int Parity>
+constexpr Generator<Parity> makeGenerator() {
+    Generator<Parity> g{};
+    g.coef[0] = 1;
+    for (int i = 0; i < Parity; i++) {
+        // Multiply by (x + alpha^i); coefficients 0..i+1 are live
+        for (int j = i + 1; j > 0; j--) {
+            g.coef[j] ^= mul(g.coef[j - 1], GF.exp[i]);
+        }
+    }
+    return g;
+}
+
+constexpr Generator<NSYM> GENERATOR = makeGenerator<NSYM>();
+
+// Split-nibble products of the generator taps: lo[n][k] = g[k+1] * n and
+// hi[n][k] = g[k+1] * (n << 4), so multiplying all taps by the feedback
+// byte is two row loads and an XOR
+struct NibbleTables {
+    alignas(32) uint8_t lo[16][NSYM];
+    alignas(32) uint8_t hi[16][NSYM];
+};
+
+constexpr NibbleTables makeNibbleTables() {
+    NibbleTables t{};
+    for (int n = 0; n < 16; n++) {
+        for (int k = 0; k < NSYM; k++) {
+            t.lo[n][k] = mul(GENERATOR.coef[k + 1], static_cast<uint8_t>(n));
+            t.hi[n][k] = mul(GENERATOR.coef[k + 1], static_cast<uint8_t>(n << 4));
+        }
+    }
+    return t;
+}
+
+constexpr NibbleTables TAPS = makeNibbleTables();
+
+// Multiply-by-root tables for the syndrome check: [j][x] = x * alpha^j
+struct RootTables {
+    uint8_t mul[NSYM][256];
+};
+
+constexpr RootTables makeRootTables() {
+    RootTables t{};
+    for (int j = 0; j < NSYM; j++) {
+        for (int v = 0; v < 256; v++) {
+            t.mul[j][v] = mul(static_cast<uint8_t>(v), GF.exp[j]);
+        }
+    }
+    return t;
+}
+
+constexpr RootTables ROOTS = makeRootTables();
+
+}
+
+ErrorCorrection::ErrorCorrection() : numThreads(0) {}
+
+ErrorCorrection::~ErrorCorrection() {}
+
 uint8_t ErrorCorrection::gfMul(uint8_t a, uint8_t b) {
-    if (a == 0 || b == 0) return 0;
-    return gf_exp[gf_log[a] + gf_log[b]];
+    return mul(a, b);
 }
 
 uint8_t ErrorCorrection::gfDiv(uint8_t a, uint8_t b) {
     if (a == 0) return 0;
     if (b == 0) return 0; // Division by zero
-    return gf_exp[(gf_log[a] + 255 - gf_log[b]) % 255];
+    return GF.exp[(GF.log[a] + 255 - GF.log[b]) % 255];
 }
 
-std::vector<uint8_t> ErrorCorrection::gfPolyMul(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
-    std::vector<uint8_t> result(a.size() + b.size() - 1, 0);
-    for (size_t i = 0; i < a.size(); i++) {
-        for (size_t j = 0; j < b.size(); j++) {
-            result[i + j] ^= gfMul(a[i], b[j]);
+void ErrorCorrection::encodeBlock(const uint8_t* data, uint8_t* parity) {
+    // Systematic LFSR: the register holds the running remainder of
+    // data(x) * x^NSYM mod g(x), highest degree in byte 0
+#if defined(__AVX2__)
+    __m256i reg = _mm256_setzero_si256();
+    for (int i = 0; i < RS_BLOCK_SIZE; i++) {
+        unsigned fb = data[i] ^ static_cast<uint8_t>(_mm_cvtsi128_si32(_mm256_castsi256_si128(reg)));
+        // Shift the whole register down one byte (across the 128-bit lanes)
+        __m256i upper = _mm256_permute2x128_si256(reg, reg, 0x81);
+        reg = _mm256_alignr_epi8(upper, reg, 1);
+        __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(TAPS.lo[fb & 15]));
+        __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i*>(TAPS.hi[fb >> 4]));
+        reg = _mm256_xor_si256(reg, _mm256_xor_si256(lo, hi));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(parity), reg);
+#elif defined(__SSSE3__)
+    __m128i reg0 = _mm_setzero_si128();
+    __m128i reg1 = _mm_setzero_si128();
+    for (int i = 0; i < RS_BLOCK_SIZE; i++) {
+        unsigned fb = data[i] ^ static_cast<uint8_t>(_mm_cvtsi128_si32(reg0));
+        reg0 = _mm_alignr_epi8(reg1, reg0, 1);
+        reg1 = _mm_srli_si128(reg1, 1);
+        const __m128i* lo = reinterpret_cast<const __m128i*>(TAPS.lo[fb & 15]);
+        const __m128i* hi = reinterpret_cast<const __m128i*>(TAPS.hi[fb >> 4]);
+        reg0 = _mm_xor_si128(reg0, _mm_xor_si128(_mm_load_si128(lo), _mm_load_si128(hi)));
+        reg1 = _mm_xor_si128(reg1, _mm_xor_si128(_mm_load_si128(lo + 1), _mm_load_si128(hi + 1)));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(parity), reg0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(parity) + 1, reg1);
+#else
+    // Portable fallback: four little-endian 64-bit words
+    uint64_t reg[NSYM / 8] = {0};
+    for (int i = 0; i < RS_BLOCK_SIZE; i++) {
+        unsigned fb = data[i] ^ static_cast<uint8_t>(reg[0]);
+        for (int w = 0; w < NSYM / 8; w++) {
+            uint64_t next = (w + 1 < NSYM / 8) ? reg[w + 1] : 0;
+            uint64_t lo, hi;
+            std::memcpy(&lo, TAPS.lo[fb & 15] + 8 * w, 8);
+            std::memcpy(&hi, TAPS.hi[fb >> 4] + 8 * w, 8);
+            reg[w] = ((reg[w] >> 8) | (next << 56)) ^ lo ^ hi;
         }
     }
-    return result;
+    std::memcpy(parity, reg, NSYM);
+#endif
 }
 
-std::vector<uint8_t> ErrorCorrection::rsGeneratorPoly(int nsym) {
-    std::vector<uint8_t> g = {1};
-    for (int i = 0; i < nsym; i++) {
-        std::vector<uint8_t> term = {1, gf_exp[i]};
-        g = gfPolyMul(g, term);
+bool ErrorCorrection::rsCalcSyndromes(const uint8_t* msg, int length, uint8_t* syndromes) {
+    // S_j = msg(alpha^j) by Horner's rule; all RS_NSYM evaluations advance
+    // together so the table lookups are independent
+    uint8_t s[RS_NSYM] = {0};
+    for (int i = 0; i < length; i++) {
+        const uint8_t c = msg[i];
+        for (int j = 0; j < RS_NSYM; j++) {
+            s[j] = ROOTS.mul[j][s[j]] ^ c;
+        }
     }
-    return g;
+    
+    uint8_t any = 0;
+    for (int j = 0; j < RS_NSYM; j++) {
+        syndromes[j] = s[j];
+        any |= s[j];
+    }
+    return any != 0;
 }
 
-std::vector<uint8_t> ErrorCorrection::rsEncode(const std::vector<uint8_t>& msg, int nsym) {
-    std::vector<uint8_t> gen = rsGeneratorPoly(nsym);
-    std::vector<uint8_t> result(msg.size() + nsym, 0);
-    
-    // Copy message
-    std::copy(msg.begin(), msg.end(), result.begin());
-    
-    // Polynomial division
-    for (size_t i = 0; i < msg.size(); i++) {
-        uint8_t coef = result[i];
-        if (coef != 0) {
-            for (size_t j = 0; j < gen.size(); j++) {
-                result[i + j] ^= gfMul(gen[j], coef);
-            }
-        }
+int ErrorCorrection::decodeBlock(uint8_t* codeword, int length) {
+    if (length <= RS_NSYM || length > ENCODED_BLOCK_SIZE) {
+        return -1;
     }
     
-    // Copy parity bytes to the end of original message
-    std::vector<uint8_t> encoded = msg;
-    encoded.insert(encoded.end(), result.begin() + msg.size(), result.end());
-    
-    return encoded;
+    uint8_t synd[RS_NSYM];
+    if (!rsCalcSyndromes(codeword, length, synd)) {
+        return 0; // Clean block
+    }
+    return correctErrata(codeword, length, synd, nullptr, 0);
 }
 
-std::vector<uint8_t> ErrorCorrection::rsDecode(const std::vector<uint8_t>& msg, int nsym) {
-    // Simplified error correction - just detect errors
-    // For production, implement full Berlekamp-Massey algorithm
-    
-    if (msg.size() < (size_t)nsym) {
-        return std::vector<uint8_t>(); // Invalid message
+int ErrorCorrection::decodeBlock(uint8_t* codeword, int length, const uint8_t* confidence, int* erased) {
+    if (erased) {
+        *erased = 0;
+    }
+    if (length <= RS_NSYM || length > ENCODED_BLOCK_SIZE) {
+        return -1;
     }
     
-    // Extract original message (remove parity bytes)
-    std::vector<uint8_t> decoded(msg.begin(), msg.end() - nsym);
-    
-    // Verify with re-encoding
-    std::vector<uint8_t> reencoded = rsEncode(decoded, nsym);
+    uint8_t synd[RS_NSYM];
+    if (!rsCalcSyndromes(codeword, length, synd)) {
+        return 0; // Clean block
+    }
+    int result = correctErrata(codeword, length, synd, nullptr, 0);
+    if (result >= 0) {
+        return result;
+    }
     
-    // Simple error detection - count differences
-    int errors = 0;
-    for (size_t i = 0; i < msg.size(); i++) {
-        if (msg[i] != reencoded[i]) {
-            errors++;
+    // Least confident symbols first; equal confidence keeps codeword order
+    int candidates[ENCODED_BLOCK_SIZE];
+    int count = 0;
+    for (int i = 0; i < length; i++) {
+        if (confidence[i] < ERASURE_THRESHOLD) {
+            candidates[count++] = i;
         }
     }
+    std::stable_sort(candidates, candidates + count,
+                     [&](int a, int b) { return confidence[a] < confidence[b]; });
+    count = std::min(count, MAX_ERASURES);
     
-    // If errors are within correctable range, accept the message
-    if (errors <= nsym / 2) {
-        return decoded;
+    // Each step trades two error-correcting symbols for four erasures
+    const int step = 4;
+    for (int f = std::min(step, count); f > 0; f = (f == count) ? 0 : std::min(f + step, count)) {
+        result = correctErrata(codeword, length, synd, candidates, f);
+        if (result >= 0) {
+            if (erased) {
+                *erased = f;
+            }
+            return result;
+        }
     }
-    
-    // Too many errors - return empty vector
-    return std::vector<uint8_t>();
+    return -1;
 }
 
-std::vector<uint8_t> ErrorCorrection::encode(const std::vector<uint8_t>& data) {
-    const int RS_NSYM = 32; // 32 parity bytes for error correction
-    const int RS_BLOCK_SIZE = 223; // Maximum data per block
+int ErrorCorrection::correctErrata(uint8_t* codeword, int length, const uint8_t* synd,
+                                   const int* erasures, int erasureCount) {
+    const int nsym = RS_NSYM;
     
-    std::vector<uint8_t> encoded;
+    // Erasure locator gamma(x) = prod (1 + X x) with X = alpha^p for the
+    // symbol of degree p = length-1-index; Berlekamp-Massey starts from it
+    // and grows it into the errata locator lambda(x), lowest degree first
+    uint8_t lambda[RS_NSYM + 1] = {1};
+    for (int e = 0; e < erasureCount; e++) {
+        uint8_t x = GF.exp[length - 1 - erasures[e]];
+        for (int i = e + 1; i > 0; i--) {
+            lambda[i] ^= gfMul(lambda[i - 1], x);
+        }
+    }
+    uint8_t prev[RS_NSYM + 1];
+    uint8_t temp[RS_NSYM + 1];
+    std::memcpy(prev, lambda, sizeof(prev));
+    int errors = erasureCount; // Degree of lambda: erasures plus errors found
+    int shift = 1;
+    uint8_t prevDiscrepancy = 1;
     
-    // Process data in blocks
-    for (size_t i = 0; i < data.size(); i += RS_BLOCK_SIZE) {
-        size_t blockSize = std::min(RS_BLOCK_SIZE, (int)(data.size() - i));
-        std::vector<uint8_t> block(data.begin() + i, data.begin() + i + blockSize);
+    for (int n = erasureCount; n < nsym; n++) {
+        uint8_t d = synd[n];
+        for (int i = 1; i <= errors && i <= n; i++) {
+            d ^= gfMul(lambda[i], synd[n - i]);
+        }
         
-        // Pad block if necessary
-        if (block.size() < RS_BLOCK_SIZE) {
-            block.resize(RS_BLOCK_SIZE, 0);
+        if (d == 0) {
+            shift++;
+            continue;
         }
         
-        // Encode block
-        std::vector<uint8_t> encodedBlock = rsEncode(block, RS_NSYM);
-        encoded.insert(encoded.end(), encodedBlock.begin(), encodedBlock.end());
+        uint8_t coef = gfDiv(d, prevDiscrepancy);
+        if (2 * errors <= n + erasureCount) {
+            std::memcpy(temp, lambda, sizeof(lambda));
+            for (int i = 0; i + shift <= nsym; i++) {
+                lambda[i + shift] ^= gfMul(coef, prev[i]);
+            }
+            errors = n + 1 + erasureCount - errors;
+            std::memcpy(prev, temp, sizeof(prev));
+            prevDiscrepancy = d;
+            shift = 1;
+        } else {
+            for (int i = 0; i + shift <= nsym; i++) {
+                lambda[i + shift] ^= gfMul(coef, prev[i]);
+            }
+            shift++;
+        }
     }
     
-    return encoded;
-}
-
-std::vector<uint8_t> ErrorCorrection::decode(const std::vector<uint8_t>& data) {
-    const int RS_NSYM = 32;
-    const int RS_BLOCK_SIZE = 223;
-    const int ENCODED_BLOCK_SIZE = RS_BLOCK_SIZE + RS_NSYM;
+    // Each error costs two parity symbols, each erasure one
+    if (2 * errors - erasureCount > nsym) {
+        return -1;
+    }
+    
+    // Chien search: coefficient at index k has degree p = length-1-k and is
+    // in error when lambda(alpha^-p) == 0
+    int positions[RS_NSYM];
+    int found = 0;
+    for (int p = 0; p < length; p++) {
+        int inv = (255 - p) % 255;
+        uint8_t sum = lambda[0];
+        for (int i = 1; i <= errors; i++) {
+            if (lambda[i]) {
+                sum ^= GF.exp[(GF.log[lambda[i]] + inv * i) % 255];
+            }
+        }
+        if (sum == 0) {
+            if (found == errors) {
+                return -1;
+            }
+            positions[found++] = p;
+        }
+    }
     
-    std::vector<uint8_t> decoded;
+    if (found != errors) {
+        return -1; // Locator roots fall outside the codeword
+    }
     
-    // Process data in blocks
-    for (size_t i = 0; i < data.size(); i += ENCODED_BLOCK_SIZE) {
-        if (i + ENCODED_BLOCK_SIZE > data.size()) {
-            break; // Incomplete block
+    // Error evaluator omega(x) = S(x) * lambda(x) mod x^nsym
+    uint8_t omega[RS_NSYM] = {0};
+    for (int i = 0; i < nsym; i++) {
+        for (int j = 0; j <= errors && j <= i; j++) {
+            omega[i] ^= gfMul(synd[i - j], lambda[j]);
         }
+    }
+    
+    // Forney (first consecutive root alpha^0): e = X * omega(X^-1) / lambda'(X^-1).
+    // Magnitudes are applied only once all are known, so a failed attempt
+    // leaves the codeword as received
+    uint8_t magnitudes[RS_NSYM];
+    for (int k = 0; k < found; k++) {
+        int p = positions[k];
+        int inv = (255 - p) % 255;
         
-        std::vector<uint8_t> block(data.begin() + i, data.begin() + i + ENCODED_BLOCK_SIZE);
-        
-        // Decode block
-        std::vector<uint8_t> decodedBlock = rsDecode(block, RS_NSYM);
+        uint8_t num = 0;
+        for (int i = 0; i < nsym; i++) {
+            if (omega[i]) {
+                num ^= GF.exp[(GF.log[omega[i]] + inv * i) % 255];
+            }
+        }
         
-        if (decodedBlock.empty()) {
-            // Failed to decode - too many errors
-            continue;
+        // Formal derivative keeps the odd-degree terms
+        uint8_t den = 0;
+        for (int i = 1; i <= errors; i += 2) {
+            if (lambda[i]) {
+                den ^= GF.exp[(GF.log[lambda[i]] + inv * (i - 1)) % 255];
+            }
+        }
+        if (den == 0) {
+            return -1;
         }
         
-        decoded.insert(decoded.end(), decodedBlock.begin(), decodedBlock.end());
+        magnitudes[k] = gfMul(GF.exp[p], gfDiv(num, den));
     }
     
-    return decoded;
+    // Erased symbols that were right anyway get a zero magnitude
+    int corrected = 0;
+    for (int k = 0; k < found; k++) {
+        codeword[length - 1 - positions[k]] ^= magnitudes[k];
+        corrected += magnitudes[k] != 0;
+    }
+    return corrected;
 }
 
-uint32_t ErrorCorrection::calculateCRC32(const std::vector<uint8_t>& data) {
-    uint32_t crc = 0xFFFFFFFF;
+template <typename Fn>
+void ErrorCorrection::forEachBlockRange(size_t numBlocks, Fn fn) {
+    int threads = numThreads > 0 ? numThreads : (int)std::thread::hardware_concurrency();
     
-    for (uint8_t byte : data) {
-        crc ^= byte;
-        for (int i = 0; i < 8; i++) {
-            if (crc & 1) {
-                crc = (crc >> 1) ^ 0xEDB88320;
+    // A block takes around a microsecond; keep workers busy long enough to
+    // amortize the spawn
+    const size_t minBlocksPerThread = 256;
+    threads = std::max(1, std::min<int>(threads, (int)(numBlocks / minBlocksPerThread)));
+    
+    if (threads == 1) {
+        fn(0, numBlocks);
+        return;
+    }
+    
+    // Contiguous ranges per worker; each writes only its own blocks
+    std::vector<std::thread> workers;
+    size_t chunk = (numBlocks + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(numBlocks, begin + chunk);
+        if (begin >= end) break;
+        workers.emplace_back(fn, begin, end);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::vector<uint8_t> ErrorCorrection::encode(const std::vector<uint8_t>& data) {
+    size_t numBlocks = (data.size() + RS_BLOCK_SIZE - 1) / RS_BLOCK_SIZE;
+    std::vector<uint8_t> encoded(numBlocks * ENCODED_BLOCK_SIZE, 0);
+    
+    forEachBlockRange(numBlocks, [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            size_t offset = b * RS_BLOCK_SIZE;
+            size_t blockSize = std::min<size_t>(RS_BLOCK_SIZE, data.size() - offset);
+            uint8_t* out = encoded.data() + b * ENCODED_BLOCK_SIZE;
+            
+            // Short final block is zero padded (output is pre-zeroed)
+            std::memcpy(out, data.data() + offset, blockSize);
+            encodeBlock(out, out + RS_BLOCK_SIZE);
+        }
+    });
+    
+    return encoded;
+}
+
+std::vector<uint8_t> ErrorCorrection::decode(const std::vector<uint8_t>& data,
+                                             DecodeReport* report,
+                                             const std::vector<uint8_t>* confidence) {
+    // A trailing partial block is dropped
+    size_t numBlocks = data.size() / ENCODED_BLOCK_SIZE;
+    std::vector<uint8_t> decoded(numBlocks * RS_BLOCK_SIZE);
+    std::vector<int> corrections(numBlocks);
+    std::vector<int> erasures(numBlocks, 0);
+    if (confidence && confidence->size() < numBlocks * ENCODED_BLOCK_SIZE) {
+        confidence = nullptr;
+    }
+    
+    forEachBlockRange(numBlocks, [&](size_t begin, size_t end) {
+        uint8_t block[ENCODED_BLOCK_SIZE];
+        for (size_t b = begin; b < end; b++) {
+            std::memcpy(block, data.data() + b * ENCODED_BLOCK_SIZE, ENCODED_BLOCK_SIZE);
+            
+            // On failure the block is left as received
+            if (confidence) {
+                corrections[b] = decodeBlock(block, ENCODED_BLOCK_SIZE,
+                                             confidence->data() + b * ENCODED_BLOCK_SIZE, &erasures[b]);
             } else {
-                crc >>= 1;
+                corrections[b] = decodeBlock(block);
             }
+            std::memcpy(decoded.data() + b * RS_BLOCK_SIZE, block, RS_BLOCK_SIZE);
+        }
+    });
+    
+    if (report) {
+        report->correctedBlocks = 0;
+        report->correctedSymbols = 0;
+        report->failedBlocks = 0;
+        report->erasureBlocks = 0;
+        for (size_t b = 0; b < numBlocks; b++) {
+            int c = corrections[b];
+            if (c < 0) {
+                report->failedBlocks++;
+            } else if (c > 0) {
+                report->correctedBlocks++;
+                report->correctedSymbols += c;
+            }
+            report->erasureBlocks += erasures[b] > 0;
+        }
+        report->corrections = std::move(corrections);
+        report->erasures = std::move(erasures);
+    }
+    
+    return decoded;
+}
+
+namespace {
+
+// Slice-by-16 tables for the reflected polynomial 0xEDB88320:
+// table[0] is the classic byte table, table[k][i] advances it k more bytes
+struct CrcTables {
+    uint32_t table[16][256];
+};
+
+constexpr CrcTables makeCrcTables() {
+    CrcTables t{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+        t.table[0][i] = crc;
+    }
+    for (int k = 1; k < 16; k++) {
+        for (int i = 0; i < 256; i++) {
+            uint32_t prev = t.table[k - 1][i];
+            t.table[k][i] = (prev >> 8) ^ t.table[0][prev & 0xFF];
         }
     }
+    return t;
+}
+
+constexpr CrcTables CRC = makeCrcTables();
+
+inline uint32_t loadLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint32_t crc32Slice16(uint32_t crc, const uint8_t* data, size_t length) {
+    const auto& T = CRC.table;
+    while (length >= 16) {
+        uint32_t a = loadLE32(data) ^ crc;
+        uint32_t b = loadLE32(data + 4);
+        uint32_t c = loadLE32(data + 8);
+        uint32_t d = loadLE32(data + 12);
+        crc = T[15][a & 0xFF] ^ T[14][(a >> 8) & 0xFF] ^ T[13][(a >> 16) & 0xFF] ^ T[12][a >> 24] ^
+              T[11][b & 0xFF] ^ T[10][(b >> 8) & 0xFF] ^ T[9][(b >> 16) & 0xFF] ^ T[8][b >> 24] ^
+              T[7][c & 0xFF] ^ T[6][(c >> 8) & 0xFF] ^ T[5][(c >> 16) & 0xFF] ^ T[4][c >> 24] ^
+              T[3][d & 0xFF] ^ T[2][(d >> 8) & 0xFF] ^ T[1][(d >> 16) & 0xFF] ^ T[0][d >> 24];
+        data += 16;
+        length -= 16;
+    }
+    while (length-- > 0) {
+        crc = (crc >> 8) ^ T[0][(crc ^ *data++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Carry-less multiply folding (Intel "Fast CRC Computation Using PCLMULQDQ",
+// constants as in Chromium's crc32_sse42_simd_). length >= 64, multiple of 16.
+__attribute__((target("pclmul,sse4.1")))
+uint32_t crc32Pclmul(uint32_t crc, const uint8_t* data, size_t length) {
+    alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+    alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+    alignas(16) static const uint64_t k5[] = {0x0163cd6124, 0x0000000000};
+    alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
     
-    return ~crc;
+    const __m128i* in = reinterpret_cast<const __m128i*>(data);
+    __m128i x1 = _mm_loadu_si128(in);
+    __m128i x2 = _mm_loadu_si128(in + 1);
+    __m128i x3 = _mm_loadu_si128(in + 2);
+    __m128i x4 = _mm_loadu_si128(in + 3);
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    in += 4;
+    length -= 64;
+    
+    // Fold four 128-bit lanes 512 bits at a time
+    while (length >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(in));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(in + 1));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(in + 2));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(in + 3));
+        in += 4;
+        length -= 64;
+    }
+    
+    // Fold the four lanes into one
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    const __m128i lanes[3] = {x2, x3, x4};
+    for (const __m128i& next : lanes) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, next), x5);
+    }
+    
+    // Remaining 128-bit blocks
+    while (length >= 16) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(in)), x5);
+        in++;
+        length -= 16;
+    }
+    
+    // 128 -> 64 bits
+    __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    // Barrett reduction to 32 bits
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+bool cpuHasPclmul() {
+    static const bool supported = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+
+#endif
+
+}
+
+uint32_t ErrorCorrection::calculateCRC32(const std::vector<uint8_t>& data) {
+    return calculateCRC32(data.data(), data.size());
+}
+
+uint32_t ErrorCorrection::calculateCRC32(const uint8_t* data, size_t length) {
+    return finalizeCRC32(updateCRC32(CRC32_INIT, data, length));
+}
+
+uint32_t ErrorCorrection::updateCRC32(uint32_t crc, const uint8_t* data, size_t length) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (length >= 64 && cpuHasPclmul()) {
+        size_t folded = length & ~static_cast<size_t>(15);
+        crc = crc32Pclmul(crc, data, folded);
+        data += folded;
+        length -= folded;
+    }
+#endif
+    return crc32Slice16(crc, data, length);
 }
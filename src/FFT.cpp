@@ -0,0 +1,177 @@
+#include "FFT.h"
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+thread_local std::vector<std::complex<double>> fftScratch;
+}
+
+FFT::FFT(int size) : n(size) {
+    if (n <= 0) {
+        n = 0;
+        return;
+    }
+
+    // Factor into radix-4 stages first, then 2, 3, 5 and any larger primes
+    int remaining = n;
+    int p = 4;
+    while (remaining > 1) {
+        while (remaining % p != 0) {
+            if (p == 4) p = 2;
+            else if (p == 2) p = 3;
+            else p += 2;
+            if (p * p > remaining) p = remaining;
+        }
+        remaining /= p;
+        factors.push_back(p);
+        factors.push_back(remaining);
+    }
+
+    twiddles.resize(n);
+    for (int i = 0; i < n; i++) {
+        double phase = -2.0 * M_PI * i / n;
+        twiddles[i] = std::complex<double>(std::cos(phase), std::sin(phase));
+    }
+}
+
+FFT::~FFT() {}
+
+void FFT::butterfly2(std::complex<double>* out, int fstride, int m) const {
+    std::complex<double>* out2 = out + m;
+    for (int k = 0; k < m; k++) {
+        std::complex<double> t = out2[k] * twiddles[k * fstride];
+        out2[k] = out[k] - t;
+        out[k] += t;
+    }
+}
+
+void FFT::butterfly4(std::complex<double>* out, int fstride, int m) const {
+    for (int k = 0; k < m; k++) {
+        std::complex<double> s0 = out[k + m] * twiddles[k * fstride];
+        std::complex<double> s1 = out[k + 2 * m] * twiddles[2 * k * fstride];
+        std::complex<double> s2 = out[k + 3 * m] * twiddles[3 * k * fstride];
+
+        std::complex<double> s5 = out[k] - s1;
+        out[k] += s1;
+        std::complex<double> s3 = s0 + s2;
+        std::complex<double> s4 = s0 - s2;
+        out[k + 2 * m] = out[k] - s3;
+        out[k] += s3;
+        out[k + m] = std::complex<double>(s5.real() + s4.imag(), s5.imag() - s4.real());
+        out[k + 3 * m] = std::complex<double>(s5.real() - s4.imag(), s5.imag() + s4.real());
+    }
+}
+
+void FFT::butterflyGeneric(std::complex<double>* out, int fstride, int m, int p) const {
+    std::vector<std::complex<double>>& scratch = fftScratch;
+    if ((int)scratch.size() < p) {
+        scratch.resize(p);
+    }
+
+    for (int u = 0; u < m; u++) {
+        int k = u;
+        for (int q = 0; q < p; q++) {
+            scratch[q] = out[k];
+            k += m;
+        }
+
+        k = u;
+        for (int q1 = 0; q1 < p; q1++) {
+            int twidx = 0;
+            std::complex<double> acc = scratch[0];
+            for (int q = 1; q < p; q++) {
+                twidx += fstride * k;
+                if (twidx >= n) twidx -= n;
+                acc += scratch[q] * twiddles[twidx];
+            }
+            out[k] = acc;
+            k += m;
+        }
+    }
+}
+
+void FFT::work(std::complex<double>* out, const std::complex<double>* in,
+               int fstride, const int* stage) const {
+    const int p = stage[0];
+    const int m = stage[1];
+    std::complex<double>* outEnd = out + p * m;
+    std::complex<double>* outBegin = out;
+
+    if (m == 1) {
+        for (; out != outEnd; ++out) {
+            *out = *in;
+            in += fstride;
+        }
+    } else {
+        for (; out != outEnd; out += m) {
+            work(out, in, fstride * p, stage + 2);
+            in += fstride;
+        }
+    }
+
+    switch (p) {
+        case 2: butterfly2(outBegin, fstride, m); break;
+        case 4: butterfly4(outBegin, fstride, m); break;
+        default: butterflyGeneric(outBegin, fstride, m, p); break;
+    }
+}
+
+void FFT::forward(const std::complex<double>* in, std::complex<double>* out) const {
+    if (n == 0) return;
+    if (n == 1) {
+        out[0] = in[0];
+        return;
+    }
+    work(out, in, 1, factors.data());
+}
+
+void FFT::inverse(const std::complex<double>* in, std::complex<double>* out) const {
+    // IFFT(x)[k] = FFT(x)[(n - k) mod n], so reverse bins 1..n-1 in place
+    forward(in, out);
+    if (n > 2) {
+        std::reverse(out + 1, out + n);
+    }
+}
+
+RealFFT::RealFFT(int size) : n(size), half(size / 2) {
+    twiddles.resize(n / 2);
+    for (int k = 0; k < n / 2; k++) {
+        double phase = -2.0 * M_PI * k / n;
+        twiddles[k] = std::complex<double>(std::cos(phase), std::sin(phase));
+    }
+}
+
+RealFFT::~RealFFT() {}
+
+void RealFFT::forward(const double* in, std::complex<double>* out) const {
+    const int h = n / 2;
+    if (h == 0) return;
+
+    // Pack even/odd samples as one complex sequence of half the length
+    thread_local std::vector<std::complex<double>> packed;
+    thread_local std::vector<std::complex<double>> spectrum;
+    if ((int)packed.size() < h) {
+        packed.resize(h);
+        spectrum.resize(h);
+    }
+    for (int i = 0; i < h; i++) {
+        packed[i] = std::complex<double>(in[2 * i], in[2 * i + 1]);
+    }
+
+    half.forward(packed.data(), spectrum.data());
+
+    // Split the interleaved spectrum into the real-input spectrum
+    out[0] = std::complex<double>(spectrum[0].real() + spectrum[0].imag(), 0.0);
+    out[h] = std::complex<double>(spectrum[0].real() - spectrum[0].imag(), 0.0);
+    for (int k = 1; k < h; k++) {
+        std::complex<double> a = spectrum[k];
+        std::complex<double> b = std::conj(spectrum[h - k]);
+        std::complex<double> even = 0.5 * (a + b);
+        std::complex<double> odd = std::complex<double>(0.0, -0.5) * (a - b);
+        out[k] = even + twiddles[k] * odd;
+    }
+}
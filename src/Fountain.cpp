@@ -0,0 +1,444 @@
+#include "Fountain.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Degree of a repair symbol: P(degree <= d) = DEGREES[d - 1] / 2^20. This is
+// the RaptorQ distribution (mean about 4.8); the precode recovers the few
+// intermediate symbols that so sparse a code leaves uncovered
+const uint32_t DEGREES[] = {
+    5243, 529531, 704294, 791675, 844104, 879057, 904023, 922747, 937311, 948962,
+    958494, 966438, 973160, 978921, 983914, 988283, 992138, 995565, 998631, 1001391,
+    1003887, 1006157, 1008229, 1010129, 1011876, 1013490, 1014983, 1016370, 1017662, 1048576
+};
+
+constexpr uint32_t DENSE_SYMBOLS = 16;  // Each a parity of a random half of the others
+constexpr uint32_t MAX_BUCKET = 64;     // Rows this dense or denser share one bucket
+
+enum ColumnState : uint8_t { ACTIVE, PIVOT, INACTIVE };
+
+// splitmix64: cheap, and the same on every platform
+uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+bool isPrime(uint32_t n) {
+    if (n < 2) return false;
+    for (uint32_t d = 2; d * d <= n; d++) {
+        if (n % d == 0) return false;
+    }
+    return true;
+}
+
+// Plain loop: the compiler vectorizes it, and symbols are too short for
+// anything cleverer to pay off
+inline void xorInto(uint8_t* dst, const uint8_t* src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+inline void xorWords(uint64_t* dst, const uint64_t* src, size_t words) {
+    for (size_t i = 0; i < words; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+}
+
+Fountain::Fountain(uint64_t length, size_t symbolSize)
+    : length(length), symbolSize(symbolSize), inactivated(0) {
+    K = static_cast<uint32_t>(std::max<uint64_t>(1, (length + symbolSize - 1) / symbolSize));
+
+    // RaptorQ's LDPC sizing: about 1% of K plus the smallest X with
+    // X(X - 1) >= 2K, rounded up to a prime so the circulant steps below
+    // never repeat a row
+    uint32_t x = 2;
+    while (static_cast<uint64_t>(x) * (x - 1) < 2ULL * K) {
+        x++;
+    }
+    S = (K + 99) / 100 + x;
+    while (!isPrime(S)) {
+        S++;
+    }
+    H = DENSE_SYMBOLS;
+    L = K + S + H;
+
+    // The encoder needs rows 0..K-1 and the precode to pin down every
+    // intermediate symbol; a few seeds in, one does. Encoder and decoder
+    // both find it from K alone
+    std::vector<uint32_t> source(K);
+    for (uint32_t i = 0; i < K; i++) source[i] = i;
+    for (seed = 0; !solve(source, nullptr, 0); seed++) {
+    }
+}
+
+uint32_t Fountain::denseMask(uint32_t column) const {
+    uint64_t state = 0xD1B54A32D192ED03ULL ^ column;
+    return static_cast<uint32_t>(nextRandom(state)) & ((1u << H) - 1);
+}
+
+void Fountain::rowColumns(uint32_t esi, std::vector<uint32_t>& columns) const {
+    columns.clear();
+    uint64_t state = ((static_cast<uint64_t>(K) << 32) | esi) ^ (static_cast<uint64_t>(seed) * 0xA24BAED4963EE407ULL);
+    uint32_t v = static_cast<uint32_t>(nextRandom(state)) & 0xFFFFF;
+    uint32_t degree = 1;
+    while (v >= DEGREES[degree - 1]) {
+        degree++;
+    }
+    const uint32_t sparse = K + S;
+    degree = std::min(degree, sparse);
+    while (columns.size() < degree) {
+        uint32_t column = static_cast<uint32_t>(nextRandom(state) % sparse);
+        if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+            columns.push_back(column);
+        }
+    }
+    uint64_t r = nextRandom(state);
+    uint32_t dense = 2 + (r & 1);
+    while (columns.size() < degree + dense) {
+        uint32_t column = sparse + static_cast<uint32_t>(nextRandom(state) % H);
+        if (std::find(columns.begin() + degree, columns.end(), column) == columns.end()) {
+            columns.push_back(column);
+        }
+    }
+}
+
+void Fountain::appendConstraintRows(std::vector<uint32_t>& start, std::vector<uint32_t>& columns) const {
+    // LDPC: source i adds into three parity symbols a circulant step apart;
+    // each parity symbol is the XOR of its sources, so source ^ ... ^ parity = 0
+    std::vector<uint32_t> count(S, 1);
+    auto ldpc = [&](uint32_t i, uint32_t* rows) {
+        uint32_t a = 1 + (i / S) % (S - 1);
+        rows[0] = i % S;
+        rows[1] = (rows[0] + a) % S;
+        rows[2] = (rows[1] + a) % S;
+    };
+    uint32_t rows[3];
+    for (uint32_t i = 0; i < K; i++) {
+        ldpc(i, rows);
+        for (uint32_t row : rows) count[row]++;
+    }
+    size_t base = columns.size();
+    std::vector<size_t> fill(S);
+    for (uint32_t s = 0; s < S; s++) {
+        fill[s] = base;
+        base += count[s];
+        start.push_back(static_cast<uint32_t>(base));
+    }
+    columns.resize(base);
+    for (uint32_t i = 0; i < K; i++) {
+        ldpc(i, rows);
+        for (uint32_t row : rows) columns[fill[row]++] = i;
+    }
+    for (uint32_t s = 0; s < S; s++) {
+        columns[fill[s]] = K + s;
+    }
+
+    // Dense: each of the K + S symbols before them joins about half
+    std::vector<uint32_t> masks(K + S);
+    for (uint32_t j = 0; j < K + S; j++) {
+        masks[j] = denseMask(j);
+    }
+    for (uint32_t h = 0; h < H; h++) {
+        for (uint32_t j = 0; j < K + S; j++) {
+            if (masks[j] >> h & 1) {
+                columns.push_back(j);
+            }
+        }
+        columns.push_back(K + S + h);
+        start.push_back(static_cast<uint32_t>(columns.size()));
+    }
+}
+
+void Fountain::setSource(const uint8_t* data) {
+    std::vector<uint8_t> source(static_cast<size_t>(K) * symbolSize, 0);
+    std::memcpy(source.data(), data, length);
+    std::vector<uint32_t> rows(K);
+    for (uint32_t i = 0; i < K; i++) rows[i] = i;
+    solve(rows, source.data(), symbolSize);
+}
+
+void Fountain::encodeSymbol(uint32_t esi, uint8_t* out) const {
+    thread_local std::vector<uint32_t> columns;
+    rowColumns(esi, columns);
+    std::memset(out, 0, symbolSize);
+    for (uint32_t column : columns) {
+        xorInto(out, &intermediate[static_cast<size_t>(column) * symbolSize], symbolSize);
+    }
+}
+
+bool Fountain::addSymbol(uint32_t esi, const uint8_t* symbol) {
+    if (!seen.insert(esi).second) {
+        return false;
+    }
+    esis.push_back(esi);
+    received.insert(received.end(), symbol, symbol + symbolSize);
+    return true;
+}
+
+bool Fountain::decode(std::vector<uint8_t>& out) {
+    const size_t T = symbolSize;
+    inactivated = 0;
+    if (esis.size() < K) {
+        return false;
+    }
+
+    // Every source symbol arrived: nothing to solve
+    std::vector<int64_t> sourceAt(K, -1);
+    uint32_t sources = 0;
+    for (size_t r = 0; r < esis.size(); r++) {
+        if (esis[r] < K) {
+            sourceAt[esis[r]] = static_cast<int64_t>(r);
+            sources++;
+        }
+    }
+    out.resize(static_cast<size_t>(K) * T);
+    if (sources == K) {
+        for (uint32_t i = 0; i < K; i++) {
+            std::memcpy(&out[static_cast<size_t>(i) * T], &received[static_cast<size_t>(sourceAt[i]) * T], T);
+        }
+    } else {
+        if (!solve(esis, received.data(), T)) {
+            out.clear();
+            return false;
+        }
+        for (uint32_t i = 0; i < K; i++) {
+            encodeSymbol(i, &out[static_cast<size_t>(i) * T]);
+        }
+    }
+    out.resize(length);
+    return true;
+}
+
+bool Fountain::solve(const std::vector<uint32_t>& esis, const uint8_t* values, size_t T) {
+    const uint32_t received = static_cast<uint32_t>(esis.size());
+    inactivated = 0;
+
+    // Rows: the received symbols, then the precode constraints (right-hand side 0)
+    std::vector<uint32_t> start(1, 0);
+    std::vector<uint32_t> columns;
+    columns.reserve(static_cast<size_t>(received) * 5 + 3 * K + S + H * (K + S) / 2);
+    std::vector<uint32_t> row;
+    for (uint32_t esi : esis) {
+        rowColumns(esi, row);
+        columns.insert(columns.end(), row.begin(), row.end());
+        start.push_back(static_cast<uint32_t>(columns.size()));
+    }
+    appendConstraintRows(start, columns);
+    const uint32_t rows = static_cast<uint32_t>(start.size() - 1);
+    auto rhs = [&](uint32_t r) -> const uint8_t* {
+        return values && r < received ? values + static_cast<size_t>(r) * T : nullptr;
+    };
+
+    // Column -> rows
+    std::vector<uint32_t> columnStart(L + 1, 0);
+    for (uint32_t c : columns) columnStart[c + 1]++;
+    for (uint32_t c = 0; c < L; c++) columnStart[c + 1] += columnStart[c];
+    std::vector<uint32_t> columnRows(columns.size());
+    {
+        std::vector<uint32_t> fill(columnStart.begin(), columnStart.end() - 1);
+        for (uint32_t r = 0; r < rows; r++) {
+            for (uint32_t k = start[r]; k < start[r + 1]; k++) {
+                columnRows[fill[columns[k]]++] = r;
+            }
+        }
+    }
+
+    // Peeling with inactivation. A row's unknowns are its columns still
+    // ACTIVE; their XOR names the last one once only one is left
+    std::vector<uint32_t> degree(rows);
+    std::vector<uint32_t> lastColumn(rows, 0);
+    std::vector<uint8_t> used(rows, 0);
+    std::vector<uint8_t> state(L, ACTIVE);
+    std::vector<uint32_t> pivotRow(L);
+    std::vector<uint32_t> order;                // Pivot columns, in the order they were solved
+    std::vector<uint32_t> inactive;
+    std::vector<uint32_t> ones;                 // Rows with one unknown
+    std::vector<std::vector<uint32_t>> buckets(MAX_BUCKET + 1);
+    uint32_t minBucket = MAX_BUCKET + 1;
+    order.reserve(L);
+
+    auto bucketOf = [](uint32_t d) { return std::min(d, MAX_BUCKET); };
+    auto file = [&](uint32_t r) {
+        if (degree[r] == 1) {
+            ones.push_back(r);
+        } else if (degree[r] >= 2) {
+            uint32_t b = bucketOf(degree[r]);
+            buckets[b].push_back(r);
+            minBucket = std::min(minBucket, b);
+        }
+    };
+    for (uint32_t r = 0; r < rows; r++) {
+        degree[r] = start[r + 1] - start[r];
+        for (uint32_t k = start[r]; k < start[r + 1]; k++) lastColumn[r] ^= columns[k];
+        file(r);
+    }
+    auto retire = [&](uint32_t c) {
+        for (uint32_t k = columnStart[c]; k < columnStart[c + 1]; k++) {
+            uint32_t r = columnRows[k];
+            degree[r]--;
+            lastColumn[r] ^= c;
+            if (!used[r]) file(r);
+        }
+    };
+
+    uint32_t unknown = L;
+    while (unknown > 0) {
+        if (!ones.empty()) {
+            uint32_t r = ones.back();
+            ones.pop_back();
+            if (used[r] || degree[r] != 1) continue;
+            uint32_t c = lastColumn[r];
+            used[r] = 1;
+            state[c] = PIVOT;
+            pivotRow[c] = r;
+            order.push_back(c);
+            unknown--;
+            retire(c);
+            continue;
+        }
+
+        // Stuck: the sparsest row keeps one unknown, the rest go inactive
+        uint32_t r = rows;
+        while (minBucket <= MAX_BUCKET && r == rows) {
+            std::vector<uint32_t>& bucket = buckets[minBucket];
+            if (bucket.empty()) {
+                minBucket++;
+                continue;
+            }
+            uint32_t candidate = bucket.back();
+            bucket.pop_back();
+            if (!used[candidate] && degree[candidate] >= 2 && bucketOf(degree[candidate]) == minBucket) {
+                r = candidate;
+            }
+        }
+        auto inactivate = [&](uint32_t c) {
+            state[c] = INACTIVE;
+            inactive.push_back(c);
+            unknown--;
+            retire(c);
+        };
+        if (r == rows) {
+            // No row has an unknown left to solve: only elimination can tell
+            for (uint32_t c = 0; c < L; c++) {
+                if (state[c] == ACTIVE) inactivate(c);
+            }
+            break;
+        }
+        bool kept = false;
+        for (uint32_t k = start[r]; k < start[r + 1]; k++) {
+            uint32_t c = columns[k];
+            if (state[c] != ACTIVE) continue;
+            if (kept) {
+                inactivate(c);
+            }
+            kept = true;
+        }
+    }
+    const uint32_t I = static_cast<uint32_t>(inactive.size());
+    const size_t W = (I + 63) / 64;
+    inactivated = I;
+
+    // Each pivot column as a symbol plus a combination of inactive columns
+    intermediate.assign(static_cast<size_t>(L) * T, 0);
+    std::vector<uint64_t> bits(static_cast<size_t>(L) * W, 0);
+    std::vector<uint32_t> inactiveIndex(L, 0);
+    for (uint32_t j = 0; j < I; j++) inactiveIndex[inactive[j]] = j;
+    auto substitute = [&](uint32_t r, uint32_t skip, uint8_t* value, uint64_t* mask) {
+        if (const uint8_t* data = rhs(r)) {
+            xorInto(value, data, T);
+        }
+        for (uint32_t k = start[r]; k < start[r + 1]; k++) {
+            uint32_t x = columns[k];
+            if (x == skip) continue;
+            if (state[x] == INACTIVE) {
+                mask[inactiveIndex[x] / 64] ^= 1ULL << (inactiveIndex[x] % 64);
+            } else {
+                xorWords(mask, &bits[static_cast<size_t>(x) * W], W);
+                xorInto(value, &intermediate[static_cast<size_t>(x) * T], T);
+            }
+        }
+    };
+    for (uint32_t c : order) {
+        substitute(pivotRow[c], c, &intermediate[static_cast<size_t>(c) * T], &bits[static_cast<size_t>(c) * W]);
+    }
+
+    if (I > 0) {
+        // The rows left over constrain the inactive columns alone
+        std::vector<uint32_t> leftover;
+        for (uint32_t r = 0; r < rows; r++) {
+            if (!used[r]) leftover.push_back(r);
+        }
+        const size_t M = leftover.size();
+        if (M < I) {
+            return false;
+        }
+        std::vector<uint64_t> system(M * W, 0);
+        std::vector<uint8_t> values(M * T, 0);
+        for (size_t m = 0; m < M; m++) {
+            substitute(leftover[m], L, &values[m * T], &system[m * W]);
+        }
+
+        // Gaussian elimination over GF(2) on bit-packed rows, through a row permutation
+        std::vector<uint32_t> perm(M);
+        for (size_t m = 0; m < M; m++) perm[m] = static_cast<uint32_t>(m);
+        for (uint32_t j = 0; j < I; j++) {
+            const uint64_t bit = 1ULL << (j % 64);
+            const size_t word = j / 64;
+            size_t p = j;
+            while (p < M && !(system[perm[p] * W + word] & bit)) p++;
+            if (p == M) {
+                return false;
+            }
+            std::swap(perm[j], perm[p]);
+            const uint64_t* pivot = &system[perm[j] * W];
+            const uint8_t* pivotValue = &values[perm[j] * T];
+            for (size_t q = j + 1; q < M; q++) {
+                uint64_t* other = &system[perm[q] * W];
+                if (other[word] & bit) {
+                    xorWords(other + word, pivot + word, W - word);
+                    xorInto(&values[perm[q] * T], pivotValue, T);
+                }
+            }
+        }
+        for (uint32_t j = I; j-- > 0;) {
+            uint8_t* value = &values[perm[j] * T];
+            const uint64_t* mask = &system[perm[j] * W];
+            for (uint32_t k = j + 1; k < I; k++) {
+                if (mask[k / 64] >> (k % 64) & 1) {
+                    xorInto(value, &values[perm[k] * T], T);
+                }
+            }
+            std::memcpy(&intermediate[static_cast<size_t>(inactive[j]) * T], value, T);
+        }
+
+        // Back into the pivot columns eight inactive columns at a time:
+        // one 256-entry table of their XOR combinations stays in cache
+        std::vector<uint8_t> table(256 * T);
+        for (uint32_t g = 0; g < I; g += 8) {
+            const uint32_t n = std::min<uint32_t>(8, I - g);
+            std::memset(table.data(), 0, T);
+            for (uint32_t m = 1; m < (1u << n); m++) {
+                uint32_t low = m & (m - 1);
+                uint32_t j = g + __builtin_ctz(m);
+                std::memcpy(&table[m * T], &table[low * T], T);
+                xorInto(&table[m * T], &intermediate[static_cast<size_t>(inactive[j]) * T], T);
+            }
+            const size_t word = g / 64;
+            const uint32_t shift = g % 64;
+            for (uint32_t c : order) {
+                uint32_t m = static_cast<uint32_t>(bits[static_cast<size_t>(c) * W + word] >> shift) & 0xFF;
+                if (m) {
+                    xorInto(&intermediate[static_cast<size_t>(c) * T], &table[m * T], T);
+                }
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,179 @@
+#include "Framer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+void putU32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t getU32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Marker, type, sequence, offset and length, then the zero-padded payload and CRC
+void writeFrame(Framer::FrameType type, uint32_t sequence, uint32_t offset,
+                const uint8_t* payload, size_t length, uint8_t* out) {
+    out[0] = Framer::MARKER0;
+    out[1] = Framer::MARKER1;
+    out[2] = static_cast<uint8_t>(type);
+    putU32(out + 3, sequence);
+    putU32(out + 7, offset);
+    out[11] = static_cast<uint8_t>(length);
+    std::memcpy(out + Framer::HEADER_SIZE, payload, length);
+    std::memset(out + Framer::HEADER_SIZE + length, 0, Framer::PAYLOAD_SIZE - length);
+    const size_t covered = Framer::FRAME_SIZE - 4;
+    putU32(out + covered, ErrorCorrection::calculateCRC32(out, covered));
+}
+
+}
+
+uint32_t Framer::dataFrames(uint64_t fileLength) {
+    return static_cast<uint32_t>((fileLength + PAYLOAD_SIZE - 1) / PAYLOAD_SIZE);
+}
+
+bool Framer::covers(const std::vector<Range>& ranges, uint32_t index) {
+    if (ranges.empty()) {
+        return true;
+    }
+    uint64_t first = static_cast<uint64_t>(index) * PAYLOAD_SIZE;
+    uint64_t last = first + PAYLOAD_SIZE - 1;
+    for (const Range& range : ranges) {
+        if (range.first <= last && range.last >= first) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t Framer::coveredFrames(const std::vector<Range>& ranges, uint64_t fileLength) {
+    uint32_t frames = dataFrames(fileLength);
+    if (ranges.empty()) {
+        return frames;
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        count += covers(ranges, i);
+    }
+    return count;
+}
+
+void Framer::writeFileFrame(const FileInfo& info, uint8_t* out) {
+    uint8_t payload[PAYLOAD_SIZE];
+    size_t nameLength = std::min<size_t>(info.filename.size(), PAYLOAD_SIZE - (info.fountain ? 10 : 9));
+    payload[0] = static_cast<uint8_t>(nameLength);
+    std::memcpy(payload + 1, info.filename.data(), nameLength);
+    putU32(payload + 1 + nameLength, info.length);
+    putU32(payload + 5 + nameLength, info.crc);
+    size_t length = nameLength + 9;
+    if (info.fountain) {
+        payload[length++] = 1;
+    }
+    writeFrame(FRAME_FILE, 0, 0, payload, length, out);
+}
+
+void Framer::writeDataFrame(uint32_t index, const uint8_t* data, size_t length, uint8_t* out) {
+    writeFrame(FRAME_DATA, index + 1, index * PAYLOAD_SIZE, data, std::min<size_t>(length, PAYLOAD_SIZE), out);
+}
+
+void Framer::writeFountainFrame(uint32_t esi, uint32_t fileLength, const uint8_t* symbol, uint8_t* out) {
+    writeFrame(FRAME_FOUNTAIN, esi, fileLength, symbol, PAYLOAD_SIZE, out);
+}
+
+bool Framer::readFrame(const uint8_t* frame, Frame& out) {
+    if (frame[0] != MARKER0 || frame[1] != MARKER1) {
+        return false;
+    }
+    const size_t covered = FRAME_SIZE - 4;
+    if (ErrorCorrection::calculateCRC32(frame, covered) != getU32(frame + covered)) {
+        return false;
+    }
+    out.type = static_cast<FrameType>(frame[2]);
+    out.sequence = getU32(frame + 3);
+    out.offset = getU32(frame + 7);
+    out.length = frame[11];
+    out.payload = frame + HEADER_SIZE;
+
+    // Fields the CRC vouches for but a different sender could still get wrong
+    if (out.length > PAYLOAD_SIZE) {
+        return false;
+    }
+    if (out.type == FRAME_FILE) {
+        return out.sequence == 0 && out.offset == 0;
+    }
+    if (out.type == FRAME_FOUNTAIN) {
+        return out.length == PAYLOAD_SIZE && out.offset > 0;
+    }
+    return out.type == FRAME_DATA && out.sequence > 0 &&
+           static_cast<uint64_t>(out.sequence - 1) * PAYLOAD_SIZE == out.offset;
+}
+
+bool Framer::readFileInfo(const Frame& frame, FileInfo& info) {
+    if (frame.type != FRAME_FILE || frame.length < 9) {
+        return false;
+    }
+    size_t nameLength = frame.payload[0];
+    if (nameLength + 9 != frame.length && nameLength + 10 != frame.length) {
+        return false;
+    }
+    info.filename.assign(reinterpret_cast<const char*>(frame.payload + 1), nameLength);
+    info.length = getU32(frame.payload + 1 + nameLength);
+    info.crc = getU32(frame.payload + 5 + nameLength);
+    info.fountain = nameLength + 10 == frame.length && (frame.payload[9 + nameLength] & 1);
+    return true;
+}
+
+bool Framer::isFramed(const uint8_t* data, size_t length) {
+    // A data packet always opens with its "AED" magic
+    if (length >= 3 && data[0] == 'A' && data[1] == 'E' && data[2] == 'D') {
+        return false;
+    }
+    Frame frame;
+    for (size_t pos = 0; pos + FRAME_SIZE <= length; pos++) {
+        if (readFrame(data + pos, frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Framer::parseRanges(const std::string& text, std::vector<Range>& ranges) {
+    ranges.clear();
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        const char* p = item.c_str();
+        char* end;
+        Range range;
+        range.first = std::strtoull(p, &end, 10);
+        if (end == p) {
+            return false;
+        }
+        range.last = range.first;
+        if (*end == '-') {
+            p = end + 1;
+            range.last = std::strtoull(p, &end, 10);
+            if (end == p) {
+                return false;
+            }
+        }
+        if (*end != '\0' || range.last < range.first) {
+            return false;
+        }
+        ranges.push_back(range);
+    }
+    return !ranges.empty();
+}
+
+std::string Framer::formatRanges(const std::vector<Range>& ranges) {
+    std::ostringstream out;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        out << (i ? "," : "") << ranges[i].first << "-" << ranges[i].last;
+    }
+    return out.str();
+}
@@ -0,0 +1,64 @@
+#include "Interleaver.h"
+#include <algorithm>
+#include <cstring>
+
+Interleaver::Interleaver(int depth, size_t blockSize)
+    : depth(std::max(1, std::min(depth, MAX_DEPTH))), blockSize(blockSize) {}
+
+void Interleaver::interleave(const uint8_t* in, size_t length, uint8_t* out) const {
+    if (depth == 1) {
+        std::memcpy(out, in, length);
+        return;
+    }
+    
+    // A trailing partial codeword is passed through unchanged
+    size_t whole = length - length % blockSize;
+    std::memcpy(out + whole, in + whole, length - whole);
+    
+    for (size_t group = 0; group < whole; group += groupBytes()) {
+        size_t blocks = std::min(groupBytes(), whole - group) / blockSize;
+        const uint8_t* src = in + group;
+        uint8_t* dst = out + group;
+        
+        // Row b of the group becomes column b of the output
+        for (size_t b = 0; b < blocks; b++) {
+            for (size_t j = 0; j < blockSize; j++) {
+                dst[j * blocks + b] = src[b * blockSize + j];
+            }
+        }
+    }
+}
+
+void Interleaver::deinterleave(const uint8_t* in, size_t length, uint8_t* out) const {
+    if (depth == 1) {
+        std::memcpy(out, in, length);
+        return;
+    }
+    
+    size_t whole = length - length % blockSize;
+    std::memcpy(out + whole, in + whole, length - whole);
+    
+    for (size_t group = 0; group < whole; group += groupBytes()) {
+        size_t blocks = std::min(groupBytes(), whole - group) / blockSize;
+        const uint8_t* src = in + group;
+        uint8_t* dst = out + group;
+        
+        for (size_t b = 0; b < blocks; b++) {
+            for (size_t j = 0; j < blockSize; j++) {
+                dst[b * blockSize + j] = src[j * blocks + b];
+            }
+        }
+    }
+}
+
+std::vector<uint8_t> Interleaver::interleave(const std::vector<uint8_t>& data) const {
+    std::vector<uint8_t> out(data.size());
+    interleave(data.data(), data.size(), out.data());
+    return out;
+}
+
+std::vector<uint8_t> Interleaver::deinterleave(const std::vector<uint8_t>& data) const {
+    std::vector<uint8_t> out(data.size());
+    deinterleave(data.data(), data.size(), out.data());
+    return out;
+}
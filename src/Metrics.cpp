@@ -0,0 +1,192 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+thread_local Metrics* attached = nullptr;
+
+}
+
+Metrics::Metrics() : depth(0), origin(wallNow()) {}
+
+double Metrics::wallNow() {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double Metrics::cpuNow() {
+    timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+        return 0.0;
+    }
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+void Metrics::attach(Metrics* metrics) {
+    attached = metrics;
+}
+
+Metrics* Metrics::current() {
+    return attached;
+}
+
+void Metrics::count(const char* name, uint64_t delta) {
+    Metrics* metrics = attached;
+    if (!metrics) {
+        return;
+    }
+    // A handful of counters per run, so a linear scan beats a map
+    for (auto& counter : metrics->counters) {
+        if (std::strcmp(counter.first.c_str(), name) == 0) {
+            counter.second += delta;
+            return;
+        }
+    }
+    metrics->counters.emplace_back(name, delta);
+}
+
+void Metrics::addHistogram(const char* name, double bucketWidth, const std::vector<uint64_t>& counts) {
+    Metrics* metrics = attached;
+    if (!metrics) {
+        return;
+    }
+    Histogram* histogram = nullptr;
+    for (auto& h : metrics->histograms) {
+        if (std::strcmp(h.name.c_str(), name) == 0) {
+            histogram = &h;
+            break;
+        }
+    }
+    if (!histogram) {
+        metrics->histograms.emplace_back();
+        histogram = &metrics->histograms.back();
+        histogram->name = name;
+        histogram->bucketWidth = bucketWidth;
+    }
+    if (histogram->counts.size() < counts.size()) {
+        histogram->counts.resize(counts.size(), 0);
+    }
+    for (size_t i = 0; i < counts.size(); i++) {
+        histogram->counts[i] += counts[i];
+    }
+}
+
+void Metrics::append(const char* name, double value) {
+    Metrics* metrics = attached;
+    if (!metrics) {
+        return;
+    }
+    for (auto& s : metrics->series) {
+        if (std::strcmp(s.first.c_str(), name) == 0) {
+            s.second.push_back(value);
+            return;
+        }
+    }
+    metrics->series.emplace_back(name, std::vector<double>{value});
+}
+
+Metrics::Scope::Scope(const char* name) : metrics(attached), index(0), cpuStart(0.0) {
+    if (!metrics) {
+        return;
+    }
+    Stage stage;
+    stage.name = name;
+    stage.depth = metrics->depth++;
+    stage.startUs = wallNow() - metrics->origin;
+    index = metrics->stages.size();
+    metrics->stages.push_back(stage);
+    cpuStart = cpuNow();
+}
+
+Metrics::Scope::~Scope() {
+    if (!metrics) {
+        return;
+    }
+    Stage& stage = metrics->stages[index];
+    stage.cpuUs = cpuNow() - cpuStart;
+    stage.wallUs = wallNow() - metrics->origin - stage.startUs;
+    metrics->depth--;
+}
+
+void Metrics::Scope::addBytes(uint64_t count) {
+    if (metrics) {
+        metrics->stages[index].bytes += count;
+    }
+}
+
+void Metrics::Scope::addSamples(uint64_t count) {
+    if (metrics) {
+        metrics->stages[index].samples += count;
+    }
+}
+
+void Metrics::writeJson(std::ostream& out) const {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\n  \"stages\": [";
+    for (size_t i = 0; i < stages.size(); i++) {
+        const Stage& s = stages[i];
+        json << (i ? ",\n" : "\n")
+             << "    {\"name\": \"" << s.name << "\", \"depth\": " << s.depth
+             << ", \"start_ms\": " << s.startUs / 1e3
+             << ", \"wall_ms\": " << s.wallUs / 1e3
+             << ", \"cpu_ms\": " << s.cpuUs / 1e3
+             << ", \"bytes\": " << s.bytes
+             << ", \"samples\": " << s.samples << "}";
+    }
+    json << "\n  ],\n  \"counters\": {";
+    for (size_t i = 0; i < counters.size(); i++) {
+        json << (i ? ",\n" : "\n") << "    \"" << counters[i].first << "\": " << counters[i].second;
+    }
+    json << "\n  },\n  \"histograms\": {";
+    for (size_t i = 0; i < histograms.size(); i++) {
+        const Histogram& h = histograms[i];
+        json << (i ? ",\n" : "\n") << "    \"" << h.name << "\": {\"bucket_width\": " << h.bucketWidth
+             << ", \"counts\": [";
+        for (size_t b = 0; b < h.counts.size(); b++) {
+            json << (b ? ", " : "") << h.counts[b];
+        }
+        json << "]}";
+    }
+    json << "\n  },\n  \"series\": {";
+    json << std::defaultfloat;
+    for (size_t i = 0; i < series.size(); i++) {
+        json << (i ? ",\n" : "\n") << "    \"" << series[i].first << "\": [";
+        for (size_t v = 0; v < series[i].second.size(); v++) {
+            json << (v ? ", " : "") << series[i].second[v];
+        }
+        json << "]";
+    }
+    json << "\n  }\n}\n";
+    out << json.str();
+}
+
+void Metrics::writeTrace(std::ostream& out) const {
+    // Complete ("X") events nest by time on one track; counters are
+    // emitted once, at the end of the run
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    double end = 0.0;
+    for (size_t i = 0; i < stages.size(); i++) {
+        const Stage& s = stages[i];
+        end = std::max(end, s.startUs + s.wallUs);
+        json << (i ? ",\n" : "\n")
+             << "{\"name\": \"" << s.name << "\", \"cat\": \"stage\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1"
+             << ", \"ts\": " << s.startUs << ", \"dur\": " << s.wallUs
+             << ", \"args\": {\"cpu_ms\": " << s.cpuUs / 1e3
+             << ", \"bytes\": " << s.bytes << ", \"samples\": " << s.samples << "}}";
+    }
+    for (size_t i = 0; i < counters.size(); i++) {
+        json << (stages.empty() && i == 0 ? "\n" : ",\n")
+             << "{\"name\": \"" << counters[i].first << "\", \"ph\": \"C\", \"pid\": 1, \"tid\": 1"
+             << ", \"ts\": " << end << ", \"args\": {\"value\": " << counters[i].second << "}}";
+    }
+    json << "\n]}\n";
+    out << json.str();
+}
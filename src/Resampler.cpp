@@ -0,0 +1,135 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+// Cutoff at the lower Nyquist rate with a transition of about +/-1.3% of the
+// output rate: the ultrasonic profile's top tone (21.4 kHz at 44.1 kHz)
+// still passes, and only content within ~600 Hz of Nyquist aliases
+constexpr double ROLLOFF = 1.0;         // Cutoff as a fraction of the lower Nyquist rate
+constexpr double ZERO_CROSSINGS = 72.0; // Sinc lobes each side of the centre tap
+constexpr double KAISER_BETA = 6.0;     // ~60 dB stopband
+
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+}
+
+Resampler::Resampler(int inRate, int outRate)
+    : inRate(inRate), outRate(outRate), bufferStart(0), inputCount(0), outputCount(0) {
+    uint64_t g = std::gcd(static_cast<uint64_t>(inRate), static_cast<uint64_t>(outRate));
+    up = outRate / g;
+    down = inRate / g;
+    phases = static_cast<int>(std::min<uint64_t>(up, MAX_PHASES));
+
+    // Cutoff in cycles per input sample; when decimating it follows the
+    // output Nyquist rate and the filter widens to match
+    double fc = 0.5 * ROLLOFF * std::min(1.0, static_cast<double>(up) / down);
+    double halfWidth = ZERO_CROSSINGS / (2.0 * fc);
+    taps = (2 * static_cast<int>(std::ceil(halfWidth)) + 7) / 8 * 8;
+    const int half = taps / 2;
+
+    // One extra row so a rounded phase of 1.0 needs no special case
+    table.resize(static_cast<size_t>(phases + 1) * taps);
+    const double norm = besselI0(KAISER_BETA);
+    for (int p = 0; p <= phases; p++) {
+        double frac = static_cast<double>(p) / phases;
+        float* row = &table[static_cast<size_t>(p) * taps];
+        double sum = 0.0;
+        for (int k = 0; k < taps; k++) {
+            double x = (k - half + 1) - frac;   // Tap k reads input sample base + k - half + 1
+            double r = x / half;
+            double window = std::abs(r) < 1.0 ? besselI0(KAISER_BETA * std::sqrt(1.0 - r * r)) / norm : 0.0;
+            double arg = 2.0 * fc * x;
+            double sinc = arg == 0.0 ? 1.0 : std::sin(M_PI * arg) / (M_PI * arg);
+            row[k] = static_cast<float>(2.0 * fc * sinc * window);
+            sum += row[k];
+        }
+        // Unit DC gain for every phase, so no phase-dependent ripple
+        for (int k = 0; k < taps; k++) {
+            row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+
+    buffer.assign(half - 1, 0.0f);
+    bufferStart = -(half - 1);
+}
+
+void Resampler::produce(std::vector<float>& out, uint64_t available) {
+    const int half = taps / 2;
+    for (;;) {
+        uint64_t position = outputCount * down;
+        uint64_t base = position / up;
+        if (base + half >= available) {
+            break;
+        }
+        uint64_t offset = position % up;
+        size_t phase = up <= (uint64_t)MAX_PHASES ? offset : (offset * phases + up / 2) / up;
+
+        // Eight independent partial sums keep the loop vectorizable
+        const float* x = buffer.data() + (static_cast<int64_t>(base) - half + 1 - bufferStart);
+        const float* h = table.data() + phase * taps;
+        float acc[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        for (int k = 0; k < taps; k += 8) {
+            for (int j = 0; j < 8; j++) {
+                acc[j] += h[k + j] * x[k + j];
+            }
+        }
+        out.push_back(((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7])));
+        outputCount++;
+    }
+
+    // Drop input the next output no longer reaches
+    int64_t keep = static_cast<int64_t>(outputCount * down / up) - half + 1;
+    if (keep > bufferStart) {
+        size_t drop = std::min<size_t>(buffer.size(), keep - bufferStart);
+        buffer.erase(buffer.begin(), buffer.begin() + drop);
+        bufferStart += drop;
+    }
+}
+
+void Resampler::process(const float* in, size_t count, std::vector<float>& out) {
+    buffer.insert(buffer.end(), in, in + count);
+    inputCount += count;
+    out.reserve(out.size() + static_cast<size_t>(count * up / down) + 1);
+    produce(out, inputCount);
+}
+
+void Resampler::flush(std::vector<float>& out) {
+    // Zeros past the end let the last outputs see a full window; stop at
+    // the output length that matches the input duration
+    const int half = taps / 2;
+    uint64_t total = (inputCount * up + down - 1) / down;
+    buffer.insert(buffer.end(), half + 1, 0.0f);
+    std::vector<float> tail;
+    produce(tail, inputCount + half + 1);
+    size_t wanted = outputCount > total ? tail.size() - std::min<size_t>(tail.size(), outputCount - total) : tail.size();
+    out.insert(out.end(), tail.begin(), tail.begin() + wanted);
+
+    // Ready for a new stream
+    buffer.assign(half - 1, 0.0f);
+    bufferStart = -(half - 1);
+    inputCount = 0;
+    outputCount = 0;
+}
+
+std::vector<float> Resampler::process(const std::vector<float>& in) {
+    std::vector<float> out;
+    process(in.data(), in.size(), out);
+    flush(out);
+    return out;
+}
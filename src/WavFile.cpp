@@ -1,64 +1,246 @@
 #include "WavFile.h"
+#include "Console.h"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-WavFile::WavFile() {}
+WavFile::WavFile()
+    : outFormat(FORMAT_INT16), dither(false), verbose(true), outFile(nullptr), rawOutput(false), outSampleRate(0), outChannels(0), samplesWritten(0),
+      mappedData(nullptr), mappedSize(0), inFd(-1), ownsInFd(false), rawFormat(FORMAT_INT16), inFormat(FORMAT_INT16), inPending(0) {}
 
-WavFile::~WavFile() {}
+WavFile::~WavFile() {
+    if (outFile) {
+        endWrite();
+    }
+    endRead();
+    unmap();
+}
+
+namespace {
+
+int bytesPerSample(WavFile::SampleFormat format) {
+    switch (format) {
+        case WavFile::FORMAT_UINT8: return 1;
+        case WavFile::FORMAT_INT16: return 2;
+        case WavFile::FORMAT_INT24: return 3;
+        default: return 4;
+    }
+}
+
+// Stateless hash of the sample index, so dither generation vectorizes
+inline uint32_t ditherHash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
 
-void WavFile::prepareHeader(WavHeader& header, int numSamples, int sampleRate, int channels) {
+// Quantize a block to integers in [-(scale+1), scale]
+void quantize(const float* samples, size_t count, float scale, bool dither,
+              uint64_t index, int32_t* out) {
+    if (!dither) {
+        // Clamp and truncate, matching the original 16-bit writer bit for bit
+        for (size_t i = 0; i < count; i++) {
+            float s = std::max(-1.0f, std::min(1.0f, samples[i]));
+            out[i] = static_cast<int32_t>(s * scale);
+        }
+        return;
+    }
+    
+    // TPDF dither: difference of two uniform variables, +/-1 LSB peak
+    const float unit = 1.0f / 4294967296.0f;
+    const float lo = -scale - 1.0f;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t n = static_cast<uint32_t>(index + i) * 2;
+        float d = (static_cast<float>(ditherHash(n)) - static_cast<float>(ditherHash(n + 1))) * unit;
+        float s = std::max(-1.0f, std::min(1.0f, samples[i]));
+        float v = std::floor(s * scale + d + 0.5f);
+        out[i] = static_cast<int32_t>(std::max(lo, std::min(scale, v)));
+    }
+}
+
+}
+
+void WavFile::prepareHeader(WavHeader& header, uint64_t frames, int sampleRate, int channels) {
+    const int width = bytesPerSample(outFormat);
+    
+    // writeSamples() keeps the data within getMaxSamples(), so the sizes fit
+    const uint64_t dataSize = frames * channels * width;
+    
     // RIFF header
     std::memcpy(header.riff, "RIFF", 4);
-    header.fileSize = 36 + numSamples * channels * 2; // 2 bytes per sample (16-bit)
+    header.fileSize = static_cast<uint32_t>(36 + dataSize);
     std::memcpy(header.wave, "WAVE", 4);
     
     // Format chunk
     std::memcpy(header.fmt, "fmt ", 4);
     header.fmtSize = 16;
-    header.audioFormat = 1; // PCM
+    header.audioFormat = (outFormat == FORMAT_FLOAT32) ? 3 : 1; // IEEE float or PCM
     header.numChannels = channels;
     header.sampleRate = sampleRate;
-    header.bitsPerSample = 16;
-    header.byteRate = sampleRate * channels * 2;
-    header.blockAlign = channels * 2;
+    header.bitsPerSample = width * 8;
+    header.byteRate = sampleRate * channels * width;
+    header.blockAlign = channels * width;
     
     // Data chunk
     std::memcpy(header.data, "data", 4);
-    header.dataSize = numSamples * channels * 2;
+    header.dataSize = static_cast<uint32_t>(dataSize);
+}
+
+uint64_t WavFile::getMaxSamples() const {
+    return (0xFFFFFFFFULL - 36) / bytesPerSample(outFormat);
+}
+
+bool WavFile::setOutputFormat(SampleFormat format) {
+    if (format != FORMAT_INT16 && format != FORMAT_INT24 && format != FORMAT_FLOAT32) {
+        Console::error() << "Error: Unsupported output sample format" << std::endl;
+        return false;
+    }
+    outFormat = format;
+    return true;
+}
+
+void WavFile::encodeBlock(const float* samples, size_t count, uint8_t* out) {
+    // Caller guarantees count <= the block size used by writeSamples()
+    thread_local std::vector<int32_t> quantized;
+    
+    switch (outFormat) {
+        case FORMAT_FLOAT32:
+            for (size_t i = 0; i < count; i++) {
+                float s = std::max(-1.0f, std::min(1.0f, samples[i]));
+                std::memcpy(out + 4 * i, &s, 4);
+            }
+            break;
+        case FORMAT_INT24:
+            quantized.resize(count);
+            quantize(samples, count, 8388607.0f, dither, samplesWritten, quantized.data());
+            for (size_t i = 0; i < count; i++) {
+                uint32_t v = static_cast<uint32_t>(quantized[i]);
+                out[3 * i] = static_cast<uint8_t>(v);
+                out[3 * i + 1] = static_cast<uint8_t>(v >> 8);
+                out[3 * i + 2] = static_cast<uint8_t>(v >> 16);
+            }
+            break;
+        default:
+            quantized.resize(count);
+            quantize(samples, count, 32767.0f, dither, samplesWritten, quantized.data());
+            for (size_t i = 0; i < count; i++) {
+                int16_t v = static_cast<int16_t>(quantized[i]);
+                std::memcpy(out + 2 * i, &v, 2);
+            }
+            break;
+    }
 }
 
 bool WavFile::write(const std::string& filename, 
                     const std::vector<float>& samples,
                     int sampleRate,
                     int channels) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file for writing: " << filename << std::endl;
+    if (!beginWrite(filename, sampleRate, channels)) {
         return false;
     }
     
-    // Prepare header
-    WavHeader header;
-    prepareHeader(header, samples.size(), sampleRate, channels);
+    if (!writeSamples(samples.data(), samples.size())) {
+        endWrite();
+        return false;
+    }
     
-    // Write header
-    file.write(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    return endWrite();
+}
+
+bool WavFile::beginWrite(const std::string& filename, int sampleRate, int channels) {
+    if (outFile) {
+        endWrite();
+    }
     
-    // Convert float samples to 16-bit PCM and write
-    for (float sample : samples) {
-        // Clamp sample to [-1.0, 1.0]
-        float clampedSample = std::max(-1.0f, std::min(1.0f, sample));
-        
-        // Convert to 16-bit signed integer
-        int16_t pcmSample = static_cast<int16_t>(clampedSample * 32767.0f);
+    rawOutput = (filename == "-");
+    outFile = rawOutput ? stdout : std::fopen(filename.c_str(), "wb");
+    if (!outFile) {
+        Console::error() << "Error: Could not open file for writing: " << filename << std::endl;
+        return false;
+    }
+    
+    outName = rawOutput ? "stdout" : filename;
+    outSampleRate = sampleRate;
+    outChannels = channels;
+    samplesWritten = 0;
+    
+    // Placeholder header; sizes are patched once the sample count is known
+    if (!rawOutput) {
+        WavHeader header;
+        prepareHeader(header, 0, sampleRate, channels);
+        if (std::fwrite(&header, sizeof(WavHeader), 1, outFile) != 1) {
+            Console::error() << "Error: Could not write WAV header to " << outName << std::endl;
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool WavFile::writeSamples(const float* samples, size_t count) {
+    if (!outFile) {
+        return false;
+    }
+    
+    if (!rawOutput && samplesWritten + count > getMaxSamples()) {
+        Console::error() << "Error: " << outName << " would pass the 4 GB WAV size limit" << std::endl;
+        return false;
+    }
+    
+    // Convert in fixed blocks and hand each to the C library as one write
+    const size_t chunkSize = 65536;
+    const size_t width = bytesPerSample(outFormat);
+    pcmBuffer.resize(std::min(count, chunkSize) * width);
+    
+    for (size_t done = 0; done < count; ) {
+        size_t n = std::min(chunkSize, count - done);
+        encodeBlock(samples + done, n, pcmBuffer.data());
         
-        file.write(reinterpret_cast<char*>(&pcmSample), sizeof(int16_t));
+        if (std::fwrite(pcmBuffer.data(), width, n, outFile) != n) {
+            Console::error() << "Error: Write failed on " << outName << std::endl;
+            return false;
+        }
+        done += n;
+        samplesWritten += n;
     }
     
-    file.close();
-    std::cout << "Wrote " << samples.size() << " samples to " << filename << std::endl;
+    return true;
+}
+
+bool WavFile::endWrite() {
+    if (!outFile) {
+        return false;
+    }
+    
+    bool ok = true;
+    if (rawOutput) {
+        ok = std::fflush(outFile) == 0;
+    } else {
+        WavHeader header;
+        prepareHeader(header, samplesWritten / outChannels, outSampleRate, outChannels);
+        ok = std::fseek(outFile, 0, SEEK_SET) == 0 &&
+             std::fwrite(&header, sizeof(WavHeader), 1, outFile) == 1;
+        ok = (std::fclose(outFile) == 0) && ok;
+    }
+    outFile = nullptr;
+    
+    if (!ok) {
+        Console::error() << "Error: Could not finish writing " << outName << std::endl;
+        return false;
+    }
+    
+    if (verbose) {
+        Console::info() << "Wrote " << samplesWritten << " samples to " << outName << std::endl;
+    }
     return true;
 }
 
@@ -66,64 +248,341 @@ bool WavFile::read(const std::string& filename,
                    std::vector<float>& samples,
                    int& sampleRate,
                    int& channels) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file for reading: " << filename << std::endl;
+    PcmView view;
+    if (!map(filename, view)) {
         return false;
     }
     
-    // Read header
-    WavHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(WavHeader));
+    sampleRate = view.sampleRate;
+    channels = view.channels;
     
-    // Verify RIFF and WAVE
-    if (std::memcmp(header.riff, "RIFF", 4) != 0 || 
-        std::memcmp(header.wave, "WAVE", 4) != 0) {
-        std::cerr << "Error: Invalid WAV file format" << std::endl;
+    size_t numSamples = view.frames * view.channels;
+    samples.resize(numSamples);
+    convertToFloat(view, 0, numSamples, samples.data());
+    unmap();
+    
+    if (verbose) {
+        Console::info() << "Read " << samples.size() << " samples from " << filename << std::endl;
+        Console::info() << "Sample rate: " << sampleRate << " Hz, Channels: " << channels << std::endl;
+    }
+    
+    return true;
+}
+
+namespace {
+
+uint16_t readLE16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLE32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Sample encoding named by a fmt chunk's format tag and sample width
+bool sampleFormat(uint16_t formatTag, uint16_t bitsPerSample, WavFile::SampleFormat& format) {
+    if (formatTag == 1 && bitsPerSample == 8) {
+        format = WavFile::FORMAT_UINT8;
+    } else if (formatTag == 1 && bitsPerSample == 16) {
+        format = WavFile::FORMAT_INT16;
+    } else if (formatTag == 1 && bitsPerSample == 24) {
+        format = WavFile::FORMAT_INT24;
+    } else if (formatTag == 1 && bitsPerSample == 32) {
+        format = WavFile::FORMAT_INT32;
+    } else if (formatTag == 3 && bitsPerSample == 32) {
+        format = WavFile::FORMAT_FLOAT32;
+    } else {
+        Console::error() << "Error: Unsupported WAV format " << formatTag << " with "
+                  << bitsPerSample << " bits per sample" << std::endl;
         return false;
     }
+    return true;
+}
+
+}
+
+bool WavFile::map(const std::string& filename, PcmView& view) {
+    unmap();
     
-    // Check for PCM format
-    if (header.audioFormat != 1) {
-        std::cerr << "Error: Only PCM format is supported" << std::endl;
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Console::error() << "Error: Could not open file for reading: " << filename << std::endl;
         return false;
     }
     
-    sampleRate = header.sampleRate;
-    channels = header.numChannels;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < 12) {
+        ::close(fd);
+        Console::error() << "Error: Invalid WAV file format" << std::endl;
+        return false;
+    }
+    
+    void* base = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        Console::error() << "Error: Could not map file: " << filename << std::endl;
+        return false;
+    }
+    ::madvise(base, st.st_size, MADV_SEQUENTIAL);
+    mappedData = base;
+    mappedSize = st.st_size;
     
-    // Calculate number of samples
-    int numSamples = header.dataSize / (channels * (header.bitsPerSample / 8));
-    samples.clear();
-    samples.reserve(numSamples);
+    const uint8_t* file = static_cast<const uint8_t*>(base);
+    const size_t fileSize = mappedSize;
+    
+    // Verify RIFF and WAVE
+    if (std::memcmp(file, "RIFF", 4) != 0 || std::memcmp(file + 8, "WAVE", 4) != 0) {
+        Console::error() << "Error: Invalid WAV file format" << std::endl;
+        unmap();
+        return false;
+    }
     
-    // Read samples based on bit depth
-    if (header.bitsPerSample == 16) {
-        for (int i = 0; i < numSamples; i++) {
-            int16_t pcmSample;
-            file.read(reinterpret_cast<char*>(&pcmSample), sizeof(int16_t));
+    // Walk the chunk list; "fmt " must precede "data"
+    bool haveFormat = false;
+    uint16_t formatTag = 0;
+    uint16_t bitsPerSample = 0;
+    uint16_t blockAlign = 0;
+    size_t pos = 12;
+    while (pos + 8 <= fileSize) {
+        const uint8_t* chunk = file + pos;
+        size_t chunkSize = readLE32(chunk + 4);
+        size_t bodyStart = pos + 8;
+        
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || bodyStart + chunkSize > fileSize) {
+                Console::error() << "Error: Truncated fmt chunk" << std::endl;
+                unmap();
+                return false;
+            }
+            const uint8_t* fmt = file + bodyStart;
+            formatTag = readLE16(fmt);
+            view.channels = readLE16(fmt + 2);
+            view.sampleRate = readLE32(fmt + 4);
+            blockAlign = readLE16(fmt + 12);
+            bitsPerSample = readLE16(fmt + 14);
             
-            // Convert to float [-1.0, 1.0]
-            float sample = static_cast<float>(pcmSample) / 32768.0f;
-            samples.push_back(sample);
-        }
-    } else if (header.bitsPerSample == 8) {
-        for (int i = 0; i < numSamples; i++) {
-            uint8_t pcmSample;
-            file.read(reinterpret_cast<char*>(&pcmSample), sizeof(uint8_t));
+            // WAVE_FORMAT_EXTENSIBLE: the real format is the first two bytes of the sub-format GUID
+            if (formatTag == 0xFFFE && chunkSize >= 40) {
+                formatTag = readLE16(fmt + 24);
+            }
+            haveFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                Console::error() << "Error: WAV data chunk precedes fmt chunk" << std::endl;
+                unmap();
+                return false;
+            }
+            
+            // Streamed files may carry a placeholder size; use what is present
+            size_t available = fileSize - bodyStart;
+            if (chunkSize == 0 || chunkSize > available) {
+                chunkSize = available;
+            }
+            
+            if (view.channels < 1) {
+                Console::error() << "Error: Invalid channel count" << std::endl;
+                unmap();
+                return false;
+            }
+            
+            if (!sampleFormat(formatTag, bitsPerSample, view.format)) {
+                unmap();
+                return false;
+            }
             
-            // Convert to float [-1.0, 1.0] (8-bit is unsigned, centered at 128)
-            float sample = (static_cast<float>(pcmSample) - 128.0f) / 128.0f;
-            samples.push_back(sample);
+            view.bytesPerSample = bitsPerSample / 8;
+            size_t frameBytes = std::max<size_t>(blockAlign, view.bytesPerSample * view.channels);
+            view.data = file + bodyStart;
+            view.frames = chunkSize / frameBytes;
+            return true;
+        }
+        
+        // Chunks are padded to an even size
+        pos = bodyStart + chunkSize + (chunkSize & 1);
+    }
+    
+    Console::error() << "Error: WAV file has no data chunk" << std::endl;
+    unmap();
+    return false;
+}
+
+void WavFile::unmap() {
+    if (mappedData) {
+        ::munmap(mappedData, mappedSize);
+    }
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
+void WavFile::convertToFloat(const PcmView& view, size_t first, size_t count, float* out) {
+    // Straight-line loops over the mapped bytes so the compiler vectorizes them
+    const uint8_t* in = view.data + first * view.bytesPerSample;
+    switch (view.format) {
+        case FORMAT_UINT8:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = (static_cast<float>(in[i]) - 128.0f) * (1.0f / 128.0f);
+            }
+            break;
+        case FORMAT_INT16:
+            for (size_t i = 0; i < count; i++) {
+                int16_t v;
+                std::memcpy(&v, in + 2 * i, 2);
+                out[i] = static_cast<float>(v) * (1.0f / 32768.0f);
+            }
+            break;
+        case FORMAT_INT24:
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t* p = in + 3 * i;
+                int32_t v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+                out[i] = static_cast<float>(v) * (1.0f / 8388608.0f);
+            }
+            break;
+        case FORMAT_INT32:
+            for (size_t i = 0; i < count; i++) {
+                int32_t v;
+                std::memcpy(&v, in + 4 * i, 4);
+                out[i] = static_cast<float>(v) * (1.0f / 2147483648.0f);
+            }
+            break;
+        case FORMAT_FLOAT32:
+            std::memcpy(out, in, count * sizeof(float));
+            break;
+    }
+}
+
+bool WavFile::readExact(uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = ::read(inFd, data, length);
+        if (n <= 0) {
+            return false;
         }
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+bool WavFile::beginRead(const std::string& filename, int& sampleRate, int& channels) {
+    endRead();
+    
+    if (filename == "-") {
+        inFd = STDIN_FILENO;
+        ownsInFd = false;
     } else {
-        std::cerr << "Error: Unsupported bit depth: " << header.bitsPerSample << std::endl;
+        inFd = ::open(filename.c_str(), O_RDONLY);
+        ownsInFd = true;
+        if (inFd < 0) {
+            Console::error() << "Error: Could not open file for reading: " << filename << std::endl;
+            return false;
+        }
+    }
+    
+    inBuffer.resize(8192);
+    inPending = 0;
+    inFormat = rawFormat;
+    
+    uint8_t riff[12];
+    if (!readExact(riff, 4)) {
+        Console::error() << "Error: Empty input stream: " << filename << std::endl;
         return false;
     }
     
-    file.close();
-    std::cout << "Read " << samples.size() << " samples from " << filename << std::endl;
-    std::cout << "Sample rate: " << sampleRate << " Hz, Channels: " << channels << std::endl;
+    if (std::memcmp(riff, "RIFF", 4) != 0) {
+        // Raw PCM; the bytes already read are the first samples
+        std::memcpy(inBuffer.data(), riff, 4);
+        inPending = 4;
+        return true;
+    }
+    
+    if (!readExact(riff + 4, 8) || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        Console::error() << "Error: Invalid WAV file format" << std::endl;
+        return false;
+    }
+    
+    // Walk chunks up to "data"; the data size is ignored for live streams
+    bool haveFormat = false;
+    while (true) {
+        uint8_t chunk[8];
+        if (!readExact(chunk, 8)) {
+            Console::error() << "Error: WAV stream ended before data chunk" << std::endl;
+            return false;
+        }
+        uint32_t chunkSize = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+        
+        if (std::memcmp(chunk, "data", 4) == 0) {
+            break;
+        }
+        
+        std::vector<uint8_t> body(chunkSize + (chunkSize & 1));
+        if (!readExact(body.data(), body.size())) {
+            Console::error() << "Error: Truncated WAV chunk" << std::endl;
+            return false;
+        }
+        
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+            uint16_t formatTag = readLE16(body.data());
+            uint16_t bitsPerSample = readLE16(body.data() + 14);
+            if (formatTag == 0xFFFE && chunkSize >= 40) {
+                formatTag = readLE16(body.data() + 24);
+            }
+            if (!sampleFormat(formatTag, bitsPerSample, inFormat)) {
+                return false;
+            }
+            channels = body[2] | (body[3] << 8);
+            sampleRate = body[4] | (body[5] << 8) | (body[6] << 16) | ((uint32_t)body[7] << 24);
+            haveFormat = true;
+        }
+    }
+    
+    if (!haveFormat) {
+        Console::error() << "Error: WAV stream has no fmt chunk" << std::endl;
+        return false;
+    }
     
     return true;
 }
+
+long WavFile::readSamples(float* samples, size_t maxSamples) {
+    if (inFd < 0) {
+        return -1;
+    }
+    
+    // A single read() returns whatever the pipe holds, so a live capture is
+    // processed as it arrives instead of waiting for a full buffer
+    const size_t width = bytesPerSample(inFormat);
+    size_t capacity = std::min(inBuffer.size(), maxSamples * width);
+    while (inPending < width) {
+        ssize_t n = ::read(inFd, inBuffer.data() + inPending, capacity - inPending);
+        if (n < 0) {
+            Console::error() << "Error: Read failed on input stream" << std::endl;
+            return -1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        inPending += n;
+    }
+    
+    size_t count = inPending / width;
+    PcmView view;
+    view.data = inBuffer.data();
+    view.bytesPerSample = static_cast<int>(width);
+    view.format = inFormat;
+    convertToFloat(view, 0, count, samples);
+    
+    // Keep a trailing partial sample for the next call
+    size_t used = count * width;
+    std::memmove(inBuffer.data(), inBuffer.data() + used, inPending - used);
+    inPending -= used;
+    
+    return count;
+}
+
+void WavFile::endRead() {
+    if (inFd >= 0 && ownsInFd) {
+        ::close(inFd);
+    }
+    inFd = -1;
+    ownsInFd = false;
+    inPending = 0;
+}
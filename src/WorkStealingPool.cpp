@@ -0,0 +1,79 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct JobQueue {
+    std::mutex mutex;
+    std::deque<size_t> jobs;
+};
+
+}
+
+WorkStealingPool::WorkStealingPool(int threads) : numThreads(threads) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t, int)>& job) {
+    int workers = static_cast<int>(std::min<size_t>(numThreads, count));
+    if (workers == 0) {
+        return;
+    }
+    
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    for (int w = 0; w < workers; w++) {
+        queues.emplace_back(new JobQueue);
+    }
+    for (size_t i = 0; i < count; i++) {
+        queues[i % workers]->jobs.push_back(i);
+    }
+    
+    auto take = [&](int self, size_t& index) {
+        // Own work first, in order
+        {
+            JobQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                index = own.jobs.front();
+                own.jobs.pop_front();
+                return true;
+            }
+        }
+        
+        // Then steal the last job of the next non-empty deque. Jobs are
+        // never added after the start, so one empty sweep means done
+        for (int k = 1; k < workers; k++) {
+            JobQueue& victim = *queues[(self + k) % workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                index = victim.jobs.back();
+                victim.jobs.pop_back();
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    auto work = [&](int self) {
+        size_t index;
+        while (take(self, index)) {
+            job(index, self);
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    for (int w = 1; w < workers; w++) {
+        threads.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
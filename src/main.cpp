@@ -1,8 +1,16 @@
 #include <iostream>
 #include <string>
+#include <vector>
+#include <map>
 #include <cstring>
+#include <cstdlib>
+#include <fstream>
 #include "AudioEncoder.h"
 #include "AudioDecoder.h"
+#include "BatchProcessor.h"
+#include "ChannelSweep.h"
+#include "Console.h"
+#include "Metrics.h"
 
 void printUsage(const char* programName) {
     std::cout << "\n╔═══════════════════════════════════════════════════════════════════╗" << std::endl;
@@ -11,8 +19,51 @@ void printUsage(const char* programName) {
     std::cout << "\nConvert any file to audible sound and back!" << std::endl;
     std::cout << "Supports: .txt, .jpg, .png, and any other file format" << std::endl;
     std::cout << "\nUSAGE:" << std::endl;
-    std::cout << "  " << programName << " encode <input_file> <output.wav>" << std::endl;
-    std::cout << "  " << programName << " decode <input.wav> <output_directory>" << std::endl;
+    std::cout << "  " << programName << " encode <input_file> <output.wav> [options]" << std::endl;
+    std::cout << "  " << programName << " decode <input.wav> <output_directory> [options]" << std::endl;
+    std::cout << "  " << programName << " encode-batch <input_dir|manifest> <output_directory> [options]" << std::endl;
+    std::cout << "  " << programName << " decode-batch <input_dir|manifest> <output_directory> [options]" << std::endl;
+    std::cout << "  " << programName << " simulate <input_file> [options]" << std::endl;
+    std::cout << "\nENCODE OPTIONS:" << std::endl;
+    std::cout << "  --sync=chirp|tone      Preamble (default: chirp, tone for pre-chirp decoders)" << std::endl;
+    std::cout << "  --stream               Constant-memory encoder (chunked read, audio written as produced)" << std::endl;
+    std::cout << "  --modulation=fsk|ofdm  Data modulation (default: fsk; ofdm is ~70x faster, needs a clean channel)" << std::endl;
+    std::cout << "  --profile=NAME         FSK profile: standard, robust (slow, noisy rooms), fast," << std::endl;
+    std::cout << "                         ultrasonic (15-21 kHz data) (default: standard)" << std::endl;
+    std::cout << "  --compress=auto|on|off Compress data before FEC (default: auto, skips JPEG/PNG/ZIP...)" << std::endl;
+    std::cout << "  --interleave=N         RS blocks interleaved per group, 1-255 (default: 8, 1 = off)" << std::endl;
+    std::cout << "  --frames               Send the file as CRC-checked frames; a damaged block loses only its frame" << std::endl;
+    std::cout << "  --ranges=A-B[,C-D...]  Send only the frames covering these byte ranges (implies --frames)" << std::endl;
+    std::cout << "  --fountain[=N|endless] Broadcast rateless fountain-coded frames; listeners may join late" << std::endl;
+    std::cout << "                         (default: 1.5x the file's frames, endless needs '-' output)" << std::endl;
+    std::cout << "  --format=pcm16|pcm24|float  Output sample format (default: pcm16)" << std::endl;
+    std::cout << "  --dither               TPDF dither when quantizing to integer PCM" << std::endl;
+    std::cout << "  Use '-' as the output to write raw mono PCM to stdout" << std::endl;
+    std::cout << "\nDECODE OPTIONS:" << std::endl;
+    std::cout << "  --demod=fft|goertzel   Tone detector (default: fft, goertzel is the reference)" << std::endl;
+    std::cout << "  --threads=N            Demodulation threads (default: 0 = one per core)" << std::endl;
+    std::cout << "  --stream               Decode live PCM from a FIFO or stdin ('-') as it arrives" << std::endl;
+    std::cout << "  --rate=HZ --channels=N Format of raw (headerless) streamed PCM (default: 44100, 1)" << std::endl;
+    std::cout << "  --format=pcm16|pcm24|float  Sample format of raw streamed PCM (default: pcm16)" << std::endl;
+    std::cout << "\nENCODE AND DECODE OPTIONS:" << std::endl;
+    std::cout << "  --quiet                Suppress progress output (errors are still shown)" << std::endl;
+    std::cout << "  --metrics=json|trace   Per-stage timings and counters as JSON or Chrome trace events" << std::endl;
+    std::cout << "  --metrics-file=PATH    Write the metrics to PATH (default: stdout)" << std::endl;
+    std::cout << "\nBATCH OPTIONS (plus the encode or decode options above):" << std::endl;
+    std::cout << "  --jobs=N               Files processed in parallel (default: 0 = one per core)" << std::endl;
+    std::cout << "  --summary=PATH         Per-file JSON Lines summary (default: stdout)" << std::endl;
+    std::cout << "  A manifest lists one input path per line; '#' starts a comment line" << std::endl;
+    std::cout << "\nSIMULATE OPTIONS (plus the encode and decode options above):" << std::endl;
+    std::cout << "  --trials=N             Seeded trials per channel condition (default: 3)" << std::endl;
+    std::cout << "  --seed=N               Seed of the first trial (default: 1)" << std::endl;
+    std::cout << "  --snr=DB[,DB...]       AWGN levels to sweep (default: no noise)" << std::endl;
+    std::cout << "  --gain=DB --fade=DB    Level change and peak-to-peak slow fading" << std::endl;
+    std::cout << "  --ppm=N                Receiver clock offset in parts per million" << std::endl;
+    std::cout << "  --band=LO-HI           Speaker/microphone pass band in Hz" << std::endl;
+    std::cout << "  --reverb=MS            Room reverberation time (RT60)" << std::endl;
+    std::cout << "  --dropouts=N --dropout-ms=MS  Burst dropouts per second and their length" << std::endl;
+    std::cout << "  --summary=PATH         JSON Lines results (default: stdout)" << std::endl;
+    std::cout << "  Without channel options a standard sweep of conditions is run" << std::endl;
     std::cout << "\nEXAMPLES:" << std::endl;
     std::cout << "  Encode a text file:" << std::endl;
     std::cout << "    " << programName << " encode document.txt output.wav" << std::endl;
@@ -42,6 +93,206 @@ void printBanner() {
     std::cout << "\n";
 }
 
+// Split arguments into positionals and --name[=value] options
+void parseArguments(int argc, char* argv[],
+                    std::vector<std::string>& positional,
+                    std::map<std::string, std::string>& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) {
+                options[arg.substr(2)] = "";
+            } else {
+                options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+            }
+        } else {
+            positional.push_back(arg);
+        }
+    }
+}
+
+// Parse a --format value; prints the error and returns false on an unknown format
+bool parseSampleFormat(const std::string& name, WavFile::SampleFormat& format) {
+    if (name == "pcm16") {
+        format = WavFile::FORMAT_INT16;
+    } else if (name == "pcm24") {
+        format = WavFile::FORMAT_INT24;
+    } else if (name == "float") {
+        format = WavFile::FORMAT_FLOAT32;
+    } else {
+        std::cerr << "Error: Unknown sample format '" << name << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Apply the encode options; prints the error and returns false on a bad option
+bool configureEncoder(AudioEncoder& encoder, std::map<std::string, std::string>& options) {
+    if (options.count("sync")) {
+        const std::string& sync = options["sync"];
+        if (sync == "chirp") {
+            encoder.setSyncMode(AudioModulator::SYNC_CHIRP);
+        } else if (sync == "tone") {
+            encoder.setSyncMode(AudioModulator::SYNC_TONE);
+        } else {
+            std::cerr << "Error: Unknown sync mode '" << sync << "'" << std::endl;
+            return false;
+        }
+    }
+    if (options.count("interleave")) {
+        int depth = std::atoi(options["interleave"].c_str());
+        if (depth < 1 || depth > Interleaver::MAX_DEPTH) {
+            std::cerr << "Error: Interleave depth must be 1-" << Interleaver::MAX_DEPTH << std::endl;
+            return false;
+        }
+        if (depth > 1 && options.count("sync") && options["sync"] == "tone") {
+            std::cerr << "Error: Interleaving needs the chirp stream header (--sync=chirp)" << std::endl;
+            return false;
+        }
+        encoder.setInterleaveDepth(depth);
+    }
+    if (options.count("modulation")) {
+        const std::string& modulation = options["modulation"];
+        if (modulation == "fsk") {
+            encoder.setModulation(AudioModulator::MOD_FSK);
+        } else if (modulation == "ofdm") {
+            if (options.count("sync") && options["sync"] == "tone") {
+                std::cerr << "Error: OFDM needs the chirp stream header (--sync=chirp)" << std::endl;
+                return false;
+            }
+            encoder.setModulation(AudioModulator::MOD_OFDM);
+        } else {
+            std::cerr << "Error: Unknown modulation '" << modulation << "'" << std::endl;
+            return false;
+        }
+    }
+    if (options.count("profile")) {
+        AudioModulator::ModemProfile profile;
+        if (!AudioModulator::findProfile(options["profile"], profile)) {
+            std::cerr << "Error: Unknown profile '" << options["profile"] << "'" << std::endl;
+            return false;
+        }
+        if (profile != AudioModulator::PROFILE_STANDARD) {
+            if (options.count("sync") && options["sync"] == "tone") {
+                std::cerr << "Error: Modem profiles need the chirp stream header (--sync=chirp)" << std::endl;
+                return false;
+            }
+            if (options.count("modulation") && options["modulation"] == "ofdm") {
+                std::cerr << "Error: Modem profiles apply to FSK only" << std::endl;
+                return false;
+            }
+        }
+        encoder.setProfile(profile);
+    }
+    if (options.count("format")) {
+        WavFile::SampleFormat format;
+        if (!parseSampleFormat(options["format"], format)) {
+            return false;
+        }
+        encoder.setOutputFormat(format);
+    }
+    encoder.setDither(options.count("dither") > 0);
+    if (options.count("ranges")) {
+        std::vector<Framer::Range> ranges;
+        if (!Framer::parseRanges(options["ranges"], ranges)) {
+            std::cerr << "Error: Invalid ranges '" << options["ranges"] << "' (expected A-B[,C-D...])" << std::endl;
+            return false;
+        }
+        encoder.setFramed(true, ranges);
+    } else if (options.count("frames")) {
+        encoder.setFramed(true);
+    }
+    if (options.count("fountain")) {
+        const std::string& fountain = options["fountain"];
+        if (options.count("ranges") || options.count("frames")) {
+            std::cerr << "Error: --fountain replaces --frames and --ranges" << std::endl;
+            return false;
+        }
+        if (options.count("sync") && options["sync"] == "tone") {
+            std::cerr << "Error: Fountain broadcasts need the chirp stream header (--sync=chirp)" << std::endl;
+            return false;
+        }
+        if (fountain.empty()) {
+            encoder.setFountain(true);
+        } else if (fountain == "endless") {
+            encoder.setFountain(true, AudioEncoder::FOUNTAIN_ENDLESS);
+        } else if (std::atoi(fountain.c_str()) > 0) {
+            encoder.setFountain(true, static_cast<uint32_t>(std::atoi(fountain.c_str())));
+        } else {
+            std::cerr << "Error: Invalid fountain frame count '" << fountain << "'" << std::endl;
+            return false;
+        }
+    }
+    if (options.count("compress")) {
+        const std::string& compress = options["compress"];
+        if (compress == "auto") {
+            encoder.setCompressMode(AudioEncoder::COMPRESS_AUTO);
+        } else if (compress == "on") {
+            encoder.setCompressMode(AudioEncoder::COMPRESS_ON);
+        } else if (compress == "off") {
+            encoder.setCompressMode(AudioEncoder::COMPRESS_OFF);
+        } else {
+            std::cerr << "Error: Unknown compression mode '" << compress << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Apply the decode options to an AudioDecoder or a ChannelSweep's receiver;
+// prints the error and returns false on a bad option
+template <typename Decoder>
+bool configureDecoder(Decoder& decoder, std::map<std::string, std::string>& options) {
+    if (options.count("demod")) {
+        const std::string& demod = options["demod"];
+        if (demod == "fft") {
+            decoder.setDemodMode(AudioModulator::DEMOD_FFT);
+        } else if (demod == "goertzel") {
+            decoder.setDemodMode(AudioModulator::DEMOD_GOERTZEL);
+        } else {
+            std::cerr << "Error: Unknown demodulator '" << demod << "'" << std::endl;
+            return false;
+        }
+    }
+    
+    if (options.count("threads")) {
+        decoder.setNumThreads(std::atoi(options["threads"].c_str()));
+    }
+    return true;
+}
+
+// Validate --metrics before any work starts; prints the error and returns false
+bool checkMetricsOption(std::map<std::string, std::string>& options) {
+    if (options.count("metrics") && options["metrics"] != "json" && options["metrics"] != "trace") {
+        std::cerr << "Error: Unknown metrics format '" << options["metrics"] << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Write what was recorded to --metrics-file or stdout, if --metrics was given
+bool writeMetrics(const Metrics& metrics, std::map<std::string, std::string>& options) {
+    if (!options.count("metrics")) {
+        return true;
+    }
+    std::ofstream file;
+    if (options.count("metrics-file")) {
+        file.open(options["metrics-file"]);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not create metrics file: " << options["metrics-file"] << std::endl;
+            return false;
+        }
+    }
+    std::ostream& out = file.is_open() ? file : std::cout;
+    if (options["metrics"] == "trace") {
+        metrics.writeTrace(out);
+    } else {
+        metrics.writeJson(out);
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     // Check arguments
     if (argc < 2) {
@@ -49,31 +300,63 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    std::string command = argv[1];
+    std::vector<std::string> args;
+    std::map<std::string, std::string> options;
+    parseArguments(argc, argv, args, options);
+    
+    std::string command = args.empty() ? "" : args[0];
     
     // Help command
-    if (command == "help" || command == "--help" || command == "-h") {
+    if (command == "help" || command == "-h" || options.count("help")) {
         printUsage(argv[0]);
         return 0;
     }
     
     // Encode command
     if (command == "encode") {
-        if (argc != 4) {
+        if (args.size() != 3) {
             std::cerr << "Error: Invalid number of arguments for encode command" << std::endl;
             printUsage(argv[0]);
             return 1;
         }
         
-        printBanner();
+        std::string inputFile = args[1];
+        std::string outputFile = args[2];
+        
+        // Raw PCM owns stdout; route all console output to stderr
+        if (outputFile == "-") {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
         
-        std::string inputFile = argv[2];
-        std::string outputFile = argv[3];
+        bool quiet = options.count("quiet") > 0;
+        if (!checkMetricsOption(options)) {
+            return 1;
+        }
+        if (quiet) {
+            Console::setProgress(false);
+        } else {
+            printBanner();
+        }
         
         AudioEncoder encoder;
-        if (encoder.encodeFile(inputFile, outputFile)) {
-            std::cout << "\n✓ Success! File encoded to audio." << std::endl;
-            std::cout << "You can now play the audio file or record it with your phone." << std::endl;
+        if (!configureEncoder(encoder, options)) {
+            return 1;
+        }
+        Metrics metrics;
+        if (options.count("metrics")) {
+            Metrics::attach(&metrics);
+        }
+        bool encoded = options.count("stream") ? encoder.encodeFileStreaming(inputFile, outputFile)
+                                               : encoder.encodeFile(inputFile, outputFile);
+        Metrics::attach(nullptr);
+        if (!writeMetrics(metrics, options)) {
+            return 1;
+        }
+        if (encoded) {
+            if (!quiet) {
+                std::cout << "\n✓ Success! File encoded to audio." << std::endl;
+                std::cout << "You can now play the audio file or record it with your phone." << std::endl;
+            }
             return 0;
         } else {
             std::cerr << "\n✗ Encoding failed!" << std::endl;
@@ -83,20 +366,63 @@ int main(int argc, char* argv[]) {
     
     // Decode command
     else if (command == "decode") {
-        if (argc != 4) {
+        if (args.size() != 3) {
             std::cerr << "Error: Invalid number of arguments for decode command" << std::endl;
             printUsage(argv[0]);
             return 1;
         }
         
-        printBanner();
+        bool quiet = options.count("quiet") > 0;
+        if (!checkMetricsOption(options)) {
+            return 1;
+        }
+        if (quiet) {
+            Console::setProgress(false);
+        } else {
+            printBanner();
+        }
         
-        std::string inputFile = argv[2];
-        std::string outputDir = argv[3];
+        std::string inputFile = args[1];
+        std::string outputDir = args[2];
         
         AudioDecoder decoder;
-        if (decoder.decodeFile(inputFile, outputDir)) {
-            std::cout << "\n✓ Success! Audio decoded back to original file." << std::endl;
+        if (!configureDecoder(decoder, options)) {
+            return 1;
+        }
+        Metrics metrics;
+        if (options.count("metrics")) {
+            Metrics::attach(&metrics);
+        }
+        bool decoded;
+        if (options.count("stream") || inputFile == "-") {
+            int rate = options.count("rate") ? std::atoi(options["rate"].c_str()) : 44100;
+            int channels = options.count("channels") ? std::atoi(options["channels"].c_str()) : 1;
+            if (options.count("format")) {
+                WavFile::SampleFormat format;
+                if (!parseSampleFormat(options["format"], format)) {
+                    return 1;
+                }
+                decoder.setRawFormat(format);
+            }
+            decoded = decoder.decodeStream(inputFile, outputDir, rate, channels);
+        } else {
+            decoded = decoder.decodeFile(inputFile, outputDir);
+        }
+        Metrics::attach(nullptr);
+        if (!writeMetrics(metrics, options)) {
+            return 1;
+        }
+        
+        if (decoded && !decoder.getLastResult().missing.empty()) {
+            std::cerr << "\n✗ Decoded file is incomplete." << std::endl;
+            std::cerr << "Resend the missing bytes with: encode <file> <output.wav> --ranges="
+                      << Framer::formatRanges(decoder.getLastResult().missing) << std::endl;
+            std::cerr << "and decode the resend into the same directory to patch the file." << std::endl;
+            return 1;
+        } else if (decoded) {
+            if (!quiet) {
+                std::cout << "\n✓ Success! Audio decoded back to original file." << std::endl;
+            }
             return 0;
         } else {
             std::cerr << "\n✗ Decoding failed!" << std::endl;
@@ -105,6 +431,155 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // Batch commands
+    else if (command == "encode-batch" || command == "decode-batch") {
+        if (args.size() != 3) {
+            std::cerr << "Error: Invalid number of arguments for " << command << " command" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        
+        bool encoding = command == "encode-batch";
+        std::vector<std::string> inputs;
+        if (!BatchProcessor::collectInputs(args[1], !encoding, inputs)) {
+            return 1;
+        }
+        
+        // The summary owns stdout unless it goes to a file
+        std::ofstream summaryFile;
+        if (options.count("summary") && options["summary"] != "-") {
+            summaryFile.open(options["summary"]);
+            if (!summaryFile.is_open()) {
+                std::cerr << "Error: Could not create summary file: " << options["summary"] << std::endl;
+                return 1;
+            }
+        }
+        std::ostream summaryOut(summaryFile.is_open() ? summaryFile.rdbuf() : std::cout.rdbuf());
+        if (!summaryFile.is_open()) {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
+
+        int jobs = options.count("jobs") ? std::atoi(options["jobs"].c_str()) : 0;
+        BatchProcessor batch(jobs);
+        std::cerr << (encoding ? "Encoding " : "Decoding ") << inputs.size() << " files on "
+                  << batch.getNumThreads() << " threads..." << std::endl;
+        
+        bool ok;
+        if (encoding) {
+            bool streaming = options.count("stream") > 0;
+            ok = batch.encode(inputs, args[2],
+                              [&](AudioEncoder& encoder) { return configureEncoder(encoder, options); },
+                              streaming, summaryOut);
+        } else {
+            ok = batch.decode(inputs, args[2],
+                              [&](AudioDecoder& decoder) { return configureDecoder(decoder, options); },
+                              summaryOut);
+        }
+        summaryOut.flush();
+        
+        const BatchProcessor::Totals& totals = batch.getTotals();
+        std::cerr << "Batch finished: " << totals.succeeded << "/" << totals.jobs << " succeeded, "
+                  << totals.failed << " failed in " << totals.seconds << " s" << std::endl;
+        return ok ? 0 : 1;
+    }
+    
+    // Channel simulation sweep
+    else if (command == "simulate") {
+        if (args.size() != 2) {
+            std::cerr << "Error: Invalid number of arguments for simulate command" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        
+        AudioEncoder encoder;
+        if (!configureEncoder(encoder, options)) {
+            return 1;
+        }
+        if (options.count("fountain")) {
+            std::cerr << "Error: simulate sends one transmission; --fountain is not supported" << std::endl;
+            return 1;
+        }
+        ChannelSweep sweep;
+        if (!configureDecoder(sweep, options)) {
+            return 1;
+        }
+        
+        // A condition from the channel options, swept over --snr
+        std::vector<ChannelSimulator::Conditions> conditions;
+        const char* channelOptions[] = {"snr", "gain", "fade", "ppm", "band", "reverb", "dropouts", "dropout-ms"};
+        bool custom = false;
+        for (const char* name : channelOptions) {
+            custom = custom || options.count(name) > 0;
+        }
+        if (custom) {
+            ChannelSimulator::Conditions base;
+            base.name = "custom";
+            base.gainDb = std::atof(options["gain"].c_str());
+            base.fadeDb = std::atof(options["fade"].c_str());
+            base.ppm = std::atof(options["ppm"].c_str());
+            base.reverbMs = std::atof(options["reverb"].c_str());
+            base.dropoutRate = std::atof(options["dropouts"].c_str());
+            base.dropoutMs = options.count("dropout-ms") ? std::atof(options["dropout-ms"].c_str()) : 50.0;
+            if (options.count("band") && !ChannelSimulator::parseBand(options["band"], base)) {
+                std::cerr << "Error: Invalid band '" << options["band"] << "' (expected LO-HI in Hz)" << std::endl;
+                return 1;
+            }
+            if (options.count("snr")) {
+                std::string list = options["snr"];
+                size_t start = 0;
+                while (start <= list.size()) {
+                    size_t comma = std::min(list.find(',', start), list.size());
+                    std::string value = list.substr(start, comma - start);
+                    ChannelSimulator::Conditions c = base;
+                    c.name = "custom_snr" + value;
+                    c.snrDb = std::atof(value.c_str());
+                    conditions.push_back(c);
+                    start = comma + 1;
+                }
+            } else {
+                conditions.push_back(base);
+            }
+        } else {
+            conditions = ChannelSweep::standardConditions();
+        }
+        
+        std::ofstream summaryFile;
+        if (options.count("summary") && options["summary"] != "-") {
+            summaryFile.open(options["summary"]);
+            if (!summaryFile.is_open()) {
+                std::cerr << "Error: Could not create summary file: " << options["summary"] << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& summaryOut = summaryFile.is_open() ? summaryFile : std::cout;
+        
+        int trials = options.count("trials") ? std::max(1, std::atoi(options["trials"].c_str())) : 3;
+        uint32_t seed = options.count("seed") ? static_cast<uint32_t>(std::strtoul(options["seed"].c_str(), nullptr, 10)) : 1;
+        
+        // Progress and per-trial decoder chatter would swamp the results
+        Console::setQuiet(true);
+        bool prepared = sweep.prepare(encoder, args[1]);
+        std::string errors = Console::takeErrors();
+        if (!prepared) {
+            std::cerr << errors << "Error: Could not encode " << args[1] << std::endl;
+            return 1;
+        }
+        std::cerr << "Simulating " << conditions.size() << " channel conditions, " << trials
+                  << " trials each, " << encoder.getLastResult().audioSeconds << " s of audio per trial" << std::endl;
+        
+        for (const ChannelSimulator::Conditions& c : conditions) {
+            ChannelSweep::Stats stats = sweep.run(c, trials, seed);
+            Console::takeErrors();
+            ChannelSweep::writeJson(stats, summaryOut);
+            std::cerr << "  " << stats.name << ": SER " << stats.symbolErrorRate()
+                      << ", block failures " << stats.blockFailureRate()
+                      << ", CRC pass " << stats.crcPassRate()
+                      << ", goodput " << stats.goodput() << " bit/s" << std::endl;
+        }
+        Console::setQuiet(false);
+        return 0;
+    }
+    
     // Unknown command
     else {
         std::cerr << "Error: Unknown command '" << command << "'" << std::endl;
@@ -0,0 +1,97 @@
+// Compressor: random and structured buffers round-trip, corrupted payloads
+// are rejected or decode to the announced size, and a corrupted original
+// length cannot make the decoder allocate for it.
+
+#include "Compressor.h"
+#include "test.h"
+#include <cstring>
+#include <string>
+
+namespace {
+
+bool roundTrips(const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> packed = Compressor::compress(data.data(), data.size());
+    std::vector<uint8_t> out;
+    return Compressor::decompress(packed.data(), packed.size(), data.size(), out) && out == data;
+}
+
+// Text-like data from a small vocabulary, so matches of every length occur
+std::vector<uint8_t> words(test::Random& random, size_t length) {
+    static const char* WORDS[] = {"the ", "frame ", "symbol ", "decoder ", "\n", "0x", "error ", "=", "  "};
+    std::vector<uint8_t> data;
+    while (data.size() < length) {
+        const char* word = WORDS[random.below(9)];
+        data.insert(data.end(), word, word + std::strlen(word));
+    }
+    data.resize(length);
+    return data;
+}
+
+void testEdgeCases() {
+    CHECK(roundTrips({}));
+    CHECK(roundTrips({0}));
+    CHECK(roundTrips({1, 2}));
+    CHECK(roundTrips(std::vector<uint8_t>(3, 'a')));
+    CHECK(roundTrips(std::vector<uint8_t>(100000, 0)));
+    std::vector<uint8_t> ramp(70000);
+    for (size_t i = 0; i < ramp.size(); i++) ramp[i] = static_cast<uint8_t>(i);
+    CHECK(roundTrips(ramp));
+}
+
+void testRandomBuffers() {
+    test::Random random(16);
+    for (int trial = 0; trial < 3000; trial++) {
+        size_t length = random.below(trial < 2900 ? 2000 : 200000);
+        std::vector<uint8_t> data = trial % 2 ? random.bytes(length) : words(random, length);
+        CHECK(roundTrips(data));
+    }
+}
+
+void testCompresses() {
+    test::Random random(17);
+    std::vector<uint8_t> text = words(random, 50000);
+    CHECK(Compressor::compress(text.data(), text.size()).size() * 2 < text.size());
+}
+
+void testCorruptPayloads() {
+    test::Random random(18);
+    for (int trial = 0; trial < 2000; trial++) {
+        std::vector<uint8_t> data = words(random, 1 + random.below(5000));
+        std::vector<uint8_t> packed = Compressor::compress(data.data(), data.size());
+        int flips = 1 + random.below(4);
+        for (int k = 0; k < flips; k++) {
+            packed[random.below(static_cast<uint32_t>(packed.size()))] ^= static_cast<uint8_t>(1 + random.below(255));
+        }
+        if (trial % 3 == 0) {
+            packed.resize(random.below(static_cast<uint32_t>(packed.size())));
+        }
+        std::vector<uint8_t> out;
+        if (Compressor::decompress(packed.data(), packed.size(), data.size(), out)) {
+            CHECK(out.size() == data.size());
+        }
+    }
+}
+
+void testCorruptLength() {
+    // A valid payload with a huge announced length stops when the input
+    // runs out, without reserving the announced size
+    test::Random random(19);
+    for (size_t length : {size_t(0), size_t(100), size_t(20000)}) {
+        std::vector<uint8_t> data = words(random, length);
+        std::vector<uint8_t> packed = Compressor::compress(data.data(), data.size());
+        std::vector<uint8_t> out;
+        CHECK(!Compressor::decompress(packed.data(), packed.size(), 0xFFFFFFFFu, out));
+        CHECK(out.capacity() < (64u << 20));
+    }
+}
+
+}
+
+int main() {
+    testEdgeCases();
+    testRandomBuffers();
+    testCompresses();
+    testCorruptPayloads();
+    testCorruptLength();
+    return test::finish("compressor_test");
+}
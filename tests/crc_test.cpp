@@ -0,0 +1,70 @@
+// CRC32: the check value, and the accelerated paths (PCLMUL folding where
+// the CPU has it, slice-by-16 otherwise) against a bitwise reference at
+// every length up to 700, several alignments and incremental split points.
+
+#include "ErrorCorrection.h"
+#include "test.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint32_t reference(const uint8_t* data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void testCheckValue() {
+    const char* text = "123456789";
+    CHECK(ErrorCorrection::calculateCRC32(reinterpret_cast<const uint8_t*>(text), 9) == 0xCBF43926);
+    CHECK(ErrorCorrection::calculateCRC32(nullptr, 0) == 0);
+    CHECK(ErrorCorrection::calculateCRC32(std::vector<uint8_t>()) == 0);
+}
+
+void testAgainstReference() {
+    test::Random random(12);
+    std::vector<uint8_t> buffer = random.bytes(700 + 16);
+    for (size_t align : {0, 1, 3, 8, 15}) {
+        for (size_t length = 0; length <= 700; length++) {
+            const uint8_t* data = buffer.data() + align;
+            uint32_t expected = reference(data, length);
+            CHECK(ErrorCorrection::calculateCRC32(data, length) == expected);
+
+            // Split anywhere: the running state carries across calls
+            size_t split = length ? random.below(static_cast<uint32_t>(length + 1)) : 0;
+            uint32_t crc = ErrorCorrection::updateCRC32(ErrorCorrection::CRC32_INIT, data, split);
+            crc = ErrorCorrection::updateCRC32(crc, data + split, length - split);
+            CHECK(ErrorCorrection::finalizeCRC32(crc) == expected);
+        }
+    }
+}
+
+void testLargeBuffer() {
+    test::Random random(13);
+    std::vector<uint8_t> data = random.bytes(1 << 20);
+    uint32_t expected = reference(data.data(), data.size());
+    CHECK(ErrorCorrection::calculateCRC32(data) == expected);
+
+    uint32_t crc = ErrorCorrection::CRC32_INIT;
+    for (size_t pos = 0; pos < data.size();) {
+        size_t chunk = std::min<size_t>(data.size() - pos, 1 + random.below(70000));
+        crc = ErrorCorrection::updateCRC32(crc, data.data() + pos, chunk);
+        pos += chunk;
+    }
+    CHECK(ErrorCorrection::finalizeCRC32(crc) == expected);
+}
+
+}
+
+int main() {
+    testCheckValue();
+    testAgainstReference();
+    testLargeBuffer();
+    return test::finish("crc_test");
+}
@@ -0,0 +1,126 @@
+// Errors-and-erasures decoding: with f flagged (low confidence) symbols and
+// e unflagged errors, every block with 2e + f <= 32 and f <= 16 decodes to
+// the sent codeword, up to 24 errors in all; past capacity a block fails
+// rather than decoding to the wrong data.
+
+#include "ErrorCorrection.h"
+#include "test.h"
+#include <algorithm>
+
+namespace {
+
+const int N = ErrorCorrection::ENCODED_BLOCK_SIZE;
+const int NSYM = ErrorCorrection::RS_NSYM;
+const uint8_t RELIABLE = 60;    // 15 dB
+const uint8_t DOUBTFUL = 4;     // 1 dB, below ErrorCorrection::ERASURE_THRESHOLD
+
+std::vector<uint8_t> codeword(test::Random& random) {
+    std::vector<uint8_t> block = random.bytes(N);
+    ErrorCorrection::encodeBlock(block.data(), block.data() + ErrorCorrection::RS_BLOCK_SIZE);
+    return block;
+}
+
+// Damage a block: flagged symbols get low confidence, and the first
+// wrongFlagged of them are also wrong; errors more are wrong but reliable
+struct Damage {
+    std::vector<uint8_t> block;
+    std::vector<uint8_t> confidence;
+};
+
+Damage damage(test::Random& random, const std::vector<uint8_t>& sent, int flagged, int wrongFlagged, int errors) {
+    Damage d{sent, std::vector<uint8_t>(N, RELIABLE)};
+    std::vector<int> positions(N);
+    for (int i = 0; i < N; i++) positions[i] = i;
+    for (int k = 0; k < flagged + errors; k++) {
+        std::swap(positions[k], positions[k + random.below(N - k)]);
+        int p = positions[k];
+        if (k < flagged) {
+            d.confidence[p] = static_cast<uint8_t>(random.below(DOUBTFUL + 1));
+        }
+        if (k < wrongFlagged || k >= flagged) {
+            d.block[p] ^= static_cast<uint8_t>(1 + random.below(255));
+        }
+    }
+    return d;
+}
+
+void testWithinCapacity() {
+    ErrorCorrection ecc;
+    test::Random random(23);
+    for (int trial = 0; trial < 20000; trial++) {
+        int flagged = random.below(ErrorCorrection::MAX_ERASURES + 1);
+        int wrongFlagged = flagged - random.below(std::min(flagged, 3) + 1);
+        int errors = random.below((NSYM - flagged) / 2 + 1);
+        std::vector<uint8_t> sent = codeword(random);
+        Damage d = damage(random, sent, flagged, wrongFlagged, errors);
+        int erased = -1;
+        int result = ecc.decodeBlock(d.block.data(), N, d.confidence.data(), &erased);
+        CHECK(result >= 0);
+        CHECK(d.block == sent);
+        CHECK(erased >= 0 && erased <= flagged);
+    }
+}
+
+void testCapacityEdge() {
+    // 16 erasures plus 8 errors: 24 wrong symbols, the most a block survives
+    ErrorCorrection ecc;
+    test::Random random(24);
+    for (int trial = 0; trial < 2000; trial++) {
+        std::vector<uint8_t> sent = codeword(random);
+        Damage d = damage(random, sent, 16, 16, 8);
+        int erased = 0;
+        CHECK(ecc.decodeBlock(d.block.data(), N, d.confidence.data(), &erased) >= 0);
+        CHECK(d.block == sent);
+        CHECK(erased == 16);
+    }
+}
+
+void testPastCapacity() {
+    // Never a wrong codeword: either the sent data or a reported failure
+    ErrorCorrection ecc;
+    test::Random random(25);
+    int failed = 0;
+    for (int trial = 0; trial < 20000; trial++) {
+        int flagged = random.below(ErrorCorrection::MAX_ERASURES + 1);
+        int errors = (NSYM - flagged) / 2 + 1 + random.below(4);
+        std::vector<uint8_t> sent = codeword(random);
+        Damage d = damage(random, sent, flagged, flagged, errors);
+        std::vector<uint8_t> before = d.block;
+        if (ecc.decodeBlock(d.block.data(), N, d.confidence.data()) < 0) {
+            failed++;
+            CHECK(d.block == before);
+        } else {
+            CHECK(d.block == sent);
+        }
+    }
+    CHECK(failed > 19000);
+}
+
+void testBufferDecode() {
+    // decode() threads confidence through to each block and reports erasures
+    ErrorCorrection ecc;
+    test::Random random(26);
+    std::vector<uint8_t> data = random.bytes(10 * ErrorCorrection::RS_BLOCK_SIZE);
+    std::vector<uint8_t> encoded = ecc.encode(data);
+    std::vector<uint8_t> confidence(encoded.size(), RELIABLE);
+    for (int b = 0; b < 10; b++) {
+        std::vector<uint8_t> sent(encoded.begin() + b * N, encoded.begin() + (b + 1) * N);
+        Damage d = damage(random, sent, 12, 12, 10);
+        std::copy(d.block.begin(), d.block.end(), encoded.begin() + b * N);
+        std::copy(d.confidence.begin(), d.confidence.end(), confidence.begin() + b * N);
+    }
+    ErrorCorrection::DecodeReport report;
+    CHECK(ecc.decode(encoded, &report, &confidence) == data);
+    CHECK(report.failedBlocks == 0);
+    CHECK(report.erasureBlocks == 10);
+}
+
+}
+
+int main() {
+    testWithinCapacity();
+    testCapacityEdge();
+    testPastCapacity();
+    testBufferDecode();
+    return test::finish("erasure_test");
+}
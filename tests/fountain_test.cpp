@@ -0,0 +1,135 @@
+// Fountain code: the decoder rebuilds the file from any set of a few more
+// than K distinct symbols, whether they are source symbols, repair symbols
+// or a mix: random subsets, a receiver that joins mid-broadcast, and a
+// channel that loses 30% of the symbols.
+
+#include "Fountain.h"
+#include "test.h"
+#include <algorithm>
+
+namespace {
+
+const size_t SYMBOL = 207;
+
+struct Broadcast {
+    std::vector<uint8_t> file;
+    Fountain encoder;
+
+    Broadcast(test::Random& random, uint64_t length)
+        : file(random.bytes(length)), encoder(length, SYMBOL) {
+        encoder.setSource(file.data());
+    }
+
+    std::vector<uint8_t> symbol(uint32_t esi) const {
+        std::vector<uint8_t> out(SYMBOL);
+        encoder.encodeSymbol(esi, out.data());
+        return out;
+    }
+
+    // A fresh decoder fed the given symbols, in order
+    bool decodes(const std::vector<uint32_t>& esis) const {
+        Fountain decoder(file.size(), SYMBOL);
+        for (uint32_t esi : esis) {
+            decoder.addSymbol(esi, symbol(esi).data());
+        }
+        std::vector<uint8_t> out;
+        return decoder.decode(out) && out == file;
+    }
+};
+
+const uint64_t LENGTHS[] = {1, 207, 208, 2000, 10000, 60000, 200000};
+
+void testSystematic() {
+    // Symbols 0..K-1 are the file itself
+    test::Random random(25);
+    for (uint64_t length : LENGTHS) {
+        Broadcast b(random, length);
+        uint32_t K = b.encoder.getSourceSymbols();
+        for (uint32_t esi = 0; esi < K; esi++) {
+            std::vector<uint8_t> s = b.symbol(esi);
+            size_t n = std::min<uint64_t>(SYMBOL, length - static_cast<uint64_t>(esi) * SYMBOL);
+            CHECK(std::equal(s.begin(), s.begin() + n, b.file.begin() + static_cast<size_t>(esi) * SYMBOL));
+            CHECK(std::all_of(s.begin() + n, s.end(), [](uint8_t x) { return x == 0; }));
+        }
+    }
+}
+
+void testRandomSubsets() {
+    test::Random random(26);
+    for (uint64_t length : LENGTHS) {
+        Broadcast b(random, length);
+        uint32_t K = b.encoder.getSourceSymbols();
+        int trials = length > 100000 ? 4 : 20;
+        for (int trial = 0; trial < trials; trial++) {
+            // Distinct ids out of the first 3K, so about a third are source symbols
+            uint32_t count = K + 5 + random.below(16);
+            std::vector<uint32_t> pool(3 * K + 20);
+            for (uint32_t i = 0; i < pool.size(); i++) pool[i] = i;
+            for (uint32_t i = 0; i < count; i++) {
+                std::swap(pool[i], pool[i + random.below(static_cast<uint32_t>(pool.size()) - i)]);
+            }
+            pool.resize(count);
+            CHECK(b.decodes(pool));
+        }
+    }
+}
+
+void testLateJoin() {
+    // Consecutive symbols from a point after the start of the broadcast
+    test::Random random(27);
+    for (uint64_t length : LENGTHS) {
+        Broadcast b(random, length);
+        uint32_t K = b.encoder.getSourceSymbols();
+        for (uint32_t join : {K / 4, K / 2, K - 1, K, 5 * K}) {
+            std::vector<uint32_t> esis;
+            for (uint32_t esi = join; esis.size() < K + 10; esi++) esis.push_back(esi);
+            CHECK(b.decodes(esis));
+        }
+    }
+}
+
+void testLoss() {
+    // 30% of the symbols lost, the rest arriving in order
+    test::Random random(28);
+    for (uint64_t length : LENGTHS) {
+        Broadcast b(random, length);
+        uint32_t K = b.encoder.getSourceSymbols();
+        for (int trial = 0; trial < 5; trial++) {
+            std::vector<uint32_t> esis;
+            for (uint32_t esi = 0; esis.size() < K + 10; esi++) {
+                if (random.below(100) >= 30) esis.push_back(esi);
+            }
+            CHECK(b.decodes(esis));
+        }
+    }
+}
+
+void testTooFew() {
+    // Fewer than K symbols never decode, and duplicates do not count
+    test::Random random(29);
+    Broadcast b(random, 10000);
+    uint32_t K = b.encoder.getSourceSymbols();
+    Fountain decoder(b.file.size(), SYMBOL);
+    for (uint32_t esi = 1; esi < K; esi++) {
+        CHECK(decoder.addSymbol(esi + K, b.symbol(esi + K).data()));
+    }
+    CHECK(!decoder.addSymbol(K + 1, b.symbol(K + 1).data()));
+    std::vector<uint8_t> out;
+    CHECK(!decoder.decode(out));
+    CHECK(decoder.addSymbol(0, b.symbol(0).data()));
+    for (uint32_t esi = 3 * K; esi < 3 * K + 10; esi++) {
+        decoder.addSymbol(esi, b.symbol(esi).data());
+    }
+    CHECK(decoder.decode(out) && out == b.file);
+}
+
+}
+
+int main() {
+    testSystematic();
+    testRandomSubsets();
+    testLateJoin();
+    testLoss();
+    testTooFew();
+    return test::finish("fountain_test");
+}
@@ -0,0 +1,79 @@
+// Interleaver: deinterleave undoes interleave for every depth and for
+// partial groups and codewords, group-at-a-time use matches whole-buffer
+// use, and a burst of B symbols costs each codeword at most ceil(B / depth).
+
+#include "Interleaver.h"
+#include "test.h"
+#include <algorithm>
+
+namespace {
+
+const size_t BLOCK = 255;
+
+void testRoundTrip() {
+    test::Random random(13);
+    for (int depth : {1, 2, 3, 8, 16, 255}) {
+        Interleaver interleaver(depth, BLOCK);
+        for (size_t length : {size_t(0), size_t(1), BLOCK - 1, BLOCK, 3 * BLOCK + 17,
+                              depth * BLOCK, depth * BLOCK + 2 * BLOCK, 5 * depth * BLOCK + 100}) {
+            std::vector<uint8_t> data = random.bytes(length);
+            std::vector<uint8_t> sent = interleaver.interleave(data);
+            CHECK(sent.size() == length);
+            CHECK(interleaver.deinterleave(sent) == data);
+            if (depth > 1 && length >= 2 * BLOCK) {
+                CHECK(sent != data);
+            }
+        }
+    }
+}
+
+void testGroupAtATime() {
+    // The streaming encoder and decoder work one group at a time
+    test::Random random(14);
+    Interleaver interleaver(8, BLOCK);
+    std::vector<uint8_t> data = random.bytes(3 * interleaver.groupBytes() + 4 * BLOCK);
+    std::vector<uint8_t> whole = interleaver.interleave(data);
+    std::vector<uint8_t> pieces(data.size());
+    for (size_t pos = 0; pos < data.size(); pos += interleaver.groupBytes()) {
+        size_t length = std::min(interleaver.groupBytes(), data.size() - pos);
+        interleaver.interleave(data.data() + pos, length, pieces.data() + pos);
+    }
+    CHECK(pieces == whole);
+}
+
+void testBurstSpread() {
+    test::Random random(15);
+    for (int depth : {1, 4, 8, 16}) {
+        Interleaver interleaver(depth, BLOCK);
+        const size_t length = 4 * interleaver.groupBytes();
+        std::vector<uint8_t> data = random.bytes(length);
+        std::vector<uint8_t> sent = interleaver.interleave(data);
+        for (int trial = 0; trial < 200; trial++) {
+            size_t burst = 1 + random.below(200);
+            size_t start = random.below(static_cast<uint32_t>(length - burst));
+            std::vector<uint8_t> received = sent;
+            for (size_t i = start; i < start + burst; i++) {
+                received[i] ^= 0xFF;
+            }
+            std::vector<uint8_t> blocks = interleaver.deinterleave(received);
+            size_t worst = 0;
+            for (size_t b = 0; b < length; b += BLOCK) {
+                size_t errors = 0;
+                for (size_t i = b; i < b + BLOCK; i++) {
+                    errors += blocks[i] != data[i];
+                }
+                worst = std::max(worst, errors);
+            }
+            CHECK(worst <= (burst + depth - 1) / depth);
+        }
+    }
+}
+
+}
+
+int main() {
+    testRoundTrip();
+    testGroupAtATime();
+    testBurstSpread();
+    return test::finish("interleaver_test");
+}
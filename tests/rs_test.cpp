@@ -0,0 +1,111 @@
+// Reed-Solomon (255,223): random patterns of up to 16 symbol errors are
+// corrected with the exact count, shortened blocks included, and the
+// block-parallel encode/decode round-trips whole buffers.
+
+#include "ErrorCorrection.h"
+#include "test.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int N = ErrorCorrection::ENCODED_BLOCK_SIZE;
+const int NSYM = ErrorCorrection::RS_NSYM;
+
+// A codeword of the given length: a full codeword whose leading
+// N - length data bytes are zero, with those bytes left off
+std::vector<uint8_t> codeword(test::Random& random, int length) {
+    std::vector<uint8_t> full(N, 0);
+    std::vector<uint8_t> data = random.bytes(length - NSYM);
+    std::memcpy(&full[N - length], data.data(), data.size());
+    ErrorCorrection::encodeBlock(full.data(), full.data() + ErrorCorrection::RS_BLOCK_SIZE);
+    return std::vector<uint8_t>(full.end() - length, full.end());
+}
+
+// Flip count distinct symbols to a different value
+void corrupt(test::Random& random, std::vector<uint8_t>& block, int count) {
+    std::vector<int> positions(block.size());
+    for (size_t i = 0; i < positions.size(); i++) positions[i] = static_cast<int>(i);
+    for (int k = 0; k < count; k++) {
+        std::swap(positions[k], positions[k + random.below(static_cast<uint32_t>(positions.size() - k))]);
+        block[positions[k]] ^= static_cast<uint8_t>(1 + random.below(255));
+    }
+}
+
+void testCorrectsUpToCapacity() {
+    ErrorCorrection ecc;
+    test::Random random(9);
+    for (int trial = 0; trial < 20000; trial++) {
+        int errors = trial % (NSYM / 2 + 1);
+        std::vector<uint8_t> sent = codeword(random, N);
+        std::vector<uint8_t> block = sent;
+        corrupt(random, block, errors);
+        CHECK(ecc.decodeBlock(block.data(), N) == errors);
+        CHECK(block == sent);
+    }
+}
+
+void testShortenedBlocks() {
+    ErrorCorrection ecc;
+    test::Random random(10);
+    for (int length : {NSYM + 1, NSYM + 2, 100, N - 1}) {
+        for (int trial = 0; trial < 200; trial++) {
+            int errors = std::min(NSYM / 2, trial % (NSYM / 2 + 1));
+            std::vector<uint8_t> sent = codeword(random, length);
+            std::vector<uint8_t> block = sent;
+            corrupt(random, block, std::min(errors, length));
+            CHECK(ecc.decodeBlock(block.data(), length) == std::min(errors, length));
+            CHECK(block == sent);
+        }
+    }
+}
+
+void testBeyondCapacityIsFlagged() {
+    // 17 or more errors: the decoder must never claim a count it cannot
+    // have fixed; a result is either -1 or a valid codeword
+    ErrorCorrection ecc;
+    test::Random random(11);
+    for (int trial = 0; trial < 2000; trial++) {
+        std::vector<uint8_t> block = codeword(random, N);
+        corrupt(random, block, NSYM / 2 + 1 + trial % 8);
+        int result = ecc.decodeBlock(block.data(), N);
+        if (result >= 0) {
+            CHECK(result <= NSYM / 2);
+            CHECK(ecc.decodeBlock(block.data(), N) == 0);
+        }
+    }
+}
+
+void testBufferRoundTrip() {
+    test::Random random(12);
+    for (int threads : {1, 4}) {
+        ErrorCorrection ecc;
+        ecc.setNumThreads(threads);
+        for (size_t size : {size_t(1), size_t(222), size_t(223), size_t(224), size_t(100000)}) {
+            std::vector<uint8_t> data = random.bytes(size);
+            std::vector<uint8_t> encoded = ecc.encode(data);
+            const size_t blocks = (size + ErrorCorrection::RS_BLOCK_SIZE - 1) / ErrorCorrection::RS_BLOCK_SIZE;
+            CHECK(encoded.size() == blocks * N);
+            for (size_t block = 0; block < encoded.size(); block += N) {
+                encoded[block] ^= 0x55;
+            }
+            ErrorCorrection::DecodeReport report;
+            std::vector<uint8_t> decoded = ecc.decode(encoded, &report);
+            CHECK(decoded.size() == blocks * ErrorCorrection::RS_BLOCK_SIZE);
+            decoded.resize(size);
+            CHECK(decoded == data);
+            CHECK(report.failedBlocks == 0);
+            CHECK(report.correctedSymbols == report.corrections.size());
+        }
+    }
+}
+
+}
+
+int main() {
+    testCorrectsUpToCapacity();
+    testShortenedBlocks();
+    testBeyondCapacityIsFlagged();
+    testBufferRoundTrip();
+    return test::finish("rs_test");
+}
@@ -0,0 +1,62 @@
+// Minimal self-checking test support: each test is a program whose exit
+// status is the number of failed checks (capped), so `make test` needs no
+// framework. Randomized tests use a fixed seed and are reproducible.
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* expression) {
+    if (failures()++ < 20) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    }
+}
+
+inline int finish(const char* name) {
+    std::fprintf(stderr, "%s: %s\n", name, failures() ? "FAILED" : "ok");
+    return failures() > 100 ? 100 : failures();
+}
+
+// xorshift32: the same sequence on every platform
+class Random {
+public:
+    explicit Random(uint32_t seed) : state(seed * 2654435761u + 1) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Uniform in [0, n)
+    uint32_t below(uint32_t n) { return static_cast<uint32_t>((static_cast<uint64_t>(next()) * n) >> 32); }
+
+    std::vector<uint8_t> bytes(size_t length) {
+        std::vector<uint8_t> data(length);
+        for (uint8_t& b : data) b = static_cast<uint8_t>(next() >> 24);
+        return data;
+    }
+
+private:
+    uint32_t state;
+};
+
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) test::fail(__FILE__, __LINE__, #condition); \
+    } while (0)
+
+#endif // TEST_H
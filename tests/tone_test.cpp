@@ -0,0 +1,106 @@
+// FSK tone decisions: the folded-FFT tone bank picks the same tone as the
+// Goertzel reference for all 256 tones of every profile, clean and in
+// noise, with the symbol window on time and shifted into its neighbours.
+// Stream headers, read on the standard grid, agree the same way.
+
+#include "AudioModulator.h"
+#include "Console.h"
+#include "test.h"
+#include <cmath>
+
+namespace {
+
+const float NOISE[] = {0.0f, 1.0f, 4.0f};       // Noise RMS; tones peak at 0.7
+
+// Gaussian noise via Box-Muller on the test generator
+void addNoise(std::vector<float>& samples, float rms, test::Random& random) {
+    if (rms == 0.0f) {
+        return;
+    }
+    for (size_t i = 0; i + 1 < samples.size(); i += 2) {
+        double u1 = (random.next() + 1.0) / 4294967297.0;
+        double u2 = random.next() / 4294967296.0;
+        double r = rms * std::sqrt(-2.0 * std::log(u1));
+        samples[i] += static_cast<float>(r * std::cos(2.0 * M_PI * u2));
+        samples[i + 1] += static_cast<float>(r * std::sin(2.0 * M_PI * u2));
+    }
+}
+
+void testProfile(AudioModulator::ModemProfile profile, test::Random& random) {
+    AudioModulator fft;
+    AudioModulator goertzel;
+    fft.setDemodMode(AudioModulator::DEMOD_FFT);
+    goertzel.setDemodMode(AudioModulator::DEMOD_GOERTZEL);
+    fft.setProfile(profile);
+
+    // Every tone once, between random neighbours so shifted windows see data
+    std::vector<uint8_t> data = random.bytes(258);
+    for (int tone = 0; tone < 256; tone++) data[tone + 1] = static_cast<uint8_t>(tone);
+    const long length = fft.symbolSamples(AudioModulator::MOD_FSK, profile);
+    const long offsets[] = {0, length / 8, -length / 5};
+
+    // The clean, on-time condition checks every tone; the Goertzel
+    // reference is slow, so each other condition checks every eighth
+    int condition = 0;
+    for (float rms : NOISE) {
+        std::vector<float> samples(fft.maxSymbolSamples(data.size()));
+        fft.writeSymbols(data.data(), data.size(), samples.data());
+        addNoise(samples, rms, random);
+        for (long offset : offsets) {
+            const int step = condition == 0 ? 1 : 8;
+            for (int tone = condition++ % step; tone < 256; tone += step) {
+                size_t pos = (tone + 1) * length + offset;
+                uint8_t a = 0, b = 0;
+                fft.readDataSymbol(samples, pos, AudioModulator::MOD_FSK, profile, &a);
+                goertzel.readDataSymbol(samples, pos, AudioModulator::MOD_FSK, profile, &b);
+                CHECK(a == b);
+                if (rms == 0.0f && offset == 0) {
+                    CHECK(a == tone);
+                }
+            }
+        }
+    }
+}
+
+void testHeader(test::Random& random) {
+    AudioModulator fft;
+    AudioModulator goertzel;
+    fft.setDemodMode(AudioModulator::DEMOD_FFT);
+    goertzel.setDemodMode(AudioModulator::DEMOD_GOERTZEL);
+
+    for (float rms : NOISE) {
+        for (int trial = 0; trial < 8; trial++) {
+            AudioModulator::StreamHeader sent;
+            sent.dataLength = random.next() >> random.below(32);
+            sent.interleaveDepth = 1 + random.below(255);
+            fft.setProfile(static_cast<AudioModulator::ModemProfile>(random.below(AudioModulator::PROFILE_COUNT)));
+            std::vector<float> samples(fft.headerSamples());
+            fft.writeHeader(sent, samples.data());
+            addNoise(samples, rms, random);
+
+            const long pos = fft.trailerSamples();
+            AudioModulator::StreamHeader a, b;
+            long endA = fft.readStreamHeader(samples, pos, AudioModulator::SYNC_CHIRP, a);
+            long endB = goertzel.readStreamHeader(samples, pos, AudioModulator::SYNC_CHIRP, b);
+            CHECK(endA == endB);
+            CHECK(a.dataLength == b.dataLength && a.interleaveDepth == b.interleaveDepth);
+            CHECK(a.profile == b.profile && a.version == b.version);
+            if (rms == 0.0f) {
+                CHECK(endA == (long)samples.size());
+                CHECK(a.dataLength == sent.dataLength && a.profile == fft.getProfile());
+            }
+        }
+    }
+}
+
+}
+
+int main() {
+    Console::setQuiet(true);
+    test::Random random(1);
+    for (int p = 0; p < AudioModulator::PROFILE_COUNT; p++) {
+        testProfile(static_cast<AudioModulator::ModemProfile>(p), random);
+    }
+    testHeader(random);
+    return test::finish("tone_test");
+}
@@ -0,0 +1,140 @@
+// WAV output formats: every format write() produces reads back through
+// the mapped reader and the streaming reader, also as headerless raw PCM,
+// and a fountain broadcast in each format decodes back to the file it was
+// made from.
+
+#include "AudioDecoder.h"
+#include "AudioEncoder.h"
+#include "Console.h"
+#include "WavFile.h"
+#include "test.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+struct Format {
+    const char* name;
+    WavFile::SampleFormat format;
+    float tolerance;            // Two quantization steps: writes truncate, and scale by 2^n - 1
+};
+
+const Format FORMATS[] = {
+    {"pcm16", WavFile::FORMAT_INT16, 2.0f / 32768.0f},
+    {"pcm24", WavFile::FORMAT_INT24, 2.0f / 8388608.0f},
+    {"float", WavFile::FORMAT_FLOAT32, 0.0f},
+};
+
+std::filesystem::path scratch() {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "wav_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+bool near(const std::vector<float>& a, const std::vector<float>& b, float tolerance) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::fabs(a[i] - b[i]) > tolerance * 1.01f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testSamples(const std::filesystem::path& dir) {
+    test::Random random(8);
+    std::vector<float> samples(100003);
+    for (float& s : samples) s = (static_cast<float>(random.next()) / 4294967296.0f) * 1.8f - 0.9f;
+    for (const Format& f : FORMATS) {
+        for (int channels : {1, 2}) {
+            std::string path = (dir / (std::string(f.name) + ".wav")).string();
+            std::vector<float> written(samples.begin(), samples.end() - (samples.size() % channels));
+            WavFile writer;
+            writer.setVerbose(false);
+            CHECK(writer.setOutputFormat(f.format));
+            CHECK(writer.write(path, written, 48000, channels));
+            
+            WavFile reader;
+            reader.setVerbose(false);
+            std::vector<float> mapped;
+            int rate = 0;
+            int count = 0;
+            CHECK(reader.read(path, mapped, rate, count));
+            CHECK(rate == 48000 && count == channels);
+            CHECK(near(mapped, written, f.tolerance));
+            
+            // Odd read sizes leave partial samples between reads
+            std::vector<float> streamed;
+            rate = 44100;
+            count = 1;
+            CHECK(reader.beginRead(path, rate, count));
+            CHECK(rate == 48000 && count == channels);
+            std::vector<float> buffer(1001);
+            long n;
+            while ((n = reader.readSamples(buffer.data(), buffer.size())) > 0) {
+                streamed.insert(streamed.end(), buffer.begin(), buffer.begin() + n);
+            }
+            reader.endRead();
+            CHECK(n == 0);
+            CHECK(streamed == mapped);
+            
+            // The same samples without the 44-byte header, as raw "-" output carries them
+            std::ifstream wav(path, std::ios::binary);
+            std::vector<char> bytes((std::istreambuf_iterator<char>(wav)), std::istreambuf_iterator<char>());
+            std::string raw = (dir / (std::string(f.name) + ".raw")).string();
+            std::ofstream(raw, std::ios::binary).write(bytes.data() + 44, bytes.size() - 44);
+            std::vector<float> rawRead;
+            rate = 48000;
+            count = channels;
+            reader.setRawFormat(f.format);
+            CHECK(reader.beginRead(raw, rate, count));
+            while ((n = reader.readSamples(buffer.data(), buffer.size())) > 0) {
+                rawRead.insert(rawRead.end(), buffer.begin(), buffer.begin() + n);
+            }
+            reader.endRead();
+            CHECK(rawRead == mapped);
+        }
+    }
+}
+
+void testFountain(const std::filesystem::path& dir) {
+    test::Random random(25);
+    std::vector<uint8_t> file = random.bytes(1500);
+    std::string input = (dir / "notice.bin").string();
+    std::ofstream(input, std::ios::binary).write(reinterpret_cast<const char*>(file.data()), file.size());
+    for (const Format& f : FORMATS) {
+        std::string wav = (dir / (std::string("fountain_") + f.name + ".wav")).string();
+        std::filesystem::path out = dir / f.name;
+        std::filesystem::create_directories(out);
+        
+        AudioEncoder encoder;
+        encoder.setVerbose(false);
+        encoder.setModulation(AudioModulator::MOD_OFDM);
+        encoder.setFountain(true);
+        CHECK(encoder.setOutputFormat(f.format));
+        CHECK(encoder.encodeFile(input, wav));
+        
+        AudioDecoder decoder;
+        decoder.setVerbose(false);
+        CHECK(decoder.decodeFile(wav, out.string()));
+        std::ifstream in(out / "notice.bin", std::ios::binary);
+        std::vector<uint8_t> decoded((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        CHECK(decoded == file);
+        CHECK(decoder.getLastResult().crcMatches);
+    }
+}
+
+}
+
+int main() {
+    Console::setQuiet(true);
+    std::filesystem::path dir = scratch();
+    testSamples(dir);
+    testFountain(dir);
+    std::filesystem::remove_all(dir);
+    return test::finish("wav_test");
+}